@@ -17,11 +17,18 @@
 
 #include "LCUtility/KDTreeLinkerAlgoT.h"
 
+#include <memory>
 #include <unordered_map>
+#include <vector>
 
 namespace lc_content
 {
 
+class CaloHitSpatialIndex;
+class ParallelFor;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  ConeClusteringAlgorithm class
  */
@@ -33,8 +40,14 @@ public:
      */
     ConeClusteringAlgorithm();
 
+    /**
+     *  @brief Destructor
+     */
+    ~ConeClusteringAlgorithm();
+
 private:
     pandora::StatusCode Run();
+    pandora::StatusCode Reset();
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
     /**
@@ -52,20 +65,22 @@ private:
      */
     pandora::StatusCode SeedClustersWithTracks(const pandora::TrackList *const pTrackList, pandora::ClusterVector &clusterVector);
 
-    typedef std::unordered_map<const pandora::Cluster*, const pandora::ClusterFitResult> ClusterFitResultMap;
-    typedef KDTreeLinkerAlgo<const pandora::CaloHit*, 4> HitKDTree;
+    typedef std::unordered_map<const pandora::Cluster*, pandora::ClusterFitResult> ClusterFitResultMap;
+    typedef std::unordered_map<const pandora::Cluster*, unsigned int> ClusterToNCaloHitsMap;
     typedef KDTreeNodeInfoT<const pandora::CaloHit*, 4> HitKDNode;
     typedef KDTreeLinkerAlgo<const pandora::Track*, 3> TrackKDTree;
     typedef KDTreeNodeInfoT<const pandora::Track*, 3> TrackKDNode;
 
     /**
      *  @brief  Update the properties of the current clusters, calculating their current directions and storing the fit results
-     *          in a provided map
+     *          in a provided map. Only clusters that are new, or whose number of hits has changed since their last fit, are refitted
      * 
      *  @param  clusterVector vector containing addresses of current clusters
-     *  @param  clusterFitResultMap to receive the populated cluster fit result map
+     *  @param  clusterFitNCaloHitsMap the number of hits in each cluster at the time of its last fit, to be updated
+     *  @param  clusterFitResultMap the cluster fit result map, to be updated
      */
-    pandora::StatusCode GetCurrentClusterFitResults(const pandora::ClusterVector &clusterVector, ClusterFitResultMap &clusterFitResultMap) const;
+    pandora::StatusCode GetCurrentClusterFitResults(const pandora::ClusterVector &clusterVector, ClusterToNCaloHitsMap &clusterFitNCaloHitsMap,
+        ClusterFitResultMap &clusterFitResultMap) const;
 
     /**
      *  @brief  Match clusters to calo hits in previous pseudo layers
@@ -78,6 +93,119 @@ private:
     pandora::StatusCode FindHitsInPreviousLayers(unsigned int pseudoLayer, const pandora::CaloHitVector &relevantCaloHits,
         const ClusterFitResultMap &clusterFitResultMap, pandora::ClusterVector &clusterVector);
 
+    /**
+     *  @brief  HitAssociation class, the best cluster found for a calo hit by a search of previous pseudo layers
+     */
+    class HitAssociation
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        HitAssociation();
+
+        const pandora::Cluster *m_pBestCluster;         ///< Address of the best cluster, null if no cluster is found
+        pandora::ClusterVector  m_candidateClusters;    ///< The clusters examined by the search, ordered by address
+        pandora::StatusCode     m_statusCode;           ///< The status code returned by the search
+    };
+
+    typedef std::vector<HitAssociation> HitAssociationVector;
+
+    /**
+     *  @brief  SearchBuffers class, storage reused by all the kd-tree searches made by a single thread while matching hits to clusters
+     */
+    class SearchBuffers
+    {
+    public:
+        std::vector<HitKDNode>               m_foundHits;           ///< The results of a hit kd-tree search
+        std::vector<TrackKDNode>             m_foundTracks;         ///< The results of a track kd-tree search
+        pandora::ClusterVector               m_nearbyClusters;      ///< The clusters nominated by the kd-tree searches, ordered by address
+        pandora::ClusterVector               m_candidateClusters;   ///< The clusters examined for a single hit, ordered by address
+        std::vector<unsigned int>            m_availableHitIndices; ///< The indices of the hits in a layer still available for clustering
+        std::vector<const pandora::Track*>   m_nearbyTracks;        ///< The tracks found near each hit in a layer, stored contiguously
+        std::vector<unsigned int>            m_nearbyTrackOffsets;  ///< The offsets of the tracks found near each hit in a layer
+        std::vector<const pandora::CaloHit*> m_nearbyHits;          ///< The hits found near each hit in a layer, stored contiguously
+        std::vector<unsigned int>            m_nearbyHitOffsets;    ///< The offsets of the hits found near each hit in a layer
+    };
+
+    typedef std::vector<SearchBuffers> SearchBuffersVector;
+
+    /**
+     *  @brief  Match clusters to calo hits in previous pseudo layers, searching for the best cluster for each calo hit in parallel, then
+     *          adding the calo hits to the clusters in their original order. A calo hit is searched again, serially, if any cluster examined
+     *          by its parallel search has since gained a calo hit, so the associations are identical to those of a single, serial pass
+     * 
+     *  @param  pseudoLayer the current pseudo layer
+     *  @param  relevantCaloHits the calo hits in the current pseudo layer
+     *  @param  clusterFitResultMap containing the current cluster fit results
+     *  @param  clusterVector vector containing addresses of current clusters
+     *  @param  nThreads the number of threads to use
+     */
+    pandora::StatusCode FindHitsInPreviousLayersMultiThreaded(unsigned int pseudoLayer, const pandora::CaloHitVector &relevantCaloHits,
+        const ClusterFitResultMap &clusterFitResultMap, const pandora::ClusterVector &clusterVector, const unsigned int nThreads);
+
+    /**
+     *  @brief  Find the best clusters in previous pseudo layers for a contiguous range of calo hits
+     * 
+     *  @param  pseudoLayer the current pseudo layer
+     *  @param  caloHits the calo hits in the current pseudo layer
+     *  @param  clusterFitResultMap containing the current cluster fit results
+     *  @param  firstHitIndex the index of the first calo hit in the range
+     *  @param  endHitIndex the index one past the last calo hit in the range
+     *  @param  rangeIndex the index of the range, which selects the search buffers to use
+     *  @param  searchBuffersVector the search buffers, one set for each range
+     *  @param  hitAssociations to receive the hit associations, indexed as the calo hits
+     */
+    void FindBestClustersInPreviousLayers(const unsigned int pseudoLayer, const pandora::CaloHitVector &caloHits,
+        const ClusterFitResultMap &clusterFitResultMap, const unsigned int firstHitIndex, const unsigned int endHitIndex,
+        const unsigned int rangeIndex, SearchBuffersVector &searchBuffersVector, HitAssociationVector &hitAssociations) const;
+
+    /**
+     *  @brief  Find the best cluster in previous pseudo layers with which to associate a calo hit
+     * 
+     *  @param  pseudoLayer the current pseudo layer
+     *  @param  pCaloHit address of the calo hit
+     *  @param  clusterFitResultMap containing the current cluster fit results
+     *  @param  searchBuffers the search buffers reserved for use by the calling thread
+     *  @param  pBestCluster to receive the address of the best cluster, null if no cluster is found
+     *  @param  candidateClusters to receive the clusters examined, ordered by address; the choice depends upon no other cluster
+     */
+    pandora::StatusCode FindBestClusterInPreviousLayers(const unsigned int pseudoLayer, const pandora::CaloHit *const pCaloHit,
+        const ClusterFitResultMap &clusterFitResultMap, SearchBuffers &searchBuffers, const pandora::Cluster *&pBestCluster,
+        pandora::ClusterVector &candidateClusters) const;
+
+    /**
+     *  @brief  Add a cluster to the list of nearby clusters, if not already present
+     * 
+     *  @param  pCluster address of the cluster
+     *  @param  nearbyClusters the nearby clusters, ordered by address
+     */
+    void AddNearbyCluster(const pandora::Cluster *const pCluster, pandora::ClusterVector &nearbyClusters) const;
+
+    /**
+     *  @brief  Update the choice of best cluster with which to associate a calo hit, given a list of nearby clusters. The choice does not
+     *          depend upon the order of the list: complete ties are resolved using SortingHelper::SortClustersByNHits
+     * 
+     *  @param  pCaloHit address of the calo hit
+     *  @param  searchLayer the pseudolayer currently being examined
+     *  @param  clusterFitResultMap containing the current cluster fit results
+     *  @param  nearbyClusters the nearby clusters
+     *  @param  pBestCluster the address of the best cluster so far, to be updated
+     *  @param  bestClusterEnergy the hadronic energy of the best cluster so far, to be updated
+     *  @param  smallestGenericDistance the generic distance to the best cluster so far, to be updated
+     */
+    pandora::StatusCode FindBestNearbyCluster(const pandora::CaloHit *const pCaloHit, const unsigned int searchLayer,
+        const ClusterFitResultMap &clusterFitResultMap, const pandora::ClusterVector &nearbyClusters, const pandora::Cluster *&pBestCluster,
+        float &bestClusterEnergy, float &smallestGenericDistance) const;
+
+    /**
+     *  @brief  Add a calo hit to the best cluster found in previous pseudo layers, if permitted by the cluster formation strategy
+     * 
+     *  @param  pCaloHit address of the calo hit
+     *  @param  pBestCluster address of the best cluster, may be null
+     */
+    pandora::StatusCode AddToBestCluster(const pandora::CaloHit *const pCaloHit, const pandora::Cluster *const pBestCluster);
+
     /**
      *  @brief  Match clusters to calo hits in current pseudo layer
      * 
@@ -171,16 +299,20 @@ private:
     TrackKDTree m_tracksKdTree;
 
     /**
-     *  @brief  kd-tree containing all rechits given to the clusterizer
+     *  @brief  shared spatial index of all rechits given to the clusterizer, held until Reset, at the end of the event
      */
-    std::vector<HitKDNode> m_hitNodes;
-    HitKDTree m_hitsKdTree;
+    std::shared_ptr<const CaloHitSpatialIndex> m_spHitsSpatialIndex;
 
     /**
      *  @brief  hashtable to look up hits in clusters
      */
     std::unordered_map<const pandora::CaloHit*, const pandora::Cluster*> m_hitsToClusters;
 
+    /**
+     *  @brief  search buffers, one per thread, reused throughout Run
+     */
+    SearchBuffersVector m_searchBuffers;
+
     /**
      *  @brief  hashtable to look up hits in clusters
      */
@@ -235,6 +367,10 @@ private:
 
     float           m_mipTrackChi2Cut;              ///< Max value of fit chi2 for track seeded cluster to retain its IsMipTrack status
 
+    unsigned int    m_nThreads;                     ///< Max number of threads to use when matching clusters to hits in previous layers
+    unsigned int    m_minHitsPerThread;             ///< Min number of hits in a layer per thread used when matching to previous layers
+    ParallelFor    *m_pParallelFor;                 ///< The worker pool, sized by the number of threads, reused between layers
+
     unsigned int    m_firstLayer;                   ///< cache the pseudo layer at IP
 };
 
@@ -12,11 +12,19 @@
 
 #include "LCHelpers/FragmentRemovalHelper.h"
 
+#include "LCUtility/HelixTrajectory.h"
+
 #include <map>
+#include <set>
+#include <unordered_map>
 
 namespace lc_content
 {
 
+class ParallelFor;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  ChargedClusterContact class, describing the interactions and proximity between parent and daughter candidate clusters
  */
@@ -46,9 +54,10 @@ public:
      *  @param  pDaughterCluster address of the daughter candidate cluster
      *  @param  pParentCluster address of the parent candidate cluster
      *  @param  parameters the cluster contact parameters
+     *  @param  trackToHelixTrajectoryMap the helix trajectories of the tracks associated with the parent candidate cluster
      */
     ChargedClusterContact(const pandora::Pandora &pandora, const pandora::Cluster *const pDaughterCluster,
-        const pandora::Cluster *const pParentCluster, const Parameters &parameters);
+        const pandora::Cluster *const pParentCluster, const Parameters &parameters, const TrackToHelixTrajectoryMap &trackToHelixTrajectoryMap);
 
     /**
      *  @brief  Get the sum of energies of tracks associated with parent cluster
@@ -89,13 +98,13 @@ private:
     /**
      *  @brief  Compare daughter cluster with helix fits to parent associated tracks
      * 
-     *  @param  pandora the associated pandora instance
      *  @param  pDaughterCluster address of the daughter candidate cluster
      *  @param  pParentCluster address of the parent candidate cluster
      *  @param  parameters the cluster contact parameters
+     *  @param  trackToHelixTrajectoryMap the helix trajectories of the tracks associated with the parent candidate cluster
      */
-    void ClusterHelixComparison(const pandora::Pandora &pandora, const pandora::Cluster *const pDaughterCluster,
-        const pandora::Cluster *const pParentCluster, const Parameters &parameters);
+    void ClusterHelixComparison(const pandora::Cluster *const pDaughterCluster, const pandora::Cluster *const pParentCluster,
+        const Parameters &parameters, const TrackToHelixTrajectoryMap &trackToHelixTrajectoryMap);
 
     float               m_parentTrackEnergy;            ///< Sum of energies of tracks associated with parent cluster
     float               m_coneFraction2;                ///< Fraction of daughter hits that lie within specified cone 2 along parent direction
@@ -121,21 +130,148 @@ public:
      */
     MainFragmentRemovalAlgorithm();
 
+    /**
+     *  @brief Destructor
+     */
+    ~MainFragmentRemovalAlgorithm();
+
 private:
+    /**
+     *  @brief  MergeCandidate class, describing the best parent candidate cluster for a given daughter candidate cluster
+     */
+    class MergeCandidate
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         * 
+         *  @param  pDaughterCluster address of the daughter candidate cluster
+         *  @param  pParentCluster address of the parent candidate cluster
+         *  @param  excessEvidence the excess of the total evidence over the required evidence for the merge
+         *  @param  parentEnergy the hadronic energy of the parent candidate cluster
+         */
+        MergeCandidate(const pandora::Cluster *const pDaughterCluster, const pandora::Cluster *const pParentCluster, const float excessEvidence,
+            const float parentEnergy);
+
+        /**
+         *  @brief  Get the address of the daughter candidate cluster
+         * 
+         *  @return The address of the daughter candidate cluster
+         */
+        const pandora::Cluster *GetDaughterCluster() const;
+
+        /**
+         *  @brief  Get the address of the parent candidate cluster
+         * 
+         *  @return The address of the parent candidate cluster
+         */
+        const pandora::Cluster *GetParentCluster() const;
+
+        /**
+         *  @brief  Operator< to order by decreasing excess evidence, then decreasing parent energy, then by daughter cluster, using the
+         *          keys of SortingHelper::SortClustersByNHits compared exactly, ending with the first daughter calo hit
+         * 
+         *  @param  rhs merge candidate to compare with
+         */
+        bool operator< (const MergeCandidate &rhs) const;
+
+    private:
+        const pandora::Cluster *m_pDaughterCluster;         ///< Address of the daughter candidate cluster
+        const pandora::Cluster *m_pParentCluster;           ///< Address of the parent candidate cluster
+        float                   m_excessEvidence;           ///< The excess of the total evidence over the required evidence for the merge
+        float                   m_parentEnergy;             ///< The hadronic energy of the parent candidate cluster
+        unsigned int            m_daughterNCaloHits;        ///< The number of calo hits in the daughter candidate cluster, on creation
+        float                   m_daughterEnergy;           ///< The hadronic energy of the daughter candidate cluster, on creation
+        float                   m_daughterIsolatedEnergy;   ///< The isolated hadronic energy of the daughter candidate cluster, on creation
+        const pandora::CaloHit *m_pDaughterFirstCaloHit;    ///< The first calo hit in the daughter candidate cluster, on creation
+    };
+
+    typedef std::set<MergeCandidate> MergeCandidateQueue;
+    typedef std::unordered_map<const pandora::Cluster *, MergeCandidateQueue::const_iterator> MergeCandidateLocationMap;
+
+    /**
+     *  @brief  ContactCalculation class, the cluster contacts calculated by a single thread for a contiguous range of cluster pairs
+     */
+    class ContactCalculation
+    {
+    public:
+        ChargedClusterContactVector m_chargedClusterContactVector;  ///< The contacts passing the contact cuts, in cluster pair order
+    };
+
+    typedef std::vector<ContactCalculation> ContactCalculationVector;
+    typedef std::pair<const pandora::Cluster *, const pandora::Cluster *> ClusterPair;
+    typedef std::vector<ClusterPair> ClusterPairVector;
+
     pandora::StatusCode Run();
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
+    /**
+     *  @brief  Whether a cluster is excluded from fragment removal, as a muon or electron candidate
+     * 
+     *  @param  pCluster address of the cluster
+     * 
+     *  @return boolean
+     */
+    bool IsExcludedCluster(const pandora::Cluster *const pCluster) const;
+
+    /**
+     *  @brief  Fit a helix to each track associated with a current cluster, to be shared, with its memoized extrapolation results, by all
+     *          the cluster contacts evaluated during the event
+     */
+    pandora::StatusCode MakeTrackHelixTrajectories();
+
     /**
      *  @brief  Get cluster contact map, linking each daughter candidate cluster to a list of parent candidates and describing
      *          the proximity/contact between each pairing
      * 
-     *  @param  isFirstPass whether this is the first call to GetChargedClusterContactMap
-     *  @param  affectedClusters list of those clusters affected by previous cluster merging, for which contact details must be updated
      *  @param  chargedClusterContactMap to receive the populated cluster contact map
      */
-    pandora::StatusCode GetChargedClusterContactMap(bool &isFirstPass, const pandora::ClusterSet &affectedClusters,
+    pandora::StatusCode GetChargedClusterContactMap(ChargedClusterContactMap &chargedClusterContactMap) const;
+
+    /**
+     *  @brief  Update the cluster contact map after a merge, recalculating the contacts between the affected daughter candidate
+     *          clusters and the modified parent cluster. Contacts with all other parent candidates are unchanged by the merge.
+     * 
+     *  @param  pParentCluster address of the parent cluster modified by the merge
+     *  @param  affectedClusters list of those clusters affected by the merge
+     *  @param  chargedClusterContactMap the cluster contact map to update
+     */
+    pandora::StatusCode UpdateChargedClusterContactMap(const pandora::Cluster *const pParentCluster, const pandora::ClusterSet &affectedClusters,
         ChargedClusterContactMap &chargedClusterContactMap) const;
 
+    /**
+     *  @brief  Calculate the contacts for a list of (daughter, parent) candidate cluster pairs, sharing the work between threads
+     *          if configured to do so
+     * 
+     *  @param  clusterPairVector the list of (daughter, parent) candidate cluster pairs
+     *  @param  chargedClusterContactVector to receive the contacts passing the contact cuts, in cluster pair order
+     */
+    pandora::StatusCode GetChargedClusterContacts(const ClusterPairVector &clusterPairVector,
+        ChargedClusterContactVector &chargedClusterContactVector) const;
+
+    /**
+     *  @brief  Calculate the contacts for a contiguous range of (daughter, parent) candidate cluster pairs
+     * 
+     *  @param  clusterPairVector the list of (daughter, parent) candidate cluster pairs
+     *  @param  firstPairIndex the index of the first cluster pair in the range
+     *  @param  endPairIndex the index one past the last cluster pair in the range
+     *  @param  rangeIndex the index of the range
+     *  @param  contactCalculations to receive, at the range index, the contacts passing the contact cuts
+     */
+    void CalculateChargedClusterContacts(const ClusterPairVector &clusterPairVector, const unsigned int firstPairIndex,
+        const unsigned int endPairIndex, const unsigned int rangeIndex, ContactCalculationVector &contactCalculations) const;
+
+    /**
+     *  @brief  Re-evaluate the best merge candidate for a daughter candidate cluster, replacing any existing entry in the queue
+     * 
+     *  @param  pDaughterCluster address of the daughter candidate cluster
+     *  @param  chargedClusterContactMap the cluster contact map
+     *  @param  mergeCandidateQueue the queue of merge candidates, ordered by decreasing evidence
+     *  @param  mergeCandidateLocationMap the location of the queue entry for each daughter candidate cluster
+     */
+    void UpdateMergeCandidate(const pandora::Cluster *const pDaughterCluster, const ChargedClusterContactMap &chargedClusterContactMap,
+        MergeCandidateQueue &mergeCandidateQueue, MergeCandidateLocationMap &mergeCandidateLocationMap);
+
     /**
      *  @brief  Whether candidate parent and daughter clusters are sufficiently in contact to warrant further investigation
      * 
@@ -146,14 +282,17 @@ private:
     bool PassesClusterContactCuts(const ChargedClusterContact &chargedClusterContact) const;
 
     /**
-     *  @brief  Find the best candidate parent and daughter clusters for fragment removal merging
+     *  @brief  Find the best candidate parent cluster for fragment removal merging with a given daughter candidate cluster
      * 
-     *  @param  chargedClusterContactMap the populated cluster contact map
+     *  @param  pDaughterCluster address of the daughter candidate cluster
+     *  @param  chargedClusterContactVector list cluster contact details for the given daughter cluster
      *  @param  pBestParentCluster to receive the address of the best parent cluster candidate
-     *  @param  pBestDaughterCluster to receive the address of the best daughter cluster candidate
+     *  @param  highestExcessEvidence to receive the excess evidence for merging with the best parent cluster candidate
+     *  @param  highestEvidenceParentEnergy to receive the hadronic energy of the best parent cluster candidate
      */
-    pandora::StatusCode GetClusterMergingCandidates(const ChargedClusterContactMap &chargedClusterContactMap, const pandora::Cluster *&pBestParentCluster,
-        const pandora::Cluster *&pBestDaughterCluster);
+    pandora::StatusCode GetClusterMergingCandidate(const pandora::Cluster *const pDaughterCluster,
+        const ChargedClusterContactVector &chargedClusterContactVector, const pandora::Cluster *&pBestParentCluster, float &highestExcessEvidence,
+        float &highestEvidenceParentEnergy);
 
     /**
      *  @brief  Whether the candidate parent and daughter clusters pass quick preselection for fragment removal merging
@@ -310,10 +449,46 @@ private:
     float               m_photonCorrection7;                        ///< Photon correction contribution 7
 
     float               m_minRequiredEvidence;                      ///< Minimum required evidence to merge parent/daughter clusters
+
+    unsigned int        m_nThreads;                                 ///< Max number of threads used to calculate cluster contacts
+    unsigned int        m_minPairsPerThread;                        ///< Min number of cluster pairs for each thread calculating contacts
+    ParallelFor        *m_pParallelFor;                             ///< The worker pool, sized by the number of threads, reused by calls
+
+    TrackToHelixTrajectoryMap   m_trackToHelixTrajectoryMap;        ///< The helix trajectories of the cluster associated tracks, held during Run
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+inline MainFragmentRemovalAlgorithm::MergeCandidate::MergeCandidate(const pandora::Cluster *const pDaughterCluster,
+        const pandora::Cluster *const pParentCluster, const float excessEvidence, const float parentEnergy) :
+    m_pDaughterCluster(pDaughterCluster),
+    m_pParentCluster(pParentCluster),
+    m_excessEvidence(excessEvidence),
+    m_parentEnergy(parentEnergy),
+    m_daughterNCaloHits(pDaughterCluster->GetNCaloHits()),
+    m_daughterEnergy(pDaughterCluster->GetHadronicEnergy()),
+    m_daughterIsolatedEnergy(pDaughterCluster->GetIsolatedHadronicEnergy()),
+    m_pDaughterFirstCaloHit((pDaughterCluster->GetNCaloHits() > 0) ? pDaughterCluster->GetOrderedCaloHitList().begin()->second->front() :
+        nullptr)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const pandora::Cluster *MainFragmentRemovalAlgorithm::MergeCandidate::GetDaughterCluster() const
+{
+    return m_pDaughterCluster;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const pandora::Cluster *MainFragmentRemovalAlgorithm::MergeCandidate::GetParentCluster() const
+{
+    return m_pParentCluster;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 inline float ChargedClusterContact::GetParentTrackEnergy() const
 {
     return m_parentTrackEnergy;
@@ -11,6 +11,9 @@
 #include "Pandora/PandoraInputTypes.h"
 #include "Pandora/PandoraInternal.h"
 
+#include <utility>
+#include <vector>
+
 namespace pandora { class ClusterFitResult; }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -18,6 +21,10 @@ namespace pandora { class ClusterFitResult; }
 namespace lc_content
 {
 
+class ClusterHitPositions;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  ClusterHelper class
  */
@@ -57,6 +64,18 @@ public:
      */
     static float GetDistanceToClosestHit(const pandora::Cluster *const pClusterI, const pandora::Cluster *const pClusterJ);
 
+    /**
+     *  @brief  Get smallest distance between pairs of hits in two clusters, giving up as soon as it is clear that no pair of hits lies
+     *          within a specified distance
+     * 
+     *  @param  pClusterI address of the first cluster
+     *  @param  pClusterJ address of the second cluster
+     *  @param  maxDistance the max distance of interest
+     * 
+     *  @return the smallest distance, if no greater than the max distance of interest, otherwise a value greater than the max distance
+     */
+    static float GetDistanceToClosestHit(const pandora::Cluster *const pClusterI, const pandora::Cluster *const pClusterJ, const float maxDistance);
+
     /**
      *  @brief  Get closest distance of approach between projected cluster fit result and layer centroid position of a second cluster
      * 
@@ -105,6 +124,21 @@ public:
     static pandora::StatusCode GetTrackClusterDistance(const T *const pT, const pandora::Cluster *const pCluster,
         const unsigned int maxSearchLayer, const float parallelDistanceCut, const float minTrackClusterCosAngle, float &trackClusterDistance);
 
+    /**
+     *  @brief  Get the distance of closest approach between the projected direction of a track state and the hits within a cluster, using
+     *          positions already copied from the cluster to evaluate all hit distances in a single pass. Note that only a specified number
+     *          of layers are examined.
+     * 
+     *  @param  pTrackState address of the track state
+     *  @param  clusterHitPositions the hit positions of the cluster, copied up to at least the maximum pseudolayer to examine
+     *  @param  maxSearchLayer the maximum pseudolayer to examine
+     *  @param  parallelDistanceCut maximum allowed projection of track-cluster separation along track direction
+     *  @param  minTrackClusterCosAngle min cos(angle) between track and cluster initial direction
+     *  @param  trackClusterDistance to receive the track cluster distance
+     */
+    static pandora::StatusCode GetTrackClusterDistance(const pandora::TrackState *const pTrackState, const ClusterHitPositions &clusterHitPositions,
+        const unsigned int maxSearchLayer, const float parallelDistanceCut, const float minTrackClusterCosAngle, float &trackClusterDistance);
+
     /**
      *  @brief  Whether a cluster can be merged with another. Uses simple suggested criteria, including cluster photon id flag
      *          and supplied cuts on cluster mip fraction and all hits fit rms.
@@ -192,6 +226,55 @@ public:
      *  @return boolean
      */
     static bool ContainsHitInOuterSamplingLayer(const pandora::Cluster *const pCluster);
+
+    /**
+     *  @brief  Get the squared distance cut to use in place of a distance cut, padded so that no pair of positions within the distance
+     *          cut is lost to rounding
+     * 
+     *  @param  distance the distance cut
+     * 
+     *  @return the padded squared distance cut, or the max float value if the squared distance cut would overflow
+     */
+    static float GetPaddedDistanceSquaredCut(const float distance);
+
+    /**
+     *  @brief  Get the squared distance between two axis-aligned boxes, zero if they overlap. The separation along each axis is calculated
+     *          as for a pair of positions, so the result never exceeds the squared distance between any pair of enclosed positions, even
+     *          after rounding
+     * 
+     *  @param  lowI the min x, y and z coordinates of the first box
+     *  @param  highI the max x, y and z coordinates of the first box
+     *  @param  lowJ the min x, y and z coordinates of the second box
+     *  @param  highJ the max x, y and z coordinates of the second box
+     * 
+     *  @return the squared distance between the boxes
+     */
+    static float GetBoxDistanceSquared(const float lowI[3], const float highI[3], const float lowJ[3], const float highJ[3]);
+
+private:
+    typedef std::vector<pandora::CartesianVector> PositionVector;
+    typedef std::pair<float, unsigned int> CoordinateIndex;
+    typedef std::vector<CoordinateIndex> CoordinateIndexVector;
+
+    /**
+     *  @brief  Get the positions of the hits in a cluster
+     * 
+     *  @param  pCluster address of the cluster
+     *  @param  positionVector to receive the hit positions
+     */
+    static void GetHitPositions(const pandora::Cluster *const pCluster, PositionVector &positionVector);
+
+    /**
+     *  @brief  Get the smallest squared distance between pairs of positions from two sets, using their bounding boxes and a sweep along
+     *          the longest axis of the second set to avoid examining every pair. The result is identical to that of an exhaustive search.
+     * 
+     *  @param  positionsI the first set of positions
+     *  @param  positionsJ the second set of positions
+     *  @param  maxDistanceSquared only squared distances smaller than this value are of interest
+     * 
+     *  @return the smallest squared distance, if smaller than the max squared distance, otherwise the max squared distance
+     */
+    static float GetClosestDistanceSquared(const PositionVector &positionsI, const PositionVector &positionsJ, const float maxDistanceSquared);
 };
 
 } // namespace lc_content
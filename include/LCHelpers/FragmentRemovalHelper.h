@@ -11,9 +11,15 @@
 #include "Pandora/PandoraInternal.h"
 #include "Pandora/StatusCodes.h"
 
+#include <unordered_map>
+
 namespace lc_content
 {
 
+class HelixTrajectory;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  ClusterContact class, describing the interactions and proximity between parent and daughter candidate clusters
  */
@@ -127,6 +133,44 @@ typedef std::map<const pandora::Cluster *, ClusterContactVector> ClusterContactM
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+/**
+ *  @brief  ClusterBoundingBox class, the axis-aligned box enclosing the calo hit positions of a cluster
+ */
+class ClusterBoundingBox
+{
+public:
+    /**
+     *  @brief  Constructor
+     * 
+     *  @param  pCluster address of the cluster
+     */
+    explicit ClusterBoundingBox(const pandora::Cluster *const pCluster);
+
+    /**
+     *  @brief  Whether any calo hit enclosed by this box could lie within a specified distance of a calo hit enclosed by another box.
+     *          A box enclosing no calo hits is always considered to be within the specified distance.
+     * 
+     *  @param  rhs the other bounding box
+     *  @param  distance the specified distance
+     * 
+     *  @return boolean
+     */
+    bool IsWithinDistance(const ClusterBoundingBox &rhs, const float distance) const;
+
+private:
+    bool                        m_isEmpty;                  ///< Whether the cluster contains no calo hits
+    float                       m_minX;                     ///< The min x coordinate of the calo hits
+    float                       m_minY;                     ///< The min y coordinate of the calo hits
+    float                       m_minZ;                     ///< The min z coordinate of the calo hits
+    float                       m_maxX;                     ///< The max x coordinate of the calo hits
+    float                       m_maxY;                     ///< The max y coordinate of the calo hits
+    float                       m_maxZ;                     ///< The max z coordinate of the calo hits
+};
+
+typedef std::unordered_map<const pandora::Cluster *, ClusterBoundingBox> ClusterBoundingBoxMap;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  FragmentRemovalHelper class
  */
@@ -212,6 +256,21 @@ public:
         const unsigned int startLayer, const unsigned int endLayer, const unsigned int maxOccupiedLayers, float &closestDistanceToHit,
         float &meanDistanceToHits);
 
+    /**
+     *  @brief  Get the distance between hits in a cluster and a helix, using and extending the distances memoized for the helix
+     * 
+     *  @param  pCluster address of the cluster
+     *  @param  helixTrajectory the helix and its memoized extrapolation results
+     *  @param  startLayer the first pseudo layer of the cluster to examine
+     *  @param  endLayer the last pseudo layer of the cluster to examine
+     *  @param  maxOccupiedLayers the maximum number of occupied cluster pseudo layers to examine
+     *  @param  closestDistanceToHit to receive the closest distance between the helix and a hit in the specified range of the cluster
+     *  @param  meanDistanceToHits to receive the mean distance between the helix and hits in the specified range of the cluster
+     */
+    static pandora::StatusCode GetClusterHelixDistance(const pandora::Cluster *const pCluster, const HelixTrajectory &helixTrajectory,
+        const unsigned int startLayer, const unsigned int endLayer, const unsigned int maxOccupiedLayers, float &closestDistanceToHit,
+        float &meanDistanceToHits);
+
     /**
      *  @brief  Get the number of contact layers for two clusters and also the ratio of the number of contact layers to overlap layers
      * 
@@ -243,6 +302,33 @@ public:
      *  @return the electromagnetic energy-weighted mean cluster position
      */
     static pandora::CartesianVector GetEMEnergyWeightedPosition(const pandora::Cluster *const pCluster);
+
+    /**
+     *  @brief  Whether any calo hit in cluster I could lie within a specified distance of a calo hit in cluster J, judged using
+     *          the bounding boxes of the two clusters. If false, the clusters cannot pass any cut on the distance between closest hits.
+     * 
+     *  @param  pClusterI address of the first cluster
+     *  @param  pClusterJ address of the second cluster
+     *  @param  distance the specified distance
+     *  @param  clusterBoundingBoxMap the cache of cluster bounding boxes, to which the boxes for clusters I and J are added if absent
+     * 
+     *  @return boolean
+     */
+    static bool CanBeWithinDistance(const pandora::Cluster *const pClusterI, const pandora::Cluster *const pClusterJ, const float distance,
+        ClusterBoundingBoxMap &clusterBoundingBoxMap);
+
+private:
+    /**
+     *  @brief  Get the pseudo layers for a list of positions, using the non-throwing batch interface of the lc pseudo layer plugin
+     *          if it is the registered plugin
+     * 
+     *  @param  pandora the associated pandora instance
+     *  @param  positionVector the list of positions
+     *  @param  pseudoLayers to receive the pseudo layer for each position, or std::numeric_limits<unsigned int>::max() for any position
+     *          for which no pseudo layer can be found
+     */
+    static void GetPseudoLayers(const pandora::Pandora &pandora, const pandora::CartesianPointVector &positionVector,
+        pandora::UIntVector &pseudoLayers);
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -10,6 +10,8 @@
 
 #include "Pandora/Algorithm.h"
 
+#include <map>
+
 namespace lc_content
 {
 
@@ -27,6 +29,70 @@ public:
 private:
     typedef const void *Uid;
 
+    /**
+     *  @brief  MuonProjection class, the projection of a track helix into the muon system, towards one of the muon endcaps
+     */
+    class MuonProjection
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         * 
+         *  @param  externalHelix the helix that can be propagated in the muon system, outside the central detector
+         *  @param  helixDirection the direction of the external helix at the muon entry point
+         */
+        MuonProjection(const pandora::Helix &externalHelix, const pandora::CartesianVector &helixDirection);
+
+        const pandora::Helix            m_externalHelix;        ///< The helix that can be propagated in the muon system
+        const pandora::CartesianVector  m_helixDirection;       ///< The direction of the external helix at the muon entry point
+    };
+
+    typedef std::map<const pandora::Track *, const pandora::Helix> TrackToHelixMap;
+    typedef std::pair<const pandora::Track *, bool> TrackEndCapPair;
+    typedef std::map<TrackEndCapPair, const MuonProjection> MuonProjectionMap;
+
+    /**
+     *  @brief  TrackHelixCache class, the helix fits to the tracks at the calorimeter and their projections into the muon system, each
+     *          evaluated at most once per event and shared between all muon clusters and calo hits
+     */
+    class TrackHelixCache
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         * 
+         *  @param  algorithm the muon reconstruction algorithm
+         */
+        explicit TrackHelixCache(const MuonReconstructionAlgorithm &algorithm);
+
+        /**
+         *  @brief  Get the helix fit to a track at the calorimeter
+         * 
+         *  @param  pTrack address of the track
+         * 
+         *  @return the helix
+         */
+        const pandora::Helix &GetHelix(const pandora::Track *const pTrack);
+
+        /**
+         *  @brief  Get the projection of a track helix into the muon system
+         * 
+         *  @param  pTrack address of the track
+         *  @param  isPositiveZ whether to project the helix to the muon endcap with positive or negative z coordinate
+         *  @param  pMuonProjection to receive the address of the projection
+         */
+        pandora::StatusCode GetMuonProjection(const pandora::Track *const pTrack, const bool isPositiveZ, const MuonProjection *&pMuonProjection);
+
+    private:
+        const MuonReconstructionAlgorithm  &m_algorithm;            ///< The muon reconstruction algorithm
+        float                               m_innerBField;          ///< The magnetic field at the origin
+        float                               m_coilMidPointR;        ///< The radius of the mid point of the coil
+        float                               m_muonBarrelBField;     ///< The magnetic field at the inner radius of the muon barrel
+        float                               m_muonEndCapBField;     ///< The magnetic field at the inner z coordinate of the muon endcap
+        TrackToHelixMap                     m_trackToHelixMap;      ///< The map from track to helix fit at the calorimeter
+        MuonProjectionMap                   m_muonProjectionMap;    ///< The map from (track, isPositiveZ) to muon system projection
+    };
+
     pandora::StatusCode Run();
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
@@ -34,8 +100,9 @@ private:
      *  @brief  Associate muon clusters with appropriate tracks
      * 
      *  @param  pMuonClusterList address of the muon cluster list
+     *  @param  trackHelixCache the cache of track helices and their muon system projections
      */
-    pandora::StatusCode AssociateMuonTracks(const pandora::ClusterList *const pMuonClusterList) const;
+    pandora::StatusCode AssociateMuonTracks(const pandora::ClusterList *const pMuonClusterList, TrackHelixCache &trackHelixCache) const;
 
     /**
      *  @brief  Get the coordinates of the point at which a helix enters the muon detectors
@@ -50,8 +117,9 @@ private:
      *  @brief  Add appropriate calo hits in the ecal/hcal to the muon clusters
      * 
      *  @param  pMuonClusterList address of the muon cluster list
+     *  @param  trackHelixCache the cache of track helices and their muon system projections
      */
-    pandora::StatusCode AddCaloHits(const pandora::ClusterList *const pMuonClusterList) const;
+    pandora::StatusCode AddCaloHits(const pandora::ClusterList *const pMuonClusterList, TrackHelixCache &trackHelixCache) const;
 
     /**
      *  @brief  Create the muon pfos
@@ -26,11 +26,30 @@ public:
      */
     LCPseudoLayerPlugin();
 
+    /**
+     *  @brief  Get the pseudo layers for a list of positions, without raising exceptions for positions outside the detector
+     * 
+     *  @param  positionVector the list of positions
+     *  @param  pseudoLayers to receive the pseudo layer for each position, or std::numeric_limits<unsigned int>::max() for any position
+     *          for which no pseudo layer can be found
+     */
+    void GetPseudoLayers(const pandora::CartesianPointVector &positionVector, pandora::UIntVector &pseudoLayers) const;
+
 private:
     pandora::StatusCode Initialize();
     unsigned int GetPseudoLayer(const pandora::CartesianVector &positionVector) const;
     unsigned int GetPseudoLayerAtIp() const;
 
+    /**
+     *  @brief  Find the pseudo layer for a specified position
+     * 
+     *  @param  positionVector the specified position
+     *  @param  pseudoLayer to receive the pseudo layer
+     * 
+     *  @return STATUS_CODE_SUCCESS if a pseudo layer is found, else STATUS_CODE_NOT_FOUND
+     */
+    pandora::StatusCode FindPseudoLayer(const pandora::CartesianVector &positionVector, unsigned int &pseudoLayer) const;
+
     /**
      *  @brief  Get the appropriate pseudolayer for a specified parameters
      * 
@@ -46,15 +65,43 @@ private:
         const float barrelInnerR, const float endCapInnerZ, unsigned int &pseudoLayer) const;
 
     typedef std::vector<float> LayerPositionList;
+    typedef std::vector<unsigned int> IndexList;
+
+    /**
+     *  @brief  LayerLookup class, dividing the range of a layer position list into uniform bins, each recording the index of the
+     *          first layer position beyond the lower edge of the bin
+     */
+    class LayerLookup
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        LayerLookup();
+
+        float           m_minPosition;                  ///< The lower edge of the first bin, the first layer position
+        float           m_inverseBinWidth;              ///< The inverse of the bin width
+        IndexList       m_upperIndices;                 ///< The index of the first layer position beyond the lower edge of each bin
+    };
 
     /**
      *  @brief  Find the layer number corresponding to a specified position, via reference to a specified layer position list
      * 
      *  @param  position the specified position
      *  @param  layerPositionList the specified layer position list
+     *  @param  layerLookup the lookup table for the specified layer position list
      *  @param  layer to receive the layer number
      */
-    pandora::StatusCode FindMatchingLayer(const float position, const LayerPositionList &layerPositionList, unsigned int &layer) const;
+    pandora::StatusCode FindMatchingLayer(const float position, const LayerPositionList &layerPositionList, const LayerLookup &layerLookup,
+        unsigned int &layer) const;
+
+    /**
+     *  @brief  Fill the lookup table for a layer position list upon initialization
+     * 
+     *  @param  layerPositionList the sorted layer position list
+     *  @param  layerLookup to receive the lookup table
+     */
+    void FillLayerLookup(const LayerPositionList &layerPositionList, LayerLookup &layerLookup) const;
 
     /**
      *  @brief  Store all revelevant barrel and endcap layer positions upon initialization
@@ -86,10 +133,33 @@ private:
 
     typedef std::vector< std::pair<float, float> > AngleVector;
 
+    /**
+     *  @brief  PolygonLookup class, dividing the directions in the x-y plane into bins, each recording the consecutive polygon faces
+     *          that can provide the maximum radius for a direction in (or adjacent to) the bin
+     */
+    class PolygonLookup
+    {
+    public:
+        IndexList       m_firstFaces;                   ///< The index in the angle vector of the first candidate face for each bin
+        IndexList       m_nFaces;                       ///< The number of consecutive candidate faces for each bin
+    };
+
     /**
      *  @brief  Get the maximum polygon radius, with reference to cached sine/cosine values for relevant polygon angles
      * 
      *  @param  angleVector vector containing cached sine/cosine values
+     *  @param  polygonLookup the lookup table of candidate polygon faces
+     *  @param  x the cartesian x coordinate
+     *  @param  y the cartesian y coordinate
+     * 
+     *  @return the maximum radius
+     */
+    float GetMaximumRadius(const AngleVector &angleVector, const PolygonLookup &polygonLookup, const float x, const float y) const;
+
+    /**
+     *  @brief  Get the maximum polygon radius, considering all polygon faces
+     * 
+     *  @param  angleVector vector containing cached sine/cosine values
      *  @param  x the cartesian x coordinate
      *  @param  y the cartesian y coordinate
      * 
@@ -97,6 +167,24 @@ private:
      */
     float GetMaximumRadius(const AngleVector &angleVector, const float x, const float y) const;
 
+    /**
+     *  @brief  Get a measure of the direction of a vector in the x-y plane, increasing monotonically with phi from 0 (phi = 0) to 4
+     * 
+     *  @param  x the cartesian x coordinate
+     *  @param  y the cartesian y coordinate
+     * 
+     *  @return the direction measure, or a value outside the range [0, 4) if the direction is undefined
+     */
+    float GetPseudoPhi(const float x, const float y) const;
+
+    /**
+     *  @brief  Fill the lookup table of candidate polygon faces upon initialization
+     * 
+     *  @param  angleVector vector containing cached sine/cosine values
+     *  @param  polygonLookup to receive the lookup table
+     */
+    void FillPolygonLookup(const AngleVector &angleVector, PolygonLookup &polygonLookup) const;
+
     /**
      *  @brief  Fill a vector with sine/cosine values for relevant polygon angles
      * 
@@ -112,6 +200,10 @@ private:
     LayerPositionList   m_endCapLayerPositions;     ///< List of endcap layer positions
     AngleVector         m_eCalBarrelAngleVector;    ///< The ecal barrel angle vector
     AngleVector         m_muonBarrelAngleVector;    ///< The muon barrel angle vector
+    LayerLookup         m_barrelLayerLookup;        ///< The lookup table for the barrel layer positions
+    LayerLookup         m_endCapLayerLookup;        ///< The lookup table for the endcap layer positions
+    PolygonLookup       m_eCalBarrelPolygonLookup;  ///< The lookup table of candidate ecal barrel polygon faces
+    PolygonLookup       m_muonBarrelPolygonLookup;  ///< The lookup table of candidate muon barrel polygon faces
 
     float               m_barrelInnerR;             ///< Barrel inner radius
     float               m_endCapInnerZ;             ///< Endcap inner z position
@@ -10,6 +10,9 @@
 
 #include "Plugins/ShowerProfilePlugin.h"
 
+#include <mutex>
+#include <utility>
+
 namespace lc_content
 {
 /**
@@ -23,6 +26,11 @@ public:
      */
     LCShowerProfilePlugin();
 
+    /**
+     *  @brief  Destructor
+     */
+    ~LCShowerProfilePlugin();
+
     void CalculateShowerStartLayer(const pandora::Cluster *const pCluster, unsigned int &showerStartLayer) const;
     void CalculateLongitudinalProfile(const pandora::Cluster *const pCluster, float &profileStart, float &profileDiscrepancy) const;
     void CalculateTransverseProfile(const pandora::Cluster *const pCluster, const unsigned int maxPseudoLayer, ShowerPeakList &showerPeakList) const;
@@ -45,11 +53,14 @@ private:
 
         bool                        m_isAvailable;          ///< Whether shower profile entry is available (prevent double counting)
         float                       m_energy;               ///< The energy associated with the shower profile entry
-        pandora::CaloHitList        m_caloHitList;          ///< The list of calo hits associated with the shower profile entry
         bool                        m_potentialPeak;        ///< Whether the shower profile is a potential peak (to speed up looping)
-        pandora::CaloHitList        m_unusedCaloHitList;    ///< The list of calo hits unused for shower peak finding, needed for inclusive mode
+        int                         m_firstHitIndex;        ///< Index of the first calo hit associated with the entry, -1 if none
+        int                         m_lastHitIndex;         ///< Index of the last calo hit associated with the entry, -1 if none
+        int                         m_firstUnusedHitIndex;  ///< Index of the first calo hit unused for shower peak finding, -1 if none
+        int                         m_lastUnusedHitIndex;   ///< Index of the last calo hit unused for shower peak finding, -1 if none
     };
 
+    typedef std::vector<double> DoubleVector;               ///< The double vector typedef
     typedef std::pair<int, int> TwoDBin;                    ///< The two dimensional bin typedef
     typedef std::vector<TwoDBin > TwoDBinVector;            ///< The two dimensional bin vector typedef
 
@@ -96,9 +107,198 @@ private:
     };
 
     typedef std::vector<ShowerProfileEntry> ShowerProfile;          ///< The shower profile typedef
-    typedef std::vector<ShowerProfile> TwoDShowerProfile;           ///< The two dimensional shower profile typedef
     typedef std::vector<ShowerPeakObject> ShowerPeakObjectVector;   ///< The shower peak object vector
 
+    /**
+     *  @brief  TwoDShowerProfile class, a flat square grid of shower profile entries. The calo hits in each entry are held as linked
+     *          lists of indices into a single calo hit vector, so that the grid can be cleared, by touching only occupied entries, and reused
+     */
+    class TwoDShowerProfile
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  nBins the number of bins along each side of the grid
+         */
+        explicit TwoDShowerProfile(const int nBins);
+
+        /**
+         *  @brief  Get the number of bins along each side of the grid
+         *
+         *  @return the number of bins
+         */
+        int GetNBins() const;
+
+        /**
+         *  @brief  Get the shower profile entry for a bin
+         *
+         *  @param  uBin the u bin
+         *  @param  vBin the v bin
+         *
+         *  @return the shower profile entry
+         */
+        ShowerProfileEntry &GetEntry(const int uBin, const int vBin);
+
+        /**
+         *  @brief  Get the shower profile entry for a bin
+         *
+         *  @param  uBin the u bin
+         *  @param  vBin the v bin
+         *
+         *  @return the shower profile entry
+         */
+        const ShowerProfileEntry &GetEntry(const int uBin, const int vBin) const;
+
+        /**
+         *  @brief  Add a calo hit, and its electromagnetic energy, to a bin
+         *
+         *  @param  uBin the u bin
+         *  @param  vBin the v bin
+         *  @param  pCaloHit address of the calo hit
+         */
+        void AddCaloHit(const int uBin, const int vBin, const pandora::CaloHit *const pCaloHit);
+
+        /**
+         *  @brief  Add a calo hit unused for shower peak finding to a bin
+         *
+         *  @param  uBin the u bin
+         *  @param  vBin the v bin
+         *  @param  pCaloHit address of the calo hit
+         */
+        void AddUnusedCaloHit(const int uBin, const int vBin, const pandora::CaloHit *const pCaloHit);
+
+        /**
+         *  @brief  Append the calo hits associated with a bin to a calo hit list, in the order in which they were added
+         *
+         *  @param  uBin the u bin
+         *  @param  vBin the v bin
+         *  @param  caloHitList to receive the calo hits
+         */
+        void GetCaloHits(const int uBin, const int vBin, pandora::CaloHitList &caloHitList) const;
+
+        /**
+         *  @brief  Append the calo hits unused for shower peak finding in a bin to a calo hit list, in the order in which they were added
+         *
+         *  @param  uBin the u bin
+         *  @param  vBin the v bin
+         *  @param  caloHitList to receive the calo hits
+         */
+        void GetUnusedCaloHits(const int uBin, const int vBin, pandora::CaloHitList &caloHitList) const;
+
+        /**
+         *  @brief  Get the bins to which calo hits have been added, in order of u bin then v bin
+         *
+         *  @param  occupiedBins to receive the occupied bins
+         */
+        void GetOccupiedBins(TwoDBinVector &occupiedBins) const;
+
+        /**
+         *  @brief  Remove all calo hits and energy from the grid, resetting only the occupied entries. Availability and potential peak
+         *          flags of unoccupied entries are not reset: they remain unset unless assigned when masking low height regions, which
+         *          then assigns them for every entry
+         */
+        void Clear();
+
+    private:
+        /**
+         *  @brief  Get the index of a bin in the flat grid
+         *
+         *  @param  uBin the u bin
+         *  @param  vBin the v bin
+         *
+         *  @return the bin index
+         */
+        int GetBinIndex(const int uBin, const int vBin) const;
+
+        /**
+         *  @brief  Append a calo hit to the linked list of calo hits for a bin
+         *
+         *  @param  binIndex the bin index
+         *  @param  pCaloHit address of the calo hit
+         *  @param  firstHitIndex the index of the first calo hit in the list
+         *  @param  lastHitIndex the index of the last calo hit in the list
+         */
+        void AppendCaloHit(const int binIndex, const pandora::CaloHit *const pCaloHit, int &firstHitIndex, int &lastHitIndex);
+
+        /**
+         *  @brief  Append the calo hits in a linked list to a calo hit list
+         *
+         *  @param  firstHitIndex the index of the first calo hit in the list
+         *  @param  caloHitList to receive the calo hits
+         */
+        void GetCaloHits(const int firstHitIndex, pandora::CaloHitList &caloHitList) const;
+
+        int                         m_nBins;                ///< The number of bins along each side of the grid
+        ShowerProfile               m_entries;              ///< The shower profile entries, indexed by u bin then v bin
+        pandora::CaloHitVector      m_caloHits;             ///< The calo hits added to the grid
+        pandora::IntVector          m_nextHitIndices;       ///< The index of the next calo hit in the same list, for each calo hit, -1 if none
+        pandora::IntVector          m_occupiedBinIndices;   ///< The indices of bins to which calo hits have been added
+    };
+
+    /**
+     *  @brief  TwoDShowerProfileHandle class, borrowing a two dimensional shower profile from the plugin pool for its lifetime
+     */
+    class TwoDShowerProfileHandle
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  plugin the plugin from which to borrow the shower profile
+         */
+        explicit TwoDShowerProfileHandle(const LCShowerProfilePlugin &plugin);
+
+        /**
+         *  @brief  Destructor, returning the shower profile to the plugin pool
+         */
+        ~TwoDShowerProfileHandle();
+
+        /**
+         *  @brief  Get the borrowed shower profile
+         *
+         *  @return the shower profile
+         */
+        TwoDShowerProfile &GetShowerProfile() const;
+
+        /**
+         *  @brief  Swap the borrowed shower profile with that of another handle
+         *
+         *  @param  rhs the other handle
+         */
+        void Swap(TwoDShowerProfileHandle &rhs);
+
+    private:
+        /**
+         *  @brief  Copy constructor, not implemented
+         */
+        TwoDShowerProfileHandle(const TwoDShowerProfileHandle &rhs);
+
+        /**
+         *  @brief  Assignment operator, not implemented
+         */
+        TwoDShowerProfileHandle &operator=(const TwoDShowerProfileHandle &rhs);
+
+        const LCShowerProfilePlugin    &m_plugin;           ///< The plugin from which the shower profile was borrowed
+        TwoDShowerProfile              *m_pShowerProfile;   ///< The borrowed shower profile
+    };
+
+    typedef std::vector<TwoDShowerProfile*> TwoDShowerProfilePool;  ///< The two dimensional shower profile pool typedef
+
+    /**
+     *  @brief  Borrow a two dimensional shower profile from the pool, creating a new one if the pool is empty
+     *
+     *  @return address of the shower profile
+     */
+    TwoDShowerProfile *BorrowTwoDShowerProfile() const;
+
+    /**
+     *  @brief  Return a borrowed two dimensional shower profile to the pool
+     *
+     *  @param  pShowerProfile address of the shower profile
+     */
+    void ReturnTwoDShowerProfile(TwoDShowerProfile *const pShowerProfile) const;
+
     /**
      *  @brief  Calculate transverse shower peak objects for a cluster and get the list of peaks identified in the profile, for clusters without tracks
      *
@@ -124,13 +324,6 @@ private:
     void CalculateTrackNearbyTransverseShowers(const pandora::Cluster *const pCluster, const unsigned int maxPseudoLayer, const pandora::Track *const pMinTrack,
         const pandora::TrackVector &trackVector, TwoDShowerProfile &showerProfile, ShowerPeakObjectVector &showerPeakObjectVector, TwoDBinVector &trackProjectionVector) const;
 
-    /**
-     *  @brief  Calculate empty 2D shower profile
-     *
-     *  @param  showerProfile two dimensional shower profile to receive
-     */
-    void CreateEmptyTwoDShowerProfile(TwoDShowerProfile &showerProfile) const;
-
     /**
      *  @brief  Initialise 2D shower profile for clusters not close to tracks
      *
@@ -200,20 +393,31 @@ private:
      */
     float GetCellLengthScale(const pandora::Cluster *const pCluster) const;
 
+    /**
+     *  @brief  Get the bins that may be available for peak finding, in order of u bin then v bin. These are the occupied bins if an empty
+     *          bin would be masked as a low height region, otherwise all bins
+     *
+     *  @param  showerProfile two dimensional shower profile to consider
+     *  @param  binsToScan to receive the bins to scan
+     */
+    void GetBinsToScan(const TwoDShowerProfile &showerProfile, TwoDBinVector &binsToScan) const;
+
     /**
      *  @brief  Mark region with low height unavailable
      *
+     *  @param  binsToScan the bins to scan
      *  @param  showerProfile two dimensional shower profile to consider
      */
-    void MaskLowHeightRegions(TwoDShowerProfile &showerProfile) const;
+    void MaskLowHeightRegions(const TwoDBinVector &binsToScan, TwoDShowerProfile &showerProfile) const;
 
     /**
      *  @brief  Find raw peaks in 2D profile, based on local maxima
      *
+     *  @param  binsToScan the bins to scan
      *  @param  showerProfile two dimensional shower profile to consider
      *  @param  showerPeakObjectVector the 2D peak object to receive
      */
-    void FindRawPeaksInTwoDShowerProfile(TwoDShowerProfile &showerProfile, ShowerPeakObjectVector &showerPeakObjectVector) const;
+    void FindRawPeaksInTwoDShowerProfile(const TwoDBinVector &binsToScan, TwoDShowerProfile &showerProfile, ShowerPeakObjectVector &showerPeakObjectVector) const;
 
     /**
      *  @brief  Associate unavailable bins to peaks, using TwoDShowerProfile, for inclusive modes
@@ -226,10 +430,11 @@ private:
     /**
      *  @brief  Associate bins to peaks, using TwoDShowerProfile
      *
+     *  @param  binsToScan the bins to scan
      *  @param  showerProfile two dimensional shower profile to consider
      *  @param  showerPeakObjectVector the 2D peak object to receive
      */
-    void AssociateBinsToPeaks(const TwoDShowerProfile &showerProfile, ShowerPeakObjectVector &showerPeakObjectVector) const;
+    void AssociateBinsToPeaks(const TwoDBinVector &binsToScan, const TwoDShowerProfile &showerProfile, ShowerPeakObjectVector &showerPeakObjectVector) const;
 
     /**
      *  @brief  Associate bins to peaks, using TwoDBinVector
@@ -393,6 +598,11 @@ private:
      */
     static bool SortShowerPeakListByEnergy(const ShowerPeak &lhs, const ShowerPeak &rhs);
 
+    /**
+     *  @brief  Fill the energy-independent terms of the expected longitudinal profile for each bin
+     */
+    void FillLongitudinalProfileTables();
+
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
     float        m_showerStartMipFraction;                  ///< Max layer mip-fraction to declare layer as shower-like
@@ -405,6 +615,8 @@ private:
     float        m_longProfileParameter0;                   ///< Parameter0, used to calculate argument for gamma function
     float        m_longProfileParameter1;                   ///< Parameter1, used to calculate argument for gamma function
     float        m_longProfileMaxDifference;                ///< Max difference between current and best longitudinal profile comparisons
+    pandora::FloatVector  m_longProfileHalfDepths;          ///< Half the depth at the end of each longitudinal profile bin, units radiation lengths
+    DoubleVector          m_longProfileExpTerms;            ///< Exponential term of the expected longitudinal profile for each bin
 
     int          m_transProfileNBins;                       ///< Number of bins used to construct transverse profile
     float        m_transProfilePeakThreshold;               ///< Minimum energy for a bin to consider
@@ -413,6 +625,9 @@ private:
     unsigned int m_transProfileTrackNearbyNSlices;          ///< The number of slices to analyse the EM shower
     float        m_transProfileMinTrackToPeakCut;           ///< The minimum 2D distance of a track to the peak postion
     float        m_transProfileMinDisTrackMatch ;           ///< The maximum allowed shift of 2D distance of the peak position through the slices
+
+    mutable TwoDShowerProfilePool   m_twoDShowerProfilePool;        ///< Two dimensional shower profiles available for reuse between calls
+    mutable std::mutex              m_twoDShowerProfilePoolMutex;   ///< The mutex guarding the two dimensional shower profile pool
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -425,10 +640,85 @@ inline void LCShowerProfilePlugin::CalculateTransverseProfile(const pandora::Clu
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 inline LCShowerProfilePlugin::ShowerProfileEntry::ShowerProfileEntry() :
-    m_isAvailable(true),
+    m_isAvailable(false),
     m_energy(0.f),
-    m_potentialPeak(true)
+    m_potentialPeak(false),
+    m_firstHitIndex(-1),
+    m_lastHitIndex(-1),
+    m_firstUnusedHitIndex(-1),
+    m_lastUnusedHitIndex(-1)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline int LCShowerProfilePlugin::TwoDShowerProfile::GetNBins() const
+{
+    return m_nBins;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LCShowerProfilePlugin::ShowerProfileEntry &LCShowerProfilePlugin::TwoDShowerProfile::GetEntry(const int uBin, const int vBin)
+{
+    return m_entries[this->GetBinIndex(uBin, vBin)];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const LCShowerProfilePlugin::ShowerProfileEntry &LCShowerProfilePlugin::TwoDShowerProfile::GetEntry(const int uBin, const int vBin) const
+{
+    return m_entries[this->GetBinIndex(uBin, vBin)];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LCShowerProfilePlugin::TwoDShowerProfile::GetCaloHits(const int uBin, const int vBin, pandora::CaloHitList &caloHitList) const
+{
+    this->GetCaloHits(this->GetEntry(uBin, vBin).m_firstHitIndex, caloHitList);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LCShowerProfilePlugin::TwoDShowerProfile::GetUnusedCaloHits(const int uBin, const int vBin, pandora::CaloHitList &caloHitList) const
+{
+    this->GetCaloHits(this->GetEntry(uBin, vBin).m_firstUnusedHitIndex, caloHitList);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline int LCShowerProfilePlugin::TwoDShowerProfile::GetBinIndex(const int uBin, const int vBin) const
+{
+    return uBin * m_nBins + vBin;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LCShowerProfilePlugin::TwoDShowerProfileHandle::TwoDShowerProfileHandle(const LCShowerProfilePlugin &plugin) :
+    m_plugin(plugin),
+    m_pShowerProfile(plugin.BorrowTwoDShowerProfile())
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LCShowerProfilePlugin::TwoDShowerProfileHandle::~TwoDShowerProfileHandle()
+{
+    m_plugin.ReturnTwoDShowerProfile(m_pShowerProfile);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LCShowerProfilePlugin::TwoDShowerProfile &LCShowerProfilePlugin::TwoDShowerProfileHandle::GetShowerProfile() const
+{
+    return *m_pShowerProfile;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LCShowerProfilePlugin::TwoDShowerProfileHandle::Swap(TwoDShowerProfileHandle &rhs)
 {
+    std::swap(m_pShowerProfile, rhs.m_pShowerProfile);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
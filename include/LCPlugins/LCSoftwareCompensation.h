@@ -62,36 +62,60 @@ private:
      */
     pandora::StatusCode CleanCluster(const pandora::Cluster *const pCluster, float &correctedHadronicEnergy) const;
 
+    /**
+      *  @brief  Get the sum of the hadronic energies of the calo hits in each layer of an ordered calo hit list
+      *
+      *  @param  orderedCaloHitList the ordered calo hit list, which must not be empty
+      *  @param  layerHadronicEnergies to receive the layer hadronic energies, indexed by pseudolayer relative to the innermost layer
+      */
+    void GetLayerHadronicEnergies(const pandora::OrderedCaloHitList &orderedCaloHitList, pandora::FloatVector &layerHadronicEnergies) const;
+
     /**
       *  @brief  Get the sum of the hadronic energies of all calo hits in a specified layer of an ordered calo hit list
       *
       *  @param  orderedCaloHitList the ordered calo hit list
+      *  @param  layerHadronicEnergies the layer hadronic energies for the ordered calo hit list
       *  @param  pseudoLayer the specified pseudolayer
       */
-    float GetHadronicEnergyInLayer(const pandora::OrderedCaloHitList &orderedCaloHitList, const unsigned int pseudoLayer) const;
+    float GetHadronicEnergyInLayer(const pandora::OrderedCaloHitList &orderedCaloHitList, const pandora::FloatVector &layerHadronicEnergies,
+        const unsigned int pseudoLayer) const;
 
     /**
       *  @brief  Calculation of the software compensated corrected hadronic energy for a cluster
       *
       *  @param  clusterEnergyEstimation raw (i.e. no energy corrections) hadronic energy estimator for the cluster
-      *  @param  caloHitList the calo hit list for the cluster where software compensation is being applied
+      *  @param  orderedCaloHitList the ordered calo hit list for the cluster where software compensation is being applied
+      *  @param  isolatedCaloHitList the isolated calo hit list for the cluster where software compensation is being applied
       *  @param  energyCorrection corrected hadronic energy of the cluster
       */
-    pandora::StatusCode SoftComp(float clusterEnergyEstimation, const pandora::CaloHitList &caloHitList, float &energyCorrection) const;
+    pandora::StatusCode SoftComp(float clusterEnergyEstimation, const pandora::OrderedCaloHitList &orderedCaloHitList,
+        const pandora::CaloHitList &isolatedCaloHitList, float &energyCorrection) const;
+
+    /**
+      *  @brief  Add the software compensated hadronic energies of the calo hits in a list to a running sum
+      *
+      *  @param  caloHitList the calo hit list
+      *  @param  binnedWeights the weight for hits in each energy density bin
+      *  @param  unknownDensityWeight the weight for hits whose energy density cannot be calculated
+      *  @param  energySoftComp the running sum of software compensated hadronic energies
+      */
+    pandora::StatusCode AddSoftCompEnergy(const pandora::CaloHitList &caloHitList, const pandora::FloatVector &binnedWeights,
+        const float unknownDensityWeight, float &energySoftComp) const;
 
     /**
-      *  @brief  Calculate the energy density (binned) of a calo hit in units of GeV per cell
+      *  @brief  Find the energy density bin of a calo hit, with energy density in units of GeV per dm3
       *
       *  @param  pCaloHit the calo hit 
-      *  @param  energyDensity the binned energy density of the calo hit
+      *  @param  densityBin to receive the index of the energy density bin, in the list of binned energy densities
       */
-    pandora::StatusCode FindDensity(const pandora::CaloHit *const pCaloHit, float &energyDensity) const;
+    pandora::StatusCode FindDensityBin(const pandora::CaloHit *const pCaloHit, unsigned int &densityBin) const;
 
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
     pandora::FloatVector     m_softCompParameters;              ///< Parameters used to determine the weights applied to caloriemter hit energies 
     pandora::FloatVector     m_softCompEnergyDensityBins;       ///< Energy density bins used for software compensation
     float                    m_energyDensityFinalBin;           ///< Energy density used for final bin entries in software compensation 
+    pandora::FloatVector     m_binnedEnergyDensities;           ///< The energy density for each bin, bin centres followed by the final bin density
     float                    m_maxClusterEnergyToApplySoftComp; ///< Maxmium energy of a cluster for which software compensation is applied
     float                    m_minCleanHitEnergy;               ///< Min calo hit hadronic energy to consider cleaning hit/cluster
     float                    m_minCleanHitEnergyFraction;       ///< Min fraction of cluster energy represented by hit to consider cleaning
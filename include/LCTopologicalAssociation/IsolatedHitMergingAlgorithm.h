@@ -13,6 +13,13 @@
 namespace lc_content
 {
 
+template<typename, unsigned int> class KDTreeLinkerAlgo;
+template<typename, unsigned int> class KDTreeNodeInfoT;
+template<typename, unsigned int> class KDTreeNeighbourT;
+class KDTreeNeighbourSearchBuffer;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  IsolatedHitMergingAlgorithm class
  */
@@ -25,9 +32,80 @@ public:
     IsolatedHitMergingAlgorithm();
 
 private:
+    typedef KDTreeLinkerAlgo<unsigned int, 3> CentroidKDTree;
+    typedef KDTreeNodeInfoT<unsigned int, 3> CentroidKDNode;
+    typedef KDTreeNeighbourT<unsigned int, 3> CentroidKDNeighbour;
+
+    /**
+     *  @brief  HostClusterFilter class, accepting only the layer centroids of clusters able to receive a specified calo hit
+     */
+    class HostClusterFilter
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         * 
+         *  @param  clusterVector the candidate host clusters, indexed by the kd-tree node data
+         *  @param  pCaloHit address of the calo hit
+         *  @param  minHostCaloHits the minimum number of calo hits in a host cluster
+         *  @param  minCosOpeningAngle the min cos(angle) between hit and cluster directions
+         */
+        HostClusterFilter(const pandora::ClusterVector &clusterVector, const pandora::CaloHit *const pCaloHit, const unsigned int minHostCaloHits,
+            const float minCosOpeningAngle);
+
+        /**
+         *  @brief  Whether a layer centroid belongs to a cluster able to receive the calo hit
+         * 
+         *  @param  centroidNode the kd-tree node for the layer centroid
+         * 
+         *  @return boolean
+         */
+        bool operator()(const CentroidKDNode &centroidNode) const;
+
+    private:
+        const pandora::ClusterVector   &m_clusterVector;        ///< The candidate host clusters
+        const pandora::CaloHit         *m_pCaloHit;             ///< Address of the calo hit
+        const unsigned int              m_minHostCaloHits;      ///< The minimum number of calo hits in a host cluster
+        const float                     m_minCosOpeningAngle;   ///< The min cos(angle) between hit and cluster directions
+    };
+
     pandora::StatusCode Run();
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
+    /**
+     *  @brief  Fill a kd-tree with the layer centroids of the candidate host clusters
+     * 
+     *  @param  clusterVector the candidate host clusters
+     *  @param  centroidNodes to receive the kd-tree nodes
+     *  @param  centroidKDTree the kd-tree to build
+     */
+    void InitializeKDTree(const pandora::ClusterVector &clusterVector, std::vector<CentroidKDNode> &centroidNodes, CentroidKDTree &centroidKDTree) const;
+
+    /**
+     *  @brief  Erase the layer centroids of a candidate host cluster from the kd-tree, before the cluster is deleted
+     * 
+     *  @param  clusterVector the candidate host clusters
+     *  @param  clusterIndex the index of the cluster in the cluster vector
+     *  @param  centroidKDTree the kd-tree
+     */
+    void EraseClusterCentroids(const pandora::ClusterVector &clusterVector, const unsigned int clusterIndex, CentroidKDTree &centroidKDTree) const;
+
+    /**
+     *  @brief  Find the most appropriate host cluster for a calo hit, using the kd-tree to nominate candidates
+     * 
+     *  @param  clusterVector the candidate host clusters, null entries for those removed
+     *  @param  centroidKDTree the kd-tree of candidate host cluster layer centroids
+     *  @param  pCaloHit address of the calo hit
+     *  @param  minHostCaloHits the minimum number of calo hits in a host cluster
+     *  @param  searchBuffer the kd-tree search storage, reused between calls
+     *  @param  nearbyCentroids the nominated centroid storage, reused between calls
+     * 
+     *  @return address of the best host cluster, null if no suitable cluster is found
+     */
+    const pandora::Cluster *FindBestHostCluster(const pandora::ClusterVector &clusterVector, const CentroidKDTree &centroidKDTree,
+        const pandora::CaloHit *const pCaloHit, const unsigned int minHostCaloHits, KDTreeNeighbourSearchBuffer &searchBuffer,
+        std::vector<CentroidKDNeighbour> &nearbyCentroids) const;
+
     /**
      *  @brief  Get closest distance between a specified calo hit and a non-isolated hit in a specified cluster
      * 
@@ -10,6 +10,7 @@
 
 #include "Pandora/Algorithm.h"
 
+#include <memory>
 #include <unordered_map>
 
 namespace lc_content
@@ -17,6 +18,9 @@ namespace lc_content
 
 template<typename, unsigned int> class KDTreeLinkerAlgo;
 template<typename, unsigned int> class KDTreeNodeInfoT;
+template<typename, unsigned int> class KDTreeNeighbourT;
+template<unsigned int> class KDTreeBoxT;
+class CaloHitSpatialIndex;
 class QuickUnion;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -40,9 +44,50 @@ public:
 private:
     typedef KDTreeLinkerAlgo<const pandora::CaloHit*, 3> HitKDTree3D;
     typedef KDTreeNodeInfoT<const pandora::CaloHit*, 3> HitKDNode3D;
+    typedef KDTreeNeighbourT<const pandora::CaloHit*, 3> HitKDNeighbour3D;
     typedef std::unordered_map<const pandora::ClusterList *, std::string> ClusterListToNameMap;
     typedef std::unordered_map<const pandora::CaloHit*, int> HitToClusterMap;
-    typedef std::unordered_multimap<const pandora::CaloHit*, const pandora::CaloHit*> HitsToHitsCacheMap;
+    typedef std::unordered_map<const pandora::CaloHit*, float> HitToSearchDistanceMap;
+
+    /**
+     *  @brief  ParentHitFilter class, accepting only hits within a search region that belong to a suitable parent cluster
+     */
+    class ParentHitFilter
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         * 
+         *  @param  searchRegion the search region
+         *  @param  daughterHits the hits in the daughter cluster
+         *  @param  clusterVector the cluster vector
+         *  @param  hitToClusterMap the hit to cluster map
+         *  @param  quickUnion to handle updating cluster indices
+         *  @param  minClusterHadEnergy the min hadronic energy of a parent cluster
+         *  @param  maxHitsInSoftCluster the max number of hits in a soft cluster, which cannot be a parent
+         */
+        ParentHitFilter(const KDTreeBoxT<3> &searchRegion, const pandora::CaloHitSet &daughterHits, const pandora::ClusterVector &clusterVector,
+            const HitToClusterMap &hitToClusterMap, const QuickUnion &quickUnion, const float minClusterHadEnergy,
+            const unsigned int maxHitsInSoftCluster);
+
+        /**
+         *  @brief  Whether a hit lies within the search region and belongs to a suitable parent cluster
+         * 
+         *  @param  hitNode the kd-tree node for the hit
+         * 
+         *  @return boolean
+         */
+        bool operator()(const HitKDNode3D &hitNode) const;
+
+    private:
+        const KDTreeBoxT<3>            &m_searchRegion;             ///< The search region
+        const pandora::CaloHitSet      &m_daughterHits;             ///< The hits in the daughter cluster
+        const pandora::ClusterVector   &m_clusterVector;            ///< The cluster vector
+        const HitToClusterMap          &m_hitToClusterMap;          ///< The hit to cluster map
+        const QuickUnion               &m_quickUnion;               ///< To handle updating cluster indices, queried without modification
+        const float                     m_minClusterHadEnergy;      ///< The min hadronic energy of a parent cluster
+        const unsigned int              m_maxHitsInSoftCluster;     ///< The max number of hits in a soft cluster
+    };
 
     pandora::StatusCode Run();
 
@@ -65,7 +110,7 @@ private:
         HitToClusterMap &hitToClusterMap) const;
 
     /**
-     *  @brief  Initialize a kd-tree of the input hits to the preparation alg.
+     *  @brief  Initialize the spatial index used to search the input hits, sharing the index of the current calo hits if possible
      * 
      *  @param  pCaloHitList -- the calorimeter hit list
      */
@@ -153,9 +198,9 @@ private:
     float                   m_maxClusterDistanceFine;               ///< Fine granularity max distance between parent and daughter clusters
     float                   m_maxClusterDistanceCoarse;             ///< Coarse granularity max distance between parent and daughter clusters
 
-    HitsToHitsCacheMap         *m_hitsToHitsCacheMap;               ///< To cache nearby hits retrieved from kd-tree
-    std::vector<HitKDNode3D>   *m_hitNodes3D;                       ///< nodes for the KD tree (used for filling)
-    HitKDTree3D                *m_hitsKdTree3D;                     ///< the kd-tree itself, 3D in x,y,z
+    HitToSearchDistanceMap     *m_hitSearchDistanceMap;             ///< To cache the search distance first used for each hit
+    QuickUnion                 *m_pQuickUnion;                      ///< To track cluster merges, storage reused between events
+    std::shared_ptr<const CaloHitSpatialIndex>  m_spHitsSpatialIndex;   ///< The spatial index of the input hits, held during Run
 };
 
 } // namespace lc_content
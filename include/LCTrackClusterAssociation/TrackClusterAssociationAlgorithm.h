@@ -10,13 +10,20 @@
 
 #include "Pandora/Algorithm.h"
 
+#include "LCUtility/ClusterHitPositions.h"
+
+#include <memory>
 #include <unordered_map>
+#include <utility>
 
 namespace lc_content
 {
 
 template<typename, unsigned int> class KDTreeLinkerAlgo;
 template<typename, unsigned int> class KDTreeNodeInfoT;
+class CaloHitSpatialIndex;
+class ParallelFor;
+class TrackProjectionIndex;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -31,13 +38,74 @@ public:
      */
     TrackClusterAssociationAlgorithm();
 
-private:
-    pandora::StatusCode Run();
+    /**
+     *  @brief Destructor
+     */
+    ~TrackClusterAssociationAlgorithm();
 
+private:
     typedef KDTreeLinkerAlgo<const pandora::CaloHit*, 4> HitKDTree;
     typedef KDTreeNodeInfoT<const pandora::CaloHit*, 4> HitKDNode;
-    typedef std::unordered_multimap<std::pair<const pandora::Track*, unsigned int>, const pandora::CaloHit*> TracksToHitsInPseudoLayerMap;
     typedef std::unordered_map<const pandora::CaloHit*, const pandora::Cluster*> HitsToClustersMap;
+    typedef std::unordered_map<const pandora::Cluster*, unsigned int> ClusterToIndexMap;
+    typedef std::pair<const pandora::TrackState*, pandora::UIntVector> TrackStateCandidates;
+    typedef std::vector<TrackStateCandidates> TrackStateCandidatesVector;
+
+    /**
+     *  @brief  TrackCandidates class, the indices of the hit positions of the nearby clusters for each track state of a track, in the order
+     *          in which the clusters are to be scored
+     */
+    class TrackCandidates
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         * 
+         *  @param  pTrack address of the track
+         */
+        explicit TrackCandidates(const pandora::Track *const pTrack);
+
+        const pandora::Track           *m_pTrack;                   ///< Address of the track
+        TrackStateCandidatesVector      m_trackStateCandidates;     ///< The track states and their sorted nearby cluster indices
+    };
+
+    typedef std::vector<TrackCandidates> TrackCandidatesVector;
+
+    pandora::StatusCode Run();
+    pandora::StatusCode Reset();
+
+    /**
+     *  @brief  Find the matched cluster for each track, sharing the work between threads if configured to do so
+     * 
+     *  @param  clusterHitPositionsVector the hit positions of each nearby cluster
+     *  @param  trackCandidatesVector the nearby clusters for each track state of each track
+     *  @param  matchedClusters to receive the matched cluster for each track, nullptr if none, in track order
+     */
+    pandora::StatusCode GetMatchedClusters(const ClusterHitPositionsVector &clusterHitPositionsVector, const TrackCandidatesVector &trackCandidatesVector,
+        pandora::ClusterVector &matchedClusters) const;
+
+    /**
+     *  @brief  Find the matched cluster for each track in a contiguous range of tracks
+     * 
+     *  @param  clusterHitPositionsVector the hit positions of each nearby cluster
+     *  @param  trackCandidatesVector the nearby clusters for each track state of each track
+     *  @param  firstTrackIndex the index of the first track in the range
+     *  @param  endTrackIndex the index one past the last track in the range
+     *  @param  matchedClusters to receive the matched cluster for each track in the range, nullptr if none, indexed as the tracks
+     */
+    void CalculateMatchedClusters(const ClusterHitPositionsVector &clusterHitPositionsVector, const TrackCandidatesVector &trackCandidatesVector,
+        const unsigned int firstTrackIndex, const unsigned int endTrackIndex, pandora::ClusterVector &matchedClusters) const;
+
+    /**
+     *  @brief  Find the matched cluster for a track: the closest nearby cluster above the low energy cut, else the closest nearby cluster
+     *          below the low energy cut, with ties in distance resolved in favour of the cluster energy closest to the track energy
+     * 
+     *  @param  clusterHitPositionsVector the hit positions of each nearby cluster
+     *  @param  trackCandidates the nearby clusters for each track state of the track
+     * 
+     *  @return address of the matched cluster, nullptr if none
+     */
+    const pandora::Cluster *GetMatchedCluster(const ClusterHitPositionsVector &clusterHitPositionsVector, const TrackCandidates &trackCandidates) const;
 
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
@@ -47,6 +115,13 @@ private:
     unsigned int    m_maxSearchLayer;                   ///< Max pseudo layer to examine when calculating track-cluster distance
     float           m_parallelDistanceCut;              ///< Max allowed projection of track-hit separation along track direction
     float           m_minTrackClusterCosAngle;          ///< Min cos(angle) between track and cluster initial direction
+
+    unsigned int    m_nThreads;                         ///< Max number of threads used to find the matched cluster for each track
+    unsigned int    m_minTracksPerThread;               ///< Min number of tracks for each thread finding matched clusters
+    ParallelFor    *m_pParallelFor;                     ///< The worker pool, sized by the number of threads, reused between events
+
+    std::shared_ptr<const CaloHitSpatialIndex>  m_spHitsSpatialIndex;       ///< The shared spatial index of the current calo hits, held until Reset
+    std::shared_ptr<const TrackProjectionIndex> m_spTrackProjectionIndex;   ///< The shared projection index of the current tracks, held until Reset
 };
 
 } // namespace lc_content
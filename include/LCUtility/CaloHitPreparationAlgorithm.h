@@ -10,11 +10,13 @@
 
 #include "Pandora/Algorithm.h"
 
+#include <memory>
+
 namespace lc_content
 {
 
-template<typename, unsigned int> class KDTreeLinkerAlgo;
 template<typename, unsigned int> class KDTreeNodeInfoT;
+class CaloHitSpatialIndex;
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -24,7 +26,6 @@ template<typename, unsigned int> class KDTreeNodeInfoT;
 class CaloHitPreparationAlgorithm : public pandora::Algorithm
 {
 public:
-    typedef KDTreeLinkerAlgo<const pandora::CaloHit*, 4> HitKDTree4D;
     typedef KDTreeNodeInfoT<const pandora::CaloHit*, 4> HitKDNode4D;
 
     /**
@@ -32,20 +33,9 @@ public:
      */
     CaloHitPreparationAlgorithm();
 
-    /**
-     * @brief Destructor
-     */
-    ~CaloHitPreparationAlgorithm();
-
 private:
     pandora::StatusCode Run();
-
-    /**
-     *  @brief  Initialize a kd-tree of the input hits to the preparation alg.
-     * 
-     *  @param  pCaloHitList -- the calorimeter hit list
-     */
-    void InitializeKDTree(const pandora::CaloHitList *const pCaloHitList);
+    pandora::StatusCode Reset();
 
     /**
      *  @brief  Calculate calo hit properties for a particular calo hit, through comparison with an ordered list of other hits.
@@ -90,8 +80,7 @@ private:
     unsigned int    m_mipNCellsForNearbyHit;            ///< Separation (in calo cells) for hits to be declared "nearby"
     unsigned int    m_mipMaxNearbyHits;                 ///< Max number of "nearby" hits for hit to be flagged as possible mip
 
-    std::vector<HitKDNode4D>   *m_hitNodes4D;           ///< nodes for the KD tree (used for filling)
-    HitKDTree4D                *m_hitsKdTree4D;         ///< the kd-tree itself, 4D in x,y,z,pseudolayer
+    std::shared_ptr<const CaloHitSpatialIndex>  m_spSpatialIndex;   ///< The shared spatial index of the input hits, held until Reset
 };
 
 } // namespace lc_content
@@ -0,0 +1,150 @@
+/**
+ *  @file   LCContent/include/LCUtility/CaloHitSpatialIndex.h
+ * 
+ *  @brief  Header file for the calo hit spatial index class.
+ * 
+ *  $Log: $
+ */
+#ifndef LC_CALO_HIT_SPATIAL_INDEX_H
+#define LC_CALO_HIT_SPATIAL_INDEX_H 1
+
+#include "Pandora/PandoraInternal.h"
+
+#include "LCUtility/KDTreeLinkerAlgoT.h"
+
+#include <memory>
+#include <mutex>
+
+namespace pandora { class Algorithm; }
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lc_content
+{
+
+/**
+ *  @brief  CaloHitSpatialIndex class, read-only kd-trees of the hits in a calo hit list, in x,y,z and in x,y,z,pseudolayer.
+ * 
+ *  A single index may be shared by all algorithms working on the same calo hit list in an event: a new index is only built when no index
+ *  held by an algorithm was built from the same list. Each kd-tree is built when it is first requested, so that algorithms needing only
+ *  one of the trees do not pay for the other. The index ignores calo hit availability and cluster ownership, so any such requirements
+ *  must be applied by the caller to the hits found by each query.
+ */
+class CaloHitSpatialIndex
+{
+public:
+    typedef KDTreeLinkerAlgo<const pandora::CaloHit*, 3> HitKDTree3D;
+    typedef KDTreeNodeInfoT<const pandora::CaloHit*, 3> HitKDNode3D;
+    typedef KDTreeLinkerAlgo<const pandora::CaloHit*, 4> HitKDTree4D;
+    typedef KDTreeNodeInfoT<const pandora::CaloHit*, 4> HitKDNode4D;
+
+    /**
+     *  @brief  Get the index of a calo hit list shared by all algorithms running in the same pandora instance, building a new index
+     *          only if no index of the same list is currently held
+     * 
+     *  @param  algorithm the algorithm requesting the index
+     *  @param  caloHitList the calo hit list
+     * 
+     *  @return the shared index, which the caller owns jointly and must release no later than its Reset, at the end of the event
+     */
+    static std::shared_ptr<const CaloHitSpatialIndex> GetSharedIndex(const pandora::Algorithm &algorithm, const pandora::CaloHitList &caloHitList);
+
+    /**
+     *  @brief  Constructor, building an index of a calo hit list
+     * 
+     *  @param  caloHitList the calo hit list
+     */
+    explicit CaloHitSpatialIndex(const pandora::CaloHitList &caloHitList);
+
+    /**
+     *  @brief  Whether a calo hit is included in the index
+     * 
+     *  @param  pCaloHit address of the calo hit
+     * 
+     *  @return boolean
+     */
+    bool IsIndexed(const pandora::CaloHit *const pCaloHit) const;
+
+    /**
+     *  @brief  Whether the index was built from the calo hit list provided, identified by its address, its size and its first and last hits.
+     *          Calo hits, with their positions and pseudo layers, are fixed for the event, as is the content of any list still in use.
+     * 
+     *  @param  caloHitList the calo hit list
+     * 
+     *  @return boolean
+     */
+    bool IsIndexOf(const pandora::CaloHitList &caloHitList) const;
+
+    /**
+     *  @brief  Get the kd-tree of the indexed hits, in x,y,z, building it if this is the first request. May be called concurrently.
+     * 
+     *  @return the kd-tree
+     */
+    const HitKDTree3D &GetKDTree3D() const;
+
+    /**
+     *  @brief  Get the kd-tree of the indexed hits, in x,y,z,pseudolayer, building it if this is the first request. May be called
+     *          concurrently.
+     * 
+     *  @return the kd-tree
+     */
+    const HitKDTree4D &GetKDTree4D() const;
+
+private:
+    /**
+     *  @brief  Build the kd-tree of the indexed hits, in x,y,z
+     */
+    void BuildKDTree3D() const;
+
+    /**
+     *  @brief  Build the kd-tree of the indexed hits, in x,y,z,pseudolayer
+     */
+    void BuildKDTree4D() const;
+
+    const pandora::CaloHitList *m_pCaloHitList;         ///< Address of the calo hit list from which the index was built
+    const pandora::CaloHit     *m_pFirstCaloHit;        ///< Address of the first calo hit in the list, null if the list is empty
+    const pandora::CaloHit     *m_pLastCaloHit;         ///< Address of the last calo hit in the list, null if the list is empty
+    std::vector<HitKDNode4D>    m_listNodes;            ///< The kd-tree nodes for the indexed hits, in calo hit list order
+    pandora::CaloHitSet         m_caloHitSet;           ///< The indexed hits
+    mutable std::once_flag      m_kdTree3DFlag;         ///< Whether the 3D kd-tree has been built
+    mutable HitKDTree3D         m_kdTree3D;             ///< The kd-tree, 3D in x,y,z
+    mutable std::once_flag      m_kdTree4DFlag;         ///< Whether the 4D kd-tree has been built
+    mutable HitKDTree4D         m_kdTree4D;             ///< The kd-tree, 4D in x,y,z,pseudolayer
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool CaloHitSpatialIndex::IsIndexed(const pandora::CaloHit *const pCaloHit) const
+{
+    return (m_caloHitSet.count(pCaloHit) > 0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool CaloHitSpatialIndex::IsIndexOf(const pandora::CaloHitList &caloHitList) const
+{
+    if ((&caloHitList != m_pCaloHitList) || (caloHitList.size() != m_listNodes.size()))
+        return false;
+
+    return (caloHitList.empty() || ((caloHitList.front() == m_pFirstCaloHit) && (caloHitList.back() == m_pLastCaloHit)));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const CaloHitSpatialIndex::HitKDTree3D &CaloHitSpatialIndex::GetKDTree3D() const
+{
+    std::call_once(m_kdTree3DFlag, &CaloHitSpatialIndex::BuildKDTree3D, this);
+    return m_kdTree3D;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const CaloHitSpatialIndex::HitKDTree4D &CaloHitSpatialIndex::GetKDTree4D() const
+{
+    std::call_once(m_kdTree4DFlag, &CaloHitSpatialIndex::BuildKDTree4D, this);
+    return m_kdTree4D;
+}
+
+} // namespace lc_content
+
+#endif // #ifndef LC_CALO_HIT_SPATIAL_INDEX_H
@@ -0,0 +1,81 @@
+/**
+ *  @file   LCContent/include/LCUtility/ClusterHitPositions.h
+ * 
+ *  @brief  Header file for the cluster hit positions class.
+ * 
+ *  $Log: $
+ */
+#ifndef LC_CLUSTER_HIT_POSITIONS_H
+#define LC_CLUSTER_HIT_POSITIONS_H 1
+
+#include "Pandora/PandoraInternal.h"
+
+#include <vector>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lc_content
+{
+
+/**
+ *  @brief  ClusterHitPositions class, a read-only copy of the positions of the hits in the inner pseudo layers of a cluster, held in contiguous
+ *          arrays (one per coordinate) so that the distances from a track state to many hits can be evaluated in a single, vectorizable pass.
+ * 
+ *  The hits are held in ordered calo hit list order, with the index one past the last hit of each pseudo layer, so that a pass may stop at
+ *  any pseudo layer. A copy only pays off when the same cluster is to be examined for several track states.
+ */
+class ClusterHitPositions
+{
+public:
+    /**
+     *  @brief  Constructor, copying the positions of the hits in the cluster, up to and including a specified pseudo layer
+     * 
+     *  @param  pCluster address of the cluster
+     *  @param  maxPseudoLayer the maximum pseudo layer from which to copy hit positions
+     */
+    ClusterHitPositions(const pandora::Cluster *const pCluster, const unsigned int maxPseudoLayer);
+
+    /**
+     *  @brief  Get the address of the cluster
+     * 
+     *  @return the address of the cluster
+     */
+    const pandora::Cluster *GetCluster() const;
+
+    /**
+     *  @brief  Get the smallest squared perpendicular distance between the projected track direction and the hits in the cluster, considering
+     *          only hits up to a specified pseudo layer and within a specified distance of the track position along the track direction
+     * 
+     *  @param  trackPosition the track position
+     *  @param  trackDirection the track unit direction
+     *  @param  maxSearchLayer the maximum pseudo layer to examine, which must not exceed the maximum pseudo layer from which positions were copied
+     *  @param  parallelDistanceCut maximum allowed projection of track-hit separation along track direction
+     *  @param  minDistanceSquared to receive the smallest squared perpendicular distance, if any hit passes the parallel distance cut
+     * 
+     *  @return whether any hit passes the parallel distance cut
+     */
+    bool GetMinPerpendicularDistanceSquared(const pandora::CartesianVector &trackPosition, const pandora::CartesianVector &trackDirection,
+        const unsigned int maxSearchLayer, const float parallelDistanceCut, float &minDistanceSquared) const;
+
+private:
+    const pandora::Cluster     *m_pCluster;                 ///< Address of the cluster
+    unsigned int                m_maxPseudoLayer;           ///< The maximum pseudo layer from which hit positions were copied
+    pandora::FloatVector        m_x;                        ///< The hit x coordinates, in ordered calo hit list order
+    pandora::FloatVector        m_y;                        ///< The hit y coordinates, in ordered calo hit list order
+    pandora::FloatVector        m_z;                        ///< The hit z coordinates, in ordered calo hit list order
+    pandora::UIntVector         m_pseudoLayers;             ///< The occupied pseudo layers, in increasing order
+    pandora::UIntVector         m_layerEndIndices;          ///< The index one past the last hit in each occupied pseudo layer
+};
+
+typedef std::vector<ClusterHitPositions> ClusterHitPositionsVector;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const pandora::Cluster *ClusterHitPositions::GetCluster() const
+{
+    return m_pCluster;
+}
+
+} // namespace lc_content
+
+#endif // #ifndef LC_CLUSTER_HIT_POSITIONS_H
@@ -0,0 +1,94 @@
+/**
+ *  @file   LCContent/include/LCUtility/HelixTrajectory.h
+ * 
+ *  @brief  Header file for the helix trajectory class.
+ * 
+ *  $Log: $
+ */
+#ifndef LC_HELIX_TRAJECTORY_H
+#define LC_HELIX_TRAJECTORY_H 1
+
+#include "Objects/Helix.h"
+
+#include "Pandora/PandoraInternal.h"
+#include "Pandora/StatusCodes.h"
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lc_content
+{
+
+/**
+ *  @brief  HelixTrajectory class, a helix together with the memoized results of its extrapolation: the number of pseudo layers crossed
+ *          between pairs of z coordinates, sampled as by FragmentRemovalHelper::GetNLayersCrossed, and the distances to calo hits.
+ * 
+ *  Each result is evaluated with exactly the same calculation as an uncached call, so is identical to it. The memoized results may be
+ *  shared between threads, but are only valid for as long as the calo hits are unchanged.
+ */
+class HelixTrajectory
+{
+public:
+    /**
+     *  @brief  Constructor
+     * 
+     *  @param  pandora the associated pandora instance
+     *  @param  helix the helix
+     */
+    HelixTrajectory(const pandora::Pandora &pandora, const pandora::Helix &helix);
+
+    /**
+     *  @brief  Get the helix
+     * 
+     *  @return the helix
+     */
+    const pandora::Helix &GetHelix() const;
+
+    /**
+     *  @brief  Get the number of pseudo layers crossed by the helix in specified range of z coordinates, sampling the helix at the
+     *          default number of points
+     * 
+     *  @param  zStart start z coordinate
+     *  @param  zEnd end z coordinate
+     * 
+     *  @return The number of pseudo layers crossed
+     */
+    unsigned int GetNLayersCrossed(const float zStart, const float zEnd) const;
+
+    /**
+     *  @brief  Get the distances of closest approach between the helix and a list of calo hits
+     * 
+     *  @param  caloHitList the calo hit list
+     *  @param  distances to receive the distance to each calo hit, in calo hit list order
+     */
+    pandora::StatusCode GetDistancesToHits(const pandora::CaloHitList &caloHitList, pandora::FloatVector &distances) const;
+
+private:
+    typedef std::map<std::pair<float, float>, unsigned int> LayersCrossedMap;
+    typedef std::unordered_map<const pandora::CaloHit*, float> HitToDistanceMap;
+
+    const pandora::Pandora     &m_pandora;                  ///< The associated pandora instance
+    const pandora::Helix        m_helix;                    ///< The helix
+
+    mutable std::mutex          m_mutex;                    ///< The mutex guarding the memoized results
+    mutable LayersCrossedMap    m_layersCrossedMap;         ///< The number of pseudo layers crossed between each (start, end) z coordinate pair
+    mutable HitToDistanceMap    m_hitToDistanceMap;         ///< The distance of closest approach to each calo hit
+};
+
+typedef std::unordered_map<const pandora::Track*, std::unique_ptr<const HelixTrajectory> > TrackToHelixTrajectoryMap;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const pandora::Helix &HelixTrajectory::GetHelix() const
+{
+    return m_helix;
+}
+
+} // namespace lc_content
+
+#endif // #ifndef LC_HELIX_TRAJECTORY_H
@@ -10,6 +10,10 @@
 
 #include "LCUtility/KDTreeLinkerToolsT.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
 #include <vector>
 
 namespace lc_content
@@ -17,6 +21,19 @@ namespace lc_content
 
 /**
  *  @brief  Class that implements the KDTree partition of 2D space and a closest point search algorithm
+ * 
+ *  The tree is held in flat arrays: nodes are addressed by index and the element coordinates are stored as a structure of arrays,
+ *  ordered so that every node region maps onto a contiguous element range. Leaves hold small buckets of elements, which are
+ *  range-tested with simple loops over the contiguous coordinates, suitable for vectorisation. Nearest neighbour searches keep a
+ *  bounded priority queue of the best elements found, pruning any subtree whose region lies beyond the current worst of them.
+ * 
+ *  Once built, the tree is never modified by a query: all query methods are const and keep their working state in a per-call search
+ *  context, so a single tree may be queried concurrently from several threads. Nearest neighbour searches may instead be given a
+ *  KDTreeNeighbourSearchBuffer, owned by the caller, whose storage is reused from one search to the next.
+ * 
+ *  Elements may be erased and inserted after the tree is built. Erased elements are masked, with each node counting its live elements
+ *  so that searches skip fully erased subtrees. Inserted elements restore a matching erased element in place, or are otherwise held in
+ *  a small insertion buffer. The tree is rebuilt from its live elements once the buffer or the fraction of erased elements grows large.
  */
 template <typename DATA, unsigned DIM = 2>
 class KDTreeLinkerAlgo
@@ -44,10 +61,12 @@ public:
      *  @brief  Search in the KDTree for all points that would be contained in the given searchbox
      *          The founded points are stored in resRecHitList
      * 
+     *  The search box bounds are inclusive: a point lying exactly on a boundary is always found.
+     * 
      *  @param  searchBox
      *  @param  resRecHitList
      */
-    void search(const KDTreeBoxT<DIM> &searchBox, std::vector<KDTreeNodeInfoT<DATA, DIM> > &resRecHitList);
+    void search(const KDTreeBoxT<DIM> &searchBox, std::vector<KDTreeNodeInfoT<DATA, DIM> > &resRecHitList) const;
 
     /**
      *  @brief  findNearestNeighbour
@@ -56,21 +75,120 @@ public:
      *  @param  result
      *  @param  distance
      */
-    void findNearestNeighbour(const KDTreeNodeInfoT<DATA, DIM> &point, const KDTreeNodeInfoT<DATA, DIM> *&result, float &distance);
+    void findNearestNeighbour(const KDTreeNodeInfoT<DATA, DIM> &point, const KDTreeNodeInfoT<DATA, DIM> *&result, float &distance) const;
+
+    /**
+     *  @brief  Find the element nearest to a point, considering only elements within a maximum distance and accepted by a filter
+     * 
+     *  @param  point the search point
+     *  @param  maxDistance the maximum distance between the search point and the element
+     *  @param  result to receive the address of the nearest element, nullptr if none is found
+     *  @param  distance to receive the distance to the nearest element
+     *  @param  filter functor returning whether an element may be considered
+     */
+    template <typename FILTER = KDTreeAcceptAll>
+    void findNearestNeighbour(const KDTreeNodeInfoT<DATA, DIM> &point, const float maxDistance, const KDTreeNodeInfoT<DATA, DIM> *&result,
+        float &distance, const FILTER &filter = FILTER()) const;
+
+    /**
+     *  @brief  Find the element nearest to a point, considering only elements within a maximum distance and accepted by a filter
+     * 
+     *  @param  point the search point
+     *  @param  maxDistance the maximum distance between the search point and the element
+     *  @param  result to receive the address of the nearest element, nullptr if none is found
+     *  @param  distance to receive the distance to the nearest element
+     *  @param  buffer the working storage for the search
+     *  @param  filter functor returning whether an element may be considered
+     */
+    template <typename FILTER = KDTreeAcceptAll>
+    void findNearestNeighbour(const KDTreeNodeInfoT<DATA, DIM> &point, const float maxDistance, const KDTreeNodeInfoT<DATA, DIM> *&result,
+        float &distance, KDTreeNeighbourSearchBuffer &buffer, const FILTER &filter = FILTER()) const;
+
+    /**
+     *  @brief  Find the k elements nearest to a point, considering only elements within a maximum distance and accepted by a filter.
+     *          The elements are returned in order of increasing distance, with equidistant elements kept in tree order
+     * 
+     *  @param  point the search point
+     *  @param  nNeighbours the maximum number of elements to find
+     *  @param  maxDistance the maximum distance between the search point and the elements
+     *  @param  result to receive the elements found
+     *  @param  filter functor returning whether an element may be considered
+     */
+    template <typename FILTER = KDTreeAcceptAll>
+    void findKNearestNeighbours(const KDTreeNodeInfoT<DATA, DIM> &point, const unsigned nNeighbours, const float maxDistance,
+        std::vector<KDTreeNeighbourT<DATA, DIM> > &result, const FILTER &filter = FILTER()) const;
+
+    /**
+     *  @brief  Find the k elements nearest to a point, considering only elements within a maximum distance and accepted by a filter.
+     *          The elements are returned in order of increasing distance, with equidistant elements kept in tree order
+     * 
+     *  @param  point the search point
+     *  @param  nNeighbours the maximum number of elements to find
+     *  @param  maxDistance the maximum distance between the search point and the elements
+     *  @param  result to receive the elements found
+     *  @param  buffer the working storage for the search
+     *  @param  filter functor returning whether an element may be considered
+     */
+    template <typename FILTER = KDTreeAcceptAll>
+    void findKNearestNeighbours(const KDTreeNodeInfoT<DATA, DIM> &point, const unsigned nNeighbours, const float maxDistance,
+        std::vector<KDTreeNeighbourT<DATA, DIM> > &result, KDTreeNeighbourSearchBuffer &buffer, const FILTER &filter = FILTER()) const;
+
+    /**
+     *  @brief  Find every element within a tolerance of the element nearest to a point, considering only elements within a maximum
+     *          distance and accepted by a filter. The elements are returned as by findKNearestNeighbours
+     * 
+     *  This nominates the candidates for a choice that the caller makes using its own, exact distance comparisons. The tree compares
+     *  distances evaluated with different rounding, so the element that the caller would choose may appear marginally further away than
+     *  the nearest element found by the tree. The tolerance, added both to the maximum distance and to the nearest distance, covers this
+     *  difference, so that every element that could be chosen is nominated.
+     * 
+     *  @param  point the search point
+     *  @param  maxDistance the maximum distance between the search point and the elements, before the tolerance is added
+     *  @param  tolerance the distance tolerance
+     *  @param  result to receive the elements found
+     *  @param  buffer the working storage for the search
+     *  @param  filter functor returning whether an element may be considered
+     */
+    template <typename FILTER = KDTreeAcceptAll>
+    void findNearestCandidates(const KDTreeNodeInfoT<DATA, DIM> &point, const float maxDistance, const float tolerance,
+        std::vector<KDTreeNeighbourT<DATA, DIM> > &result, KDTreeNeighbourSearchBuffer &buffer, const FILTER &filter = FILTER()) const;
 
     /**
      *  @brief  Whether the tree is empty
      * 
      *  @return boolean
      */
-    bool empty();
+    bool empty() const;
 
     /**
-     *  @brief  Return the number of nodes + leaves in the tree (nElements should be (size() +1) / 2)
+     *  @brief  Return the number of nodes + leaves in the tree
      * 
      *  @return the number of nodes + leaves in the tree
      */
-    int size();
+    int size() const;
+
+    /**
+     *  @brief  Get the number of live elements, i.e. those built or inserted into the tree and not subsequently erased
+     * 
+     *  @return the number of live elements
+     */
+    unsigned nLiveElements() const;
+
+    /**
+     *  @brief  Insert an element into the tree
+     * 
+     *  @param  element the element to insert
+     */
+    void insert(const KDTreeNodeInfoT<DATA, DIM> &element);
+
+    /**
+     *  @brief  Erase an element from the tree, so that it is no longer returned by any search
+     * 
+     *  @param  element the element to erase, identified by its data and coordinates
+     * 
+     *  @return whether a live element was found and erased
+     */
+    bool erase(const KDTreeNodeInfoT<DATA, DIM> &element);
 
     /**
      *  @brief  Clear all allocated structures
@@ -78,94 +196,214 @@ public:
     void clear();
 
 private:
+    typedef std::pair<float, unsigned> DistanceIndexPair;   ///< Squared distance to the search point and index of an element
+
     /**
-     *  @brief  Get the next node from the node pool
-     * 
-     *  @return the next node from the node pool
+     *  @brief  RangeSearchContext class, holding the state of a single range search
      */
-    KDTreeNodeT<DATA, DIM> *getNextNode();
+    class RangeSearchContext
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         * 
+         *  @param  searchBox the search box
+         *  @param  result the vector to which the elements found are appended
+         */
+        RangeSearchContext(const KDTreeBoxT<DIM> &searchBox, std::vector<KDTreeNodeInfoT<DATA, DIM> > &result);
+
+        const KDTreeBoxT<DIM>                      &m_searchBox;    ///< The search box
+        std::vector<KDTreeNodeInfoT<DATA, DIM> >   &m_result;       ///< The vector to which the elements found are appended
+    };
+
+    /**
+     *  @brief  NeighbourSearchContext class, holding the state of a single nearest neighbours search
+     */
+    template <typename FILTER>
+    class NeighbourSearchContext
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         * 
+         *  @param  point the search point
+         *  @param  nNeighbours the maximum number of elements to find
+         *  @param  maxDist2 the initial maximum squared distance between the search point and the elements
+         *  @param  filter functor returning whether an element may be considered
+         *  @param  bestHeap the storage for the heap of the best elements found
+         */
+        NeighbourSearchContext(const KDTreeNodeInfoT<DATA, DIM> &point, const unsigned nNeighbours, const float maxDist2, const FILTER &filter,
+            std::vector<DistanceIndexPair> &bestHeap);
+
+        const KDTreeNodeInfoT<DATA, DIM>           &m_point;        ///< The search point
+        const unsigned                              m_nNeighbours;  ///< The maximum number of elements to find
+        const FILTER                               &m_filter;       ///< Functor returning whether an element may be considered
+        float                                       m_maxDist2;     ///< The current maximum squared distance, shrinking as elements are found
+        std::vector<DistanceIndexPair>             &m_bestHeap;     ///< Max-heap of the best elements found so far, its front being the worst
+    };
 
     /**
      *  @brief  Fast median search with Wirth algorithm in eltList between low and high indexes.
      * 
+     *  @param  eltList
      *  @param  low
      *  @param  high
      *  @param  treeDepth
      */
-    int medianSearch(int low, int high, int treeDepth);
+    int medianSearch(std::vector<KDTreeNodeInfoT<DATA, DIM> > &eltList, int low, int high, int treeDepth) const;
 
     /**
      *  @brief  Recursive kdtree builder. Is called by build()
      * 
+     *  @param  eltList
      *  @param  low
      *  @param  high
      *  @param  depth
      *  @param  region
+     * 
+     *  @return the index of the node created
+     */
+    unsigned recBuild(std::vector<KDTreeNodeInfoT<DATA, DIM> > &eltList, int low, int high, int depth, const KDTreeBoxT<DIM> &region);
+
+    /**
+     *  @brief  Recursive median partition of the elements in a leaf bucket, so that they are ordered exactly as the leaves of a tree
+     *          with one element per leaf. Is called by recBuild()
+     * 
+     *  @param  eltList
+     *  @param  low
+     *  @param  high
+     *  @param  depth
      */
-    KDTreeNodeT<DATA, DIM> *recBuild(int low, int high, int depth, const KDTreeBoxT<DIM> &region);
+    void recPartition(std::vector<KDTreeNodeInfoT<DATA, DIM> > &eltList, int low, int high, int depth) const;
 
     /**
      *  @brief  Recursive kdtree search. Is called by search()
      * 
-     *  @param  current
-     *  @param  trackBox
+     *  @param  nodeIndex
+     *  @param  context
      */
-    void recSearch(const KDTreeNodeT<DATA, DIM> *current, const KDTreeBoxT<DIM> &trackBox);
+    void recSearch(unsigned nodeIndex, RangeSearchContext &context) const;
 
     /**
-     *  @brief  Recursive nearest neighbour search. Is called by findNearestNeighbour()
+     *  @brief  Range-test all elements in a leaf bucket, adding those inside the box to the search results
      * 
-     *  @param  depth
-     *  @param  current
-     *  @param  point
-     *  @param  best_match
-     *  @param  best_dist
+     *  @param  leaf
+     *  @param  context
      */
-    void recNearestNeighbour(unsigned depth, const KDTreeNodeT<DATA, DIM> *current, const KDTreeNodeInfoT<DATA, DIM> &point,
-          const KDTreeNodeT<DATA, DIM> *&best_match, float &best_dist);
+    void searchLeaf(const KDTreeNodeT<DIM> &leaf, RangeSearchContext &context) const;
 
     /**
-     *  @brief  Add all elements of an subtree to the closest elements. Used during the recSearch().
+     *  @brief  Nearest neighbours search over the tree and the insertion buffer, leaving the best elements found sorted by increasing
+     *          distance. Is called by findNearestNeighbour() and findKNearestNeighbours()
+     * 
+     *  @param  context
+     */
+    template <typename FILTER>
+    void searchNearestNeighbours(NeighbourSearchContext<FILTER> &context) const;
+
+    /**
+     *  @brief  Recursive k nearest neighbours search. Is called by searchNearestNeighbours()
+     * 
+     *  @param  nodeIndex
+     *  @param  context
+     */
+    template <typename FILTER>
+    void recKNearestNeighbours(unsigned nodeIndex, NeighbourSearchContext<FILTER> &context) const;
+
+    /**
+     *  @brief  Add all elements of an subtree to the search results. Used during the recSearch().
      * 
      *  @param  current
+     *  @param  context
+     */
+    void addSubtree(const KDTreeNodeT<DIM> &current, RangeSearchContext &context) const;
+
+    /**
+     *  @brief  Range-test all elements in the insertion buffer, adding those inside the box to the search results
+     * 
+     *  @param  context
+     */
+    void searchInsertBuffer(RangeSearchContext &context) const;
+
+    /**
+     *  @brief  Recursive search for a tree element matching a given element, setting its live status. Is called by insert() and erase()
+     * 
+     *  @param  nodeIndex
+     *  @param  element
+     *  @param  isLive
+     * 
+     *  @return whether an element with the opposite live status was found and updated
      */
-    void addSubtree(const KDTreeNodeT<DATA, DIM> *current);
+    bool recSetLive(unsigned nodeIndex, const KDTreeNodeInfoT<DATA, DIM> &element, const bool isLive);
+
+    /**
+     *  @brief  Rebuild the tree from its live elements, emptying the insertion buffer and discarding all erased elements
+     */
+    void rebuild();
+
+    /**
+     *  @brief  Get the address of an element, indexing the tree elements followed by those in the insertion buffer
+     * 
+     *  @param  index
+     * 
+     *  @return the address of the element
+     */
+    const KDTreeNodeInfoT<DATA, DIM> *getElement(const unsigned index) const;
 
     /**
      *  @brief  dist2
      * 
-     *  @param  a
-     *  @param  b
+     *  @param  point
+     *  @param  index
      * 
      *  @return dist2
      */
-    float dist2(const KDTreeNodeInfoT<DATA, DIM> &a, const KDTreeNodeInfoT<DATA, DIM> &b) const;
+    float dist2(const KDTreeNodeInfoT<DATA, DIM> &point, const unsigned index) const;
+
+    /**
+     *  @brief  dist2
+     * 
+     *  @param  point
+     *  @param  element
+     * 
+     *  @return dist2
+     */
+    float dist2(const KDTreeNodeInfoT<DATA, DIM> &point, const KDTreeNodeInfoT<DATA, DIM> &element) const;
+
+    /**
+     *  @brief  Get the squared distance between a point and the closest edge of a region, zero if the point lies inside it
+     * 
+     *  @param  point
+     *  @param  region
+     * 
+     *  @return dist2
+     */
+    float dist2ToRegion(const KDTreeNodeInfoT<DATA, DIM> &point, const KDTreeBoxT<DIM> &region) const;
 
     /**
      *  @brief  Frees the KDTree.
      */
     void clearTree();
 
-    KDTreeNodeT<DATA, DIM>                     *root_;              ///< The KDTree root
-    KDTreeNodeT<DATA, DIM>                     *nodePool_;          ///< Node pool allows us to do just 1 call to new for each tree building
-    int                                         nodePoolSize_;      ///< The node pool size
-    int                                         nodePoolPos_;       ///< The node pool position
+    static constexpr unsigned                   maxBucketSize_ = 8; ///< The maximum number of elements in a leaf bucket
 
-    std::vector<KDTreeNodeInfoT<DATA, DIM> >   *closestNeighbour;   ///< The closest neighbour
-    std::vector<KDTreeNodeInfoT<DATA, DIM> >   *initialEltList;     ///< The initial element list
+    std::vector<KDTreeNodeT<DIM> >              nodes_;             ///< The KDTree nodes, root first, stored in depth-first order
+    std::vector<KDTreeNodeInfoT<DATA, DIM> >    elements_;          ///< The tree elements, ordered such that each node has a contiguous range
+    std::array<std::vector<float>, DIM>         elementDims_;       ///< The element coordinates, stored as one contiguous array per dimension
+    std::vector<unsigned char>                  elementLive_;       ///< The live mask, whether each tree element has not been erased
+    std::vector<KDTreeNodeInfoT<DATA, DIM> >    insertBuffer_;      ///< The elements inserted since the tree was last built
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename DATA, unsigned DIM>
-inline KDTreeLinkerAlgo<DATA, DIM>::KDTreeLinkerAlgo() :
-    root_(nullptr),
-    nodePool_(nullptr),
-    nodePoolSize_(-1),
-    nodePoolPos_(-1),
-    closestNeighbour(nullptr),
-    initialEltList(nullptr)
+constexpr unsigned KDTreeLinkerAlgo<DATA, DIM>::maxBucketSize_;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+inline KDTreeLinkerAlgo<DATA, DIM>::KDTreeLinkerAlgo()
 {
 }
 
@@ -179,27 +417,63 @@ inline KDTreeLinkerAlgo<DATA, DIM>::~KDTreeLinkerAlgo()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+template <typename DATA, unsigned DIM>
+inline KDTreeLinkerAlgo<DATA, DIM>::RangeSearchContext::RangeSearchContext(const KDTreeBoxT<DIM> &searchBox,
+        std::vector<KDTreeNodeInfoT<DATA, DIM> > &result) :
+    m_searchBox(searchBox),
+    m_result(result)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+template <typename FILTER>
+inline KDTreeLinkerAlgo<DATA, DIM>::NeighbourSearchContext<FILTER>::NeighbourSearchContext(const KDTreeNodeInfoT<DATA, DIM> &point,
+        const unsigned nNeighbours, const float maxDist2, const FILTER &filter, std::vector<DistanceIndexPair> &bestHeap) :
+    m_point(point),
+    m_nNeighbours(nNeighbours),
+    m_filter(filter),
+    m_maxDist2(maxDist2),
+    m_bestHeap(bestHeap)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 template <typename DATA, unsigned DIM>
 inline void KDTreeLinkerAlgo<DATA, DIM>::build(std::vector<KDTreeNodeInfoT<DATA, DIM> > &eltList, const KDTreeBoxT<DIM> &region)
 {
+    this->clear();
+
     if (eltList.size())
     {
-        initialEltList = &eltList;
-        const size_t mysize = initialEltList->size();
+        const size_t mysize = eltList.size();
 
-        nodePoolSize_ = mysize * 2 - 1;
-        nodePool_ = new KDTreeNodeT<DATA, DIM>[nodePoolSize_];
+        // Leaf buckets are at least half full, so this bounds the number of nodes
+        nodes_.reserve(4 * mysize / maxBucketSize_ + 1);
 
-        // Here we build the KDTree
-        root_ = this->recBuild(0, mysize, 0, region);
-        initialEltList = nullptr;
+        // Here we build the KDTree, which also sorts the element list into its final order
+        this->recBuild(eltList, 0, mysize, 0, region);
+
+        elements_.assign(eltList.begin(), eltList.end());
+
+        for (unsigned i = 0; i < DIM; ++i)
+        {
+            elementDims_[i].resize(mysize);
+
+            for (size_t j = 0; j < mysize; ++j)
+                elementDims_[i][j] = elements_[j].dims[i];
+        }
+
+        elementLive_.assign(mysize, 1);
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename DATA, unsigned DIM>
-inline int KDTreeLinkerAlgo<DATA, DIM>::medianSearch(int low, int high, int treeDepth)
+inline int KDTreeLinkerAlgo<DATA, DIM>::medianSearch(std::vector<KDTreeNodeInfoT<DATA, DIM> > &eltList, int low, int high, int treeDepth) const
 {
     // We should have at least 1 element to calculate the median...
     //assert(low < high);
@@ -213,7 +487,7 @@ inline int KDTreeLinkerAlgo<DATA, DIM>::medianSearch(int low, int high, int tree
 
     while (l < m)
     {
-        KDTreeNodeInfoT<DATA, DIM> elt = (*initialEltList)[median];
+        KDTreeNodeInfoT<DATA, DIM> elt = eltList[median];
         int i = l;
         int j = m;
 
@@ -221,12 +495,12 @@ inline int KDTreeLinkerAlgo<DATA, DIM>::medianSearch(int low, int high, int tree
         {
             // The even depth is associated to dim1 dimension, the odd one to dim2 dimension
             const unsigned thedim = treeDepth % DIM;
-            while ((*initialEltList)[i].dims[thedim] < elt.dims[thedim]) ++i;
-            while ((*initialEltList)[j].dims[thedim] > elt.dims[thedim]) --j;
+            while (eltList[i].dims[thedim] < elt.dims[thedim]) ++i;
+            while (eltList[j].dims[thedim] > elt.dims[thedim]) --j;
 
             if (i <= j)
             {
-                std::swap((*initialEltList)[i], (*initialEltList)[j]);
+                std::swap(eltList[i], eltList[j]);
                 i++;
                 j--;
             }
@@ -243,206 +517,474 @@ inline int KDTreeLinkerAlgo<DATA, DIM>::medianSearch(int low, int high, int tree
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename DATA, unsigned DIM>
-inline void KDTreeLinkerAlgo<DATA, DIM>::search(const KDTreeBoxT<DIM> &trackBox, std::vector<KDTreeNodeInfoT<DATA, DIM> > &recHits)
+inline void KDTreeLinkerAlgo<DATA, DIM>::search(const KDTreeBoxT<DIM> &trackBox, std::vector<KDTreeNodeInfoT<DATA, DIM> > &recHits) const
 {
-    if (root_)
-    {
-        closestNeighbour = &recHits;
-        this->recSearch(root_, trackBox);
-        closestNeighbour = nullptr;
-    }
+    RangeSearchContext context(trackBox, recHits);
+
+    if (!nodes_.empty())
+        this->recSearch(0, context);
+
+    if (!insertBuffer_.empty())
+        this->searchInsertBuffer(context);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename DATA, unsigned DIM>
-inline void KDTreeLinkerAlgo<DATA, DIM>::recSearch(const KDTreeNodeT<DATA, DIM> *current, const KDTreeBoxT<DIM> &trackBox)
+inline void KDTreeLinkerAlgo<DATA, DIM>::recSearch(const unsigned nodeIndex, RangeSearchContext &context) const
 {
-    // By construction, current can't be null
-    //assert(current != 0);
-    // By Construction, a node can't have just 1 son.
-    //assert (!(((current->left == 0) && (current->right != 0)) || ((current->left != 0) && (current->right == 0))));
+    const KDTreeBoxT<DIM> &trackBox(context.m_searchBox);
+    const KDTreeNodeT<DIM> &current(nodes_[nodeIndex]);
+
+    // Every element in the node region has been erased
+    if (0 == current.nLive)
+        return;
 
-    if ((current->left == nullptr) && (current->right == nullptr))
+    if (current.isLeaf())
     {
         // Leaf case
-        // If point inside the rectangle/area
-        bool isInside = true;
-
-        for (unsigned i = 0; i < DIM; ++i)
-        {
-            const auto thedim = current->info.dims[i];
-            isInside = isInside && thedim >= trackBox.dimmin[i] && thedim <= trackBox.dimmax[i];
-        }
-
-        if (isInside)
-            closestNeighbour->push_back(current->info);
+        this->searchLeaf(current, context);
     }
     else
     {
-        // Node case
+        // Node case, by construction the left son immediately follows its parent
         // If region( v->left ) is fully contained in the rectangle
+        const KDTreeNodeT<DIM> &left(nodes_[nodeIndex + 1]);
         bool isFullyContained = true;
         bool hasIntersection = true;
 
         for (unsigned i = 0; i < DIM; ++i)
         {
-            const auto regionmin = current->left->region.dimmin[i];
-            const auto regionmax = current->left->region.dimmax[i];
+            const auto regionmin = left.region.dimmin[i];
+            const auto regionmax = left.region.dimmax[i];
             isFullyContained = isFullyContained && (regionmin >= trackBox.dimmin[i] && regionmax <= trackBox.dimmax[i]);
-            hasIntersection = hasIntersection && (regionmin < trackBox.dimmax[i] && regionmax > trackBox.dimmin[i]);
+            hasIntersection = hasIntersection && (regionmin <= trackBox.dimmax[i] && regionmax >= trackBox.dimmin[i]);
         }
 
         if (isFullyContained)
         {
-            this->addSubtree(current->left);
+            this->addSubtree(left, context);
         }
         else if (hasIntersection)
         {
-            this->recSearch(current->left, trackBox);
+            this->recSearch(nodeIndex + 1, context);
         }
 
         //if region( v->right ) is fully contained in the rectangle
+        const KDTreeNodeT<DIM> &right(nodes_[current.right]);
         isFullyContained = true;
         hasIntersection = true;
 
         for (unsigned i = 0; i < DIM; ++i)
         {
-            const auto regionmin = current->right->region.dimmin[i];
-            const auto regionmax = current->right->region.dimmax[i];
+            const auto regionmin = right.region.dimmin[i];
+            const auto regionmax = right.region.dimmax[i];
             isFullyContained = isFullyContained && (regionmin >= trackBox.dimmin[i] && regionmax <= trackBox.dimmax[i]);
-            hasIntersection = hasIntersection && (regionmin < trackBox.dimmax[i] && regionmax > trackBox.dimmin[i]);
+            hasIntersection = hasIntersection && (regionmin <= trackBox.dimmax[i] && regionmax >= trackBox.dimmin[i]);
         }
 
         if (isFullyContained)
         {
-            this->addSubtree(current->right);
+            this->addSubtree(right, context);
         }
         else if (hasIntersection)
         {
-            this->recSearch(current->right, trackBox);
+            this->recSearch(current.right, context);
         }
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+template <typename DATA, unsigned DIM>
+inline void KDTreeLinkerAlgo<DATA, DIM>::searchLeaf(const KDTreeNodeT<DIM> &leaf, RangeSearchContext &context) const
+{
+    const KDTreeBoxT<DIM> &trackBox(context.m_searchBox);
+    // Branch-free range test, one dimension at a time, over the contiguous coordinates of the bucket
+    const unsigned nElements(leaf.last - leaf.first);
+    bool isInside[maxBucketSize_];
+
+    for (unsigned j = 0; j < nElements; ++j)
+        isInside[j] = (0 != elementLive_[leaf.first + j]);
+
+    for (unsigned i = 0; i < DIM; ++i)
+    {
+        const float *const pDims(elementDims_[i].data() + leaf.first);
+        const float dimmin(trackBox.dimmin[i]), dimmax(trackBox.dimmax[i]);
+
+        for (unsigned j = 0; j < nElements; ++j)
+            isInside[j] = isInside[j] & (pDims[j] >= dimmin) & (pDims[j] <= dimmax);
+    }
+
+    for (unsigned j = 0; j < nElements; ++j)
+    {
+        if (isInside[j])
+            context.m_result.push_back(elements_[leaf.first + j]);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 template <typename DATA, unsigned DIM>
 inline void KDTreeLinkerAlgo<DATA, DIM>::findNearestNeighbour(const KDTreeNodeInfoT<DATA, DIM> &point, const KDTreeNodeInfoT<DATA, DIM> *&result,
-    float &distance)
+    float &distance) const
 {
-    if (nullptr != result || distance != std::numeric_limits<float>::max())
+    this->findNearestNeighbour(point, std::numeric_limits<float>::max(), result, distance);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+template <typename FILTER>
+inline void KDTreeLinkerAlgo<DATA, DIM>::findNearestNeighbour(const KDTreeNodeInfoT<DATA, DIM> &point, const float maxDistance,
+    const KDTreeNodeInfoT<DATA, DIM> *&result, float &distance, const FILTER &filter) const
+{
+    KDTreeNeighbourSearchBuffer buffer;
+    this->findNearestNeighbour(point, maxDistance, result, distance, buffer, filter);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+template <typename FILTER>
+inline void KDTreeLinkerAlgo<DATA, DIM>::findNearestNeighbour(const KDTreeNodeInfoT<DATA, DIM> &point, const float maxDistance,
+    const KDTreeNodeInfoT<DATA, DIM> *&result, float &distance, KDTreeNeighbourSearchBuffer &buffer, const FILTER &filter) const
+{
+    result = nullptr;
+    distance = std::numeric_limits<float>::max();
+
+    if (this->empty() || (maxDistance < 0.f))
+        return;
+
+    NeighbourSearchContext<FILTER> context(point, 1, maxDistance * maxDistance, filter, buffer.m_bestHeap);
+    this->searchNearestNeighbours(context);
+
+    if (!context.m_bestHeap.empty())
     {
-        result = nullptr;
-        distance = std::numeric_limits<float>::max();
+        result = this->getElement(context.m_bestHeap.front().second);
+        distance = std::sqrt(context.m_bestHeap.front().first);
     }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+template <typename FILTER>
+inline void KDTreeLinkerAlgo<DATA, DIM>::findKNearestNeighbours(const KDTreeNodeInfoT<DATA, DIM> &point, const unsigned nNeighbours,
+    const float maxDistance, std::vector<KDTreeNeighbourT<DATA, DIM> > &result, const FILTER &filter) const
+{
+    KDTreeNeighbourSearchBuffer buffer;
+    this->findKNearestNeighbours(point, nNeighbours, maxDistance, result, buffer, filter);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+template <typename FILTER>
+inline void KDTreeLinkerAlgo<DATA, DIM>::findKNearestNeighbours(const KDTreeNodeInfoT<DATA, DIM> &point, const unsigned nNeighbours,
+    const float maxDistance, std::vector<KDTreeNeighbourT<DATA, DIM> > &result, KDTreeNeighbourSearchBuffer &buffer, const FILTER &filter) const
+{
+    result.clear();
+
+    if (this->empty() || (0 == nNeighbours) || (maxDistance < 0.f))
+        return;
+
+    NeighbourSearchContext<FILTER> context(point, nNeighbours, maxDistance * maxDistance, filter, buffer.m_bestHeap);
+    this->searchNearestNeighbours(context);
+
+    result.reserve(context.m_bestHeap.size());
+
+    for (const DistanceIndexPair &best : context.m_bestHeap)
+        result.emplace_back(this->getElement(best.second), std::sqrt(best.first));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+template <typename FILTER>
+inline void KDTreeLinkerAlgo<DATA, DIM>::findNearestCandidates(const KDTreeNodeInfoT<DATA, DIM> &point, const float maxDistance,
+    const float tolerance, std::vector<KDTreeNeighbourT<DATA, DIM> > &result, KDTreeNeighbourSearchBuffer &buffer, const FILTER &filter) const
+{
+    result.clear();
+
+    const KDTreeNodeInfoT<DATA, DIM> *pNearest(nullptr);
+    float nearestDistance(std::numeric_limits<float>::max());
+    this->findNearestNeighbour(point, maxDistance + tolerance, pNearest, nearestDistance, buffer, filter);
+
+    if (!pNearest)
+        return;
 
-    if (root_)
+    this->findKNearestNeighbours(point, std::numeric_limits<unsigned>::max(), nearestDistance + tolerance, result, buffer, filter);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+template <typename FILTER>
+inline void KDTreeLinkerAlgo<DATA, DIM>::searchNearestNeighbours(NeighbourSearchContext<FILTER> &context) const
+{
+    const KDTreeNodeInfoT<DATA, DIM> &point(context.m_point);
+    const unsigned nNeighbours(context.m_nNeighbours);
+    std::vector<DistanceIndexPair> &bestHeap(context.m_bestHeap);
+
+    bestHeap.clear();
+    bestHeap.reserve(std::min(static_cast<size_t>(nNeighbours), elements_.size() + insertBuffer_.size()) + 1);
+
+    if (!nodes_.empty())
+        this->recKNearestNeighbours(0, context);
+
+    // Elements in the insertion buffer are indexed after the tree elements
+    for (unsigned k = 0; k < insertBuffer_.size(); ++k)
     {
-        const KDTreeNodeT<DATA, DIM> *best_match = nullptr;
-        this->recNearestNeighbour(0, root_, point, best_match, distance);
+        const DistanceIndexPair candidate(this->dist2(point, insertBuffer_[k]), elements_.size() + k);
+
+        if (candidate.first > context.m_maxDist2)
+            continue;
+
+        if ((bestHeap.size() == nNeighbours) && !(candidate < bestHeap.front()))
+            continue;
 
-        if (distance != std::numeric_limits<float>::max())
+        if (!context.m_filter(insertBuffer_[k]))
+            continue;
+
+        bestHeap.push_back(candidate);
+        std::push_heap(bestHeap.begin(), bestHeap.end());
+
+        if (bestHeap.size() > nNeighbours)
         {
-            result = &(best_match->info);
-            distance = std::sqrt(distance);
+            std::pop_heap(bestHeap.begin(), bestHeap.end());
+            bestHeap.pop_back();
         }
+
+        if (bestHeap.size() == nNeighbours)
+            context.m_maxDist2 = std::min(context.m_maxDist2, bestHeap.front().first);
     }
+
+    std::sort_heap(bestHeap.begin(), bestHeap.end());
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename DATA, unsigned DIM>
-inline void KDTreeLinkerAlgo<DATA, DIM>::recNearestNeighbour(unsigned int depth, const KDTreeNodeT<DATA, DIM> *current,
-    const KDTreeNodeInfoT<DATA, DIM> &point, const KDTreeNodeT<DATA, DIM> *&best_match, float &best_dist)
+template <typename FILTER>
+inline void KDTreeLinkerAlgo<DATA, DIM>::recKNearestNeighbours(const unsigned nodeIndex, NeighbourSearchContext<FILTER> &context) const
 {
-    const unsigned int current_dim = depth % DIM;
+    const KDTreeNodeInfoT<DATA, DIM> &point(context.m_point);
+    const unsigned nNeighbours(context.m_nNeighbours);
+    float &maxDist2(context.m_maxDist2);
+    std::vector<DistanceIndexPair> &bestHeap(context.m_bestHeap);
+
+    const KDTreeNodeT<DIM> &current(nodes_[nodeIndex]);
 
-    if (current->left == nullptr && current->right == nullptr)
+    if (current.isLeaf())
     {
-        best_match = current;
-        best_dist = this->dist2(point, best_match->info);
+        for (unsigned j = current.first; j < current.last; ++j)
+        {
+            if (!elementLive_[j])
+                continue;
+
+            const DistanceIndexPair candidate(this->dist2(point, j), j);
+
+            if (candidate.first > maxDist2)
+                continue;
+
+            if ((bestHeap.size() == nNeighbours) && !(candidate < bestHeap.front()))
+                continue;
+
+            if (!context.m_filter(elements_[j]))
+                continue;
+
+            bestHeap.push_back(candidate);
+            std::push_heap(bestHeap.begin(), bestHeap.end());
+
+            if (bestHeap.size() > nNeighbours)
+            {
+                std::pop_heap(bestHeap.begin(), bestHeap.end());
+                bestHeap.pop_back();
+            }
+
+            if (bestHeap.size() == nNeighbours)
+                maxDist2 = std::min(maxDist2, bestHeap.front().first);
+        }
         return;
     }
-    else
+
+    // Descend first into the son closest to the point, then into the other son only if its region could hold a better match
+    const unsigned leftIndex(nodeIndex + 1), rightIndex(current.right);
+    const float leftDist2((0 == nodes_[leftIndex].nLive) ? std::numeric_limits<float>::max() :
+        this->dist2ToRegion(point, nodes_[leftIndex].region));
+    const float rightDist2((0 == nodes_[rightIndex].nLive) ? std::numeric_limits<float>::max() :
+        this->dist2ToRegion(point, nodes_[rightIndex].region));
+
+    const bool isLeftFirst(leftDist2 <= rightDist2);
+    const unsigned nearIndex(isLeftFirst ? leftIndex : rightIndex), farIndex(isLeftFirst ? rightIndex : leftIndex);
+    const float nearDist2(isLeftFirst ? leftDist2 : rightDist2), farDist2(isLeftFirst ? rightDist2 : leftDist2);
+
+    if (nearDist2 <= maxDist2)
+        this->recKNearestNeighbours(nearIndex, context);
+
+    if (farDist2 <= maxDist2)
+        this->recKNearestNeighbours(farIndex, context);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+inline void KDTreeLinkerAlgo<DATA, DIM>::addSubtree(const KDTreeNodeT<DIM> &current, RangeSearchContext &context) const
+{
+    // Each subtree covers a contiguous range of the tree elements
+    if (current.nLive == current.last - current.first)
     {
-        const float dist_to_axis = point.dims[current_dim] - current->info.dims[current_dim];
+        context.m_result.insert(context.m_result.end(), elements_.begin() + current.first, elements_.begin() + current.last);
+        return;
+    }
 
-        if (dist_to_axis < 0.f)
-        {
-            this->recNearestNeighbour(depth + 1, current->left, point, best_match, best_dist);
-        }
-        else
-        {
-            this->recNearestNeighbour(depth + 1, current->right, point, best_match, best_dist);
-        }
+    for (unsigned j = current.first; j < current.last; ++j)
+    {
+        if (elementLive_[j])
+            context.m_result.push_back(elements_[j]);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+inline void KDTreeLinkerAlgo<DATA, DIM>::searchInsertBuffer(RangeSearchContext &context) const
+{
+    const KDTreeBoxT<DIM> &trackBox(context.m_searchBox);
+
+    for (const KDTreeNodeInfoT<DATA, DIM> &element : insertBuffer_)
+    {
+        bool isInside(true);
+
+        for (unsigned i = 0; i < DIM; ++i)
+            isInside = isInside && (element.dims[i] >= trackBox.dimmin[i]) && (element.dims[i] <= trackBox.dimmax[i]);
+
+        if (isInside)
+            context.m_result.push_back(element);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+inline bool KDTreeLinkerAlgo<DATA, DIM>::recSetLive(const unsigned nodeIndex, const KDTreeNodeInfoT<DATA, DIM> &element, const bool isLive)
+{
+    KDTreeNodeT<DIM> &current(nodes_[nodeIndex]);
 
-        // If we're here we're returned so best_dist is filled. Compare to this node and see if it's a better match. If it is, update result
-        const float dist_current = this->dist2(point, current->info);
+    if (!isLive && (0 == current.nLive))
+        return false;
 
-        if (dist_current < best_dist)
+    bool isFound(false);
+
+    if (current.isLeaf())
+    {
+        for (unsigned j = current.first; j < current.last; ++j)
         {
-            best_dist = dist_current;
-            best_match = current;
+            if ((isLive != (0 != elementLive_[j])) && (elements_[j].data == element.data) && (elements_[j].dims == element.dims))
+            {
+                elementLive_[j] = isLive;
+                isFound = true;
+                break;
+            }
         }
+    }
+    else
+    {
+        // Elements equal to the median value may lie in either son, so descend into every son whose region contains the element
+        const unsigned sonIndices[2] = {nodeIndex + 1, current.right};
 
-        // Now we see if the radius to best crosses the splitting axis
-        if (best_dist > dist_to_axis * dist_to_axis)
+        for (const unsigned sonIndex : sonIndices)
         {
-            // if it does we traverse the other side of the axis to check for a new best
-            const KDTreeNodeT<DATA, DIM> *check_best = best_match;
-            float check_dist = best_dist;
+            const KDTreeBoxT<DIM> &region(nodes_[sonIndex].region);
+            bool isInside(true);
 
-            if (dist_to_axis < 0.f)
-            {
-                this->recNearestNeighbour(depth + 1, current->right, point, check_best, check_dist);
-            }
-            else
-            {
-                this->recNearestNeighbour(depth + 1, current->left, point, check_best, check_dist);
-            }
+            for (unsigned i = 0; i < DIM; ++i)
+                isInside = isInside && (element.dims[i] >= region.dimmin[i]) && (element.dims[i] <= region.dimmax[i]);
 
-            if (check_dist < best_dist)
+            if (isInside && this->recSetLive(sonIndex, element, isLive))
             {
-                best_dist = check_dist;
-                best_match = check_best;
+                isFound = true;
+                break;
             }
         }
-        return;
     }
+
+    if (isFound)
+        current.nLive = isLive ? current.nLive + 1 : current.nLive - 1;
+
+    return isFound;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-template < typename DATA, unsigned DIM >
-inline void KDTreeLinkerAlgo<DATA, DIM>::addSubtree(const KDTreeNodeT<DATA, DIM> *current)
+template <typename DATA, unsigned DIM>
+inline void KDTreeLinkerAlgo<DATA, DIM>::rebuild()
 {
-    // By construction, current can't be null
-    //assert(current != 0);
+    std::vector<KDTreeNodeInfoT<DATA, DIM> > liveElements;
+    liveElements.reserve(this->nLiveElements());
 
-    if ((current->left == nullptr) && (current->right == nullptr))
+    for (unsigned j = 0; j < elements_.size(); ++j)
     {
-        // Leaf case
-        closestNeighbour->push_back(current->info);
+        if (elementLive_[j])
+            liveElements.push_back(elements_[j]);
     }
-    else
+
+    liveElements.insert(liveElements.end(), insertBuffer_.begin(), insertBuffer_.end());
+    this->build(liveElements, bound_kd_tree_nodes(liveElements));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+inline const KDTreeNodeInfoT<DATA, DIM> *KDTreeLinkerAlgo<DATA, DIM>::getElement(const unsigned index) const
+{
+    return ((index < elements_.size()) ? &(elements_[index]) : &(insertBuffer_[index - elements_.size()]));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+inline float KDTreeLinkerAlgo<DATA, DIM>::dist2(const KDTreeNodeInfoT<DATA, DIM> &point, const unsigned index) const
+{
+    double d = 0.;
+
+    for (unsigned i = 0 ; i < DIM; ++i)
+    {
+        const double diff = point.dims[i] - elementDims_[i][index];
+        d += diff * diff;
+    }
+
+    return (float)d;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+inline float KDTreeLinkerAlgo<DATA, DIM>::dist2(const KDTreeNodeInfoT<DATA, DIM> &point, const KDTreeNodeInfoT<DATA, DIM> &element) const
+{
+    double d = 0.;
+
+    for (unsigned i = 0 ; i < DIM; ++i)
     {
-        // Node case
-        this->addSubtree(current->left);
-        this->addSubtree(current->right);
+        const double diff = point.dims[i] - element.dims[i];
+        d += diff * diff;
     }
+
+    return (float)d;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename DATA, unsigned DIM>
-inline float KDTreeLinkerAlgo<DATA, DIM>::dist2(const KDTreeNodeInfoT<DATA, DIM> &a, const KDTreeNodeInfoT<DATA, DIM> &b) const
+inline float KDTreeLinkerAlgo<DATA, DIM>::dist2ToRegion(const KDTreeNodeInfoT<DATA, DIM> &point, const KDTreeBoxT<DIM> &region) const
 {
     double d = 0.;
 
     for (unsigned i = 0 ; i < DIM; ++i)
     {
-        const double diff = a.dims[i] - b.dims[i];
+        const double diff = (point.dims[i] < region.dimmin[i]) ? region.dimmin[i] - point.dims[i] :
+            (point.dims[i] > region.dimmax[i]) ? point.dims[i] - region.dimmax[i] : 0.;
         d += diff * diff;
     }
 
@@ -454,95 +996,147 @@ inline float KDTreeLinkerAlgo<DATA, DIM>::dist2(const KDTreeNodeInfoT<DATA, DIM>
 template <typename DATA, unsigned DIM>
 inline void KDTreeLinkerAlgo<DATA, DIM>::clearTree()
 {
-    delete[] nodePool_;
-    nodePool_ = nullptr;
-    root_ = nullptr;
-    nodePoolSize_ = -1;
-    nodePoolPos_ = -1;
+    // Storage is retained, so that trees rebuilt for each event need not reallocate
+    nodes_.clear();
+    elements_.clear();
+
+    for (unsigned i = 0; i < DIM; ++i)
+        elementDims_[i].clear();
+
+    elementLive_.clear();
+    insertBuffer_.clear();
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename DATA, unsigned DIM>
-inline bool KDTreeLinkerAlgo<DATA, DIM>::empty()
+inline bool KDTreeLinkerAlgo<DATA, DIM>::empty() const
 {
-    return (nodePoolPos_ == -1);
+    return (nodes_.empty() && insertBuffer_.empty());
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename DATA, unsigned DIM>
-inline int KDTreeLinkerAlgo<DATA, DIM>::size()
+inline int KDTreeLinkerAlgo<DATA, DIM>::size() const
 {
-    return (nodePoolPos_ + 1);
+    return nodes_.size();
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename DATA, unsigned DIM>
-inline void KDTreeLinkerAlgo<DATA, DIM>::clear()
+inline unsigned KDTreeLinkerAlgo<DATA, DIM>::nLiveElements() const
 {
-    if (root_)
-        this->clearTree();
+    return ((nodes_.empty() ? 0 : nodes_.front().nLive) + insertBuffer_.size());
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename DATA, unsigned DIM>
-inline KDTreeNodeT<DATA, DIM> *KDTreeLinkerAlgo<DATA, DIM>::getNextNode()
+inline void KDTreeLinkerAlgo<DATA, DIM>::insert(const KDTreeNodeInfoT<DATA, DIM> &element)
 {
-    ++nodePoolPos_;
+    if (!nodes_.empty() && this->recSetLive(0, element, true))
+        return;
 
-    // The tree size is exactly 2 * nbrElts - 1 and this is the total allocated memory.
-    // If we have used more than that....there is a big problem.
-    //assert(nodePoolPos_ < nodePoolSize_);
+    insertBuffer_.push_back(element);
 
-    return &(nodePool_[nodePoolPos_]);
+    // The buffer is searched linearly, so merge it into the tree once it grows large, for amortised logarithmic insertion
+    if (insertBuffer_.size() > std::max(maxBucketSize_, this->nLiveElements() / 4))
+        this->rebuild();
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 template <typename DATA, unsigned DIM>
-inline KDTreeNodeT<DATA, DIM> *KDTreeLinkerAlgo<DATA, DIM>::recBuild(int low, int high, int depth, const KDTreeBoxT<DIM> &region)
+inline bool KDTreeLinkerAlgo<DATA, DIM>::erase(const KDTreeNodeInfoT<DATA, DIM> &element)
+{
+    if (!nodes_.empty() && this->recSetLive(0, element, false))
+    {
+        // Discard the erased elements once they outnumber the live tree elements, for amortised logarithmic erasure
+        if (2 * nodes_.front().nLive < elements_.size())
+            this->rebuild();
+
+        return true;
+    }
+
+    for (typename std::vector<KDTreeNodeInfoT<DATA, DIM> >::iterator iter = insertBuffer_.begin(); iter != insertBuffer_.end(); ++iter)
+    {
+        if ((iter->data == element.data) && (iter->dims == element.dims))
+        {
+            insertBuffer_.erase(iter);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+inline void KDTreeLinkerAlgo<DATA, DIM>::clear()
+{
+    this->clearTree();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+inline unsigned KDTreeLinkerAlgo<DATA, DIM>::recBuild(std::vector<KDTreeNodeInfoT<DATA, DIM> > &eltList, int low, int high, int depth,
+    const KDTreeBoxT<DIM> &region)
 {
     const int portionSize = high - low;
 
     // By construction, portionSize > 0 can't happen.
     //assert(portionSize > 0);
 
-    if (portionSize == 1)
+    // Nodes may be added to the pool in the recursive calls, so refer to them by index alone
+    const unsigned nodeIndex(nodes_.size());
+    nodes_.push_back(KDTreeNodeT<DIM>());
+    nodes_[nodeIndex].setAttributs(region, low, high);
+
+    if (portionSize <= static_cast<int>(maxBucketSize_))
     {
         // Leaf case
-        KDTreeNodeT<DATA, DIM> *leaf = this->getNextNode();
-        leaf->setAttributs(region, (*initialEltList)[low]);
-        return leaf;
+        this->recPartition(eltList, low, high, depth);
+        return nodeIndex;
     }
     else
     {
         // The even depth is associated to dim1 dimension, the odd one to dim2 dimension
-        int medianId = this->medianSearch(low, high, depth);
-
-        // We create the node
-        KDTreeNodeT<DATA, DIM> *node = this->getNextNode();
-        node->setAttributs(region);
-        node->info = (*initialEltList)[medianId];
+        int medianId = this->medianSearch(eltList, low, high, depth);
 
         // Here we split into 2 halfplanes the current plane
         KDTreeBoxT<DIM> leftRegion = region;
         KDTreeBoxT<DIM> rightRegion = region;
 
         const unsigned thedim = depth % DIM;
-        auto medianVal = (*initialEltList)[medianId].dims[thedim];
+        auto medianVal = eltList[medianId].dims[thedim];
         leftRegion.dimmax[thedim] = medianVal;
         rightRegion.dimmin[thedim] = medianVal;
 
         ++depth;
         ++medianId;
 
-        // We recursively build the son nodes
-        node->left = this->recBuild(low, medianId, depth, leftRegion);
-        node->right = this->recBuild(medianId, high, depth, rightRegion);
-        return node;
+        // We recursively build the son nodes, the left son immediately following this node
+        this->recBuild(eltList, low, medianId, depth, leftRegion);
+        const unsigned rightIndex(this->recBuild(eltList, medianId, high, depth, rightRegion));
+        nodes_[nodeIndex].right = rightIndex;
+        return nodeIndex;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename DATA, unsigned DIM>
+inline void KDTreeLinkerAlgo<DATA, DIM>::recPartition(std::vector<KDTreeNodeInfoT<DATA, DIM> > &eltList, int low, int high, int depth) const
+{
+    if (high - low > 1)
+    {
+        const int medianId = this->medianSearch(eltList, low, high, depth);
+        this->recPartition(eltList, low, medianId + 1, depth + 1);
+        this->recPartition(eltList, medianId + 1, high, depth + 1);
     }
 }
 
@@ -17,6 +17,8 @@
 #include "Pandora/PandoraInternal.h"
 
 #include <array>
+#include <utility>
+#include <vector>
 
 namespace pandora { class Algorithm; }
 
@@ -85,9 +87,10 @@ public:
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 /**
- *  @brief  KDTree node
+ *  @brief  KDTree node. Nodes are stored contiguously, in depth-first order, and each node refers to the contiguous range of tree
+ *          elements contained within its region. The left son of a node immediately follows it in the node array.
  */
-template <typename DATA, unsigned DIM>
+template <unsigned DIM>
 class KDTreeNodeT
 {
 public:
@@ -100,21 +103,77 @@ public:
      *  @brief  setAttributs
      * 
      *  @param  regionBox
-     *  @param  infoToStore
+     *  @param  firstElement
+     *  @param  lastElement
      */
-    void setAttributs(const KDTreeBoxT<DIM> &regionBox, const KDTreeNodeInfoT<DATA, DIM> &infoToStore);
+    void setAttributs(const KDTreeBoxT<DIM> &regionBox, const unsigned firstElement, const unsigned lastElement);
 
     /**
-     *  @brief  setAttributs
+     *  @brief  Whether the node is a leaf, holding a bucket of elements rather than two sons
      * 
-     *  @param  regionBox
+     *  @return boolean
      */
-    void setAttributs(const KDTreeBoxT<DIM> &regionBox);
+    bool isLeaf() const;
 
-    KDTreeNodeInfoT<DATA, DIM>  info;       ///< Data
-    KDTreeNodeT<DATA, DIM>     *left;       ///< Left son
-    KDTreeNodeT<DATA, DIM>     *right;      ///< Right son
     KDTreeBoxT<DIM>             region;     ///< Region bounding box.
+    unsigned                    first;      ///< Index of the first element contained in the node region
+    unsigned                    last;       ///< Index one past the last element contained in the node region
+    unsigned                    right;      ///< Index of the right son in the node array, zero for a leaf
+    unsigned                    nLive;      ///< Number of live (not erased) elements contained in the node region
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Element found by a nearest neighbour search, together with its distance from the search point
+ */
+template<typename DATA, unsigned DIM>
+class KDTreeNeighbourT
+{
+public:
+    /**
+     *  @brief  Constructor
+     * 
+     *  @param  pInfo
+     *  @param  dist
+     */
+    KDTreeNeighbourT(const KDTreeNodeInfoT<DATA, DIM> *const pInfo, const float dist);
+
+    const KDTreeNodeInfoT<DATA, DIM>   *info;       ///< The element, owned by the tree
+    float                               distance;   ///< The distance between the element and the search point
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Element filter for nearest neighbour searches, accepting every element
+ */
+class KDTreeAcceptAll
+{
+public:
+    /**
+     *  @brief  Whether an element may be returned by a nearest neighbour search
+     * 
+     *  @param  info
+     * 
+     *  @return boolean
+     */
+    template<typename DATA, unsigned DIM>
+    bool operator()(const KDTreeNodeInfoT<DATA, DIM> &info) const;
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Working storage for nearest neighbour searches, which may be reused from one search to the next so that repeated searches
+ *          need not allocate. A buffer may be used by only one search at a time.
+ */
+class KDTreeNeighbourSearchBuffer
+{
+private:
+    std::vector<std::pair<float, unsigned> >    m_bestHeap;     ///< Storage for the heap of the best elements found by a search
+
+    template<typename, unsigned> friend class KDTreeLinkerAlgo;
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -197,6 +256,16 @@ KDTreeCube fill_and_bound_3d_kd_tree(const pandora::Algorithm *const caller, con
 KDTreeTesseract fill_and_bound_4d_kd_tree(const pandora::Algorithm *const caller, const MANAGED_CONTAINER<const pandora::CaloHit*> &points,
     std::vector<KDTreeNodeInfoT<const pandora::CaloHit*, 4> > &nodes, bool passthru = false);
 
+/**
+ *  @brief  bound_kd_tree_nodes, get the smallest region containing all of a list of kd tree nodes
+ * 
+ *  @param  nodes
+ * 
+ *  @return KDTreeBoxT
+ */
+template<typename DATA, unsigned DIM>
+KDTreeBoxT<DIM> bound_kd_tree_nodes(const std::vector<KDTreeNodeInfoT<DATA, DIM> > &nodes);
+
 /**
  *  @brief  build_3d_kd_search_region
  * 
@@ -281,28 +350,50 @@ inline KDTreeNodeInfoT<DATA, DIM>::KDTreeNodeInfoT(const DATA &d, Ts... dimargs)
 //------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-template <typename DATA, unsigned DIM>
-inline KDTreeNodeT<DATA, DIM>::KDTreeNodeT() :
-    left(nullptr),
-    right(nullptr)
+template <unsigned DIM>
+inline KDTreeNodeT<DIM>::KDTreeNodeT() :
+    first(0),
+    last(0),
+    right(0),
+    nLive(0)
 {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-template <typename DATA, unsigned DIM>
-inline void KDTreeNodeT<DATA, DIM>::setAttributs(const KDTreeBoxT<DIM> &regionBox, const KDTreeNodeInfoT<DATA, DIM> &infoToStore)
+template <unsigned DIM>
+inline void KDTreeNodeT<DIM>::setAttributs(const KDTreeBoxT<DIM> &regionBox, const unsigned firstElement, const unsigned lastElement)
 {
-    info = infoToStore;
     region = regionBox;
+    first = firstElement;
+    last = lastElement;
+    nLive = lastElement - firstElement;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-template <typename DATA, unsigned DIM>
-inline void KDTreeNodeT<DATA, DIM>::setAttributs(const KDTreeBoxT<DIM> &regionBox) 
+template <unsigned DIM>
+inline bool KDTreeNodeT<DIM>::isLeaf() const
 {
-    region = regionBox;
+    return (0 == right);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template<typename DATA, unsigned DIM>
+inline KDTreeNeighbourT<DATA, DIM>::KDTreeNeighbourT(const KDTreeNodeInfoT<DATA, DIM> *const pInfo, const float dist) :
+    info(pInfo),
+    distance(dist)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template<typename DATA, unsigned DIM>
+inline bool KDTreeAcceptAll::operator()(const KDTreeNodeInfoT<DATA, DIM> &/*info*/) const
+{
+    return true;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -434,6 +525,33 @@ KDTreeCube fill_and_bound_3d_kd_tree(const pandora::Algorithm *const caller, con
     return KDTreeCube(minpos[0], maxpos[0], minpos[1], maxpos[1], minpos[2], maxpos[2]);
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template<typename DATA, unsigned DIM>
+KDTreeBoxT<DIM> bound_kd_tree_nodes(const std::vector<KDTreeNodeInfoT<DATA, DIM> > &nodes)
+{
+    KDTreeBoxT<DIM> region;
+    region.dimmin.fill(0.f);
+    region.dimmax.fill(0.f);
+
+    if (!nodes.empty())
+    {
+        region.dimmin = nodes.front().dims;
+        region.dimmax = nodes.front().dims;
+    }
+
+    for (const KDTreeNodeInfoT<DATA, DIM> &node : nodes)
+    {
+        for (unsigned i = 0; i < DIM; ++i)
+        {
+            region.dimmin[i] = std::min(node.dims[i], region.dimmin[i]);
+            region.dimmax[i] = std::max(node.dims[i], region.dimmax[i]);
+        }
+    }
+
+    return region;
+}
+
 } // namespace lc_content
 
 #endif // LC_KD_TREE_LINKER_TOOLS_TEMPLATED_H
@@ -0,0 +1,148 @@
+/**
+ *  @file   LCContent/include/LCUtility/ParallelFor.h
+ * 
+ *  @brief  Header file for the parallel for class.
+ * 
+ *  $Log: $
+ */
+#ifndef LC_PARALLEL_FOR_H
+#define LC_PARALLEL_FOR_H 1
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lc_content
+{
+
+/**
+ *  @brief  ParallelFor class, a persistent pool of worker threads which shares the indices [0, nIndices) between threads as contiguous
+ *          ranges, one range per thread, and waits for all the ranges to complete.
+ * 
+ *  The workers are started on construction, wait idle between calls and are joined on destruction, so an owner should construct a single
+ *  instance, once its thread count is known, and reuse it for every call. The calling thread processes the first range itself. An
+ *  exception thrown while processing a range is caught and rethrown in the calling thread once all ranges have completed; if several
+ *  ranges throw, the exception from the first range is rethrown, so the outcome matches that of a single, serial pass. Run must not be
+ *  called concurrently on the same instance.
+ */
+class ParallelFor
+{
+public:
+    /**
+     *  @brief  Constructor, starting the worker threads
+     * 
+     *  @param  nThreads the maximum number of threads, including the calling thread, so nThreads - 1 worker threads are started
+     */
+    explicit ParallelFor(const unsigned int nThreads);
+
+    /**
+     *  @brief  Destructor, stopping and joining the worker threads
+     */
+    ~ParallelFor();
+
+    /**
+     *  @brief  Get the number of threads to use for a number of indices, limited such that each thread receives a minimum number of indices
+     * 
+     *  @param  nIndices the number of indices
+     *  @param  maxThreads the maximum number of threads
+     *  @param  minIndicesPerThread the minimum number of indices for each thread, zero for no minimum
+     * 
+     *  @return the number of threads, at least one
+     */
+    static unsigned int GetNThreads(const unsigned int nIndices, const unsigned int maxThreads, const unsigned int minIndicesPerThread);
+
+    /**
+     *  @brief  Call a function for each contiguous range of indices, in parallel if more than one thread is requested. With a single thread,
+     *          the function is called directly, in the calling thread.
+     * 
+     *  @param  nIndices the number of indices
+     *  @param  nThreads the number of threads, which is also the number of ranges, limited to the number of threads in the pool
+     *  @param  function the function, called as function(firstIndex, endIndex, rangeIndex), which must be safe to call concurrently for
+     *          different ranges
+     */
+    template <typename FUNCTION>
+    void Run(const unsigned int nIndices, const unsigned int nThreads, const FUNCTION &function);
+
+private:
+    typedef std::function<void(unsigned int, unsigned int, unsigned int)> RangeFunction;
+    typedef std::vector<std::exception_ptr> ExceptionPtrVector;
+    typedef std::vector<std::thread> ThreadVector;
+
+    /**
+     *  @brief  Deny copy construction and assignment, as the workers hold the address of the instance
+     */
+    ParallelFor(const ParallelFor &);
+    ParallelFor &operator=(const ParallelFor &);
+
+    /**
+     *  @brief  Share the ranges of indices between the calling thread and the workers, and wait for all the ranges to complete
+     * 
+     *  @param  rangeFunction the function to call for each range
+     *  @param  nIndices the number of indices
+     *  @param  nRanges the number of ranges, at most the number of threads in the pool
+     */
+    void RunRanges(const RangeFunction &rangeFunction, const unsigned int nIndices, const unsigned int nRanges);
+
+    /**
+     *  @brief  The loop run by each worker thread, processing its range for each call, until the pool is stopped
+     * 
+     *  @param  rangeIndex the index of the range processed by the worker
+     */
+    void RunWorker(const unsigned int rangeIndex);
+
+    /**
+     *  @brief  Stop and join the worker threads
+     */
+    void StopWorkers();
+
+    /**
+     *  @brief  Call a function for a single range of indices, capturing any exception thrown
+     * 
+     *  @param  rangeFunction the function
+     *  @param  nIndices the number of indices
+     *  @param  nRanges the number of ranges
+     *  @param  rangeIndex the index of the range
+     *  @param  exceptionPtr to receive any exception thrown by the function
+     */
+    static void RunRange(const RangeFunction &rangeFunction, const unsigned int nIndices, const unsigned int nRanges,
+        const unsigned int rangeIndex, std::exception_ptr &exceptionPtr);
+
+    ThreadVector            m_workers;              ///< The worker threads, processing ranges 1 to nThreads - 1
+    std::mutex              m_mutex;                ///< The mutex guarding the state shared with the workers
+    std::condition_variable m_startCondition;       ///< Signalled when a call starts, or the pool is stopped
+    std::condition_variable m_endCondition;         ///< Signalled when the last pending worker range completes
+    const RangeFunction    *m_pRangeFunction;       ///< The function for the current call
+    unsigned int            m_nIndices;             ///< The number of indices for the current call
+    unsigned int            m_nRanges;              ///< The number of ranges for the current call
+    unsigned int            m_nPendingRanges;       ///< The number of worker ranges yet to complete for the current call
+    unsigned long           m_callIndex;            ///< Incremented for each call, so that the workers can recognise a new call
+    bool                    m_isStopping;           ///< Whether the workers should exit
+    ExceptionPtrVector      m_exceptionPtrs;        ///< Any exception thrown while processing each range of the current call
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename FUNCTION>
+inline void ParallelFor::Run(const unsigned int nIndices, const unsigned int nThreads, const FUNCTION &function)
+{
+    const unsigned int nRanges(std::min(nThreads, static_cast<unsigned int>(m_workers.size() + 1)));
+
+    if (nRanges <= 1)
+    {
+        function(0, nIndices, 0);
+        return;
+    }
+
+    const RangeFunction rangeFunction(std::cref(function));
+    this->RunRanges(rangeFunction, nIndices, nRanges);
+}
+
+} // namespace lc_content
+
+#endif // #ifndef LC_PARALLEL_FOR_H
@@ -14,7 +14,10 @@ namespace lc_content
 {
 
 /**
- *  @brief  QuickUnion class
+ *  @brief  QuickUnion class, a disjoint-set forest using union-by-size and path compression
+ * 
+ *  Each set is identified by a target index, one of its members, chosen by the caller: uniting index p with index q gives the combined set
+ *  the target index of the set containing q, regardless of which tree root survives the union.
  */
 class QuickUnion
 {
@@ -26,6 +29,13 @@ public:
      */
     QuickUnion(const unsigned nBranches);
 
+    /**
+     *  @brief  Reset to the given number of original indices, each in its own set, reusing the existing storage where possible
+     * 
+     *  @param  nBranches the number of original indices
+     */
+    void Reset(const unsigned nBranches);
+
     /**
      *  @brief  Get the current number of target indices
      * 
@@ -40,6 +50,13 @@ public:
      */
     unsigned int Find(unsigned p);
 
+    /**
+     *  @brief  Find the current target index for provided index p, without compressing the path, so leaving the forest unchanged
+     * 
+     *  @param  p index p
+     */
+    unsigned int FindTarget(unsigned p) const;
+
     /**
      *  @brief  Whether two original indices are now connected
      * 
@@ -51,31 +68,58 @@ public:
     bool Connected(unsigned p, unsigned q);
 
     /**
-     *  @brief  Unite two indices
+     *  @brief  Unite two indices, the combined set taking the target index of index q
      * 
      *  @param  p index p
      *  @param  q index q
      */
     void Unite(unsigned p, unsigned q);
 
+    /**
+     *  @brief  Label every connected set of original indices in a single pass. Labels run from zero to Count() - 1, in order of the
+     *          lowest original index in each set
+     * 
+     *  @param  componentLabels to receive the label for each original index
+     */
+    void GetComponentLabels(std::vector<unsigned> &componentLabels);
+
 private:
-    std::vector<unsigned>   m_id;       ///< Stores target index for each original index
-    //std::vector<unsigned> m_size;     ///< Stores number of connected indices, used for book-keeping
+    /**
+     *  @brief  Find the root of the tree containing index p, compressing the path from p to the root
+     * 
+     *  @param  p index p
+     * 
+     *  @return the root index
+     */
+    unsigned int FindRoot(unsigned p);
+
+    std::vector<unsigned>   m_id;       ///< Stores parent index for each original index, roots being their own parents
+    std::vector<unsigned>   m_size;     ///< Stores number of connected indices for each root, used for book-keeping
+    std::vector<unsigned>   m_target;   ///< Stores target index for each root
     int                     m_count;    ///< The current number of target indices
 };
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-inline QuickUnion::QuickUnion(const unsigned int nBranches)
+inline QuickUnion::QuickUnion(const unsigned int nBranches) :
+    m_count(0)
+{
+    this->Reset(nBranches);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void QuickUnion::Reset(const unsigned int nBranches)
 {
     m_count = nBranches;
     m_id.resize(nBranches);
-    //m_size.resize(nBranches);
+    m_size.assign(nBranches, 1);
+    m_target.resize(nBranches);
 
     for (unsigned int i = 0; i < nBranches; ++i)
     {
         m_id[i] = i;
-        //m_size[i] = 1;
+        m_target[i] = i;
     }
 }
 
@@ -89,48 +133,95 @@ inline int QuickUnion::Count() const
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 inline unsigned int QuickUnion::Find(unsigned int p)
+{
+    return m_target[this->FindRoot(p)];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int QuickUnion::FindTarget(unsigned int p) const
 {
     while (p != m_id[p])
-    {
-        m_id[p] = m_id[m_id[p]];
         p = m_id[p];
-    }
 
-    return p;
+    return m_target[p];
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 inline bool QuickUnion::Connected(const unsigned int p, const unsigned int q)
 {
-    return (this->Find(p) == this->Find(q));
+    return (this->FindRoot(p) == this->FindRoot(q));
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 inline void QuickUnion::Unite(const unsigned int p, const unsigned int q)
 {
-    const unsigned int rootP(this->Find(p));
-    const unsigned int rootQ(this->Find(q));
+    const unsigned int rootP(this->FindRoot(p));
+    const unsigned int rootQ(this->FindRoot(q));
 
-    m_id[p] = q;
+    if (rootP == rootQ)
+        return;
 
-    // TODO finalise implementation of Unite function
+    const unsigned int target(m_target[rootQ]);
 
-    //if (m_size[rootP] < m_size[rootQ])
-    //{
-    m_id[rootP] = rootQ;
-    //    m_size[rootQ] += m_size[rootP];
-    //}
-    //else
-    //{
-    //    m_id[rootQ] = rootP;
-    //    m_size[rootP] += m_size[rootQ];
-    //}
+    if (m_size[rootP] < m_size[rootQ])
+    {
+        m_id[rootP] = rootQ;
+        m_size[rootQ] += m_size[rootP];
+    }
+    else
+    {
+        m_id[rootQ] = rootP;
+        m_size[rootP] += m_size[rootQ];
+        m_target[rootP] = target;
+    }
 
     --m_count;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void QuickUnion::GetComponentLabels(std::vector<unsigned int> &componentLabels)
+{
+    const unsigned int nBranches(m_id.size());
+    const unsigned int unlabelled(nBranches);
+    componentLabels.resize(nBranches);
+
+    std::vector<unsigned int> rootLabels(nBranches, unlabelled);
+    unsigned int nLabels(0);
+
+    for (unsigned int i = 0; i < nBranches; ++i)
+    {
+        const unsigned int root(this->FindRoot(i));
+
+        if (unlabelled == rootLabels[root])
+            rootLabels[root] = nLabels++;
+
+        componentLabels[i] = rootLabels[root];
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int QuickUnion::FindRoot(unsigned int p)
+{
+    unsigned int root(p);
+
+    while (root != m_id[root])
+        root = m_id[root];
+
+    while (p != root)
+    {
+        const unsigned int next(m_id[p]);
+        m_id[p] = root;
+        p = next;
+    }
+
+    return root;
+}
+
 } // namespace lc_content
 
 #endif // LC_QUICK_UNION_H
@@ -0,0 +1,123 @@
+/**
+ *  @file   LCContent/include/LCUtility/SharedIndexRegistry.h
+ * 
+ *  @brief  Header file for the shared index registry class template.
+ * 
+ *  $Log: $
+ */
+#ifndef LC_SHARED_INDEX_REGISTRY_H
+#define LC_SHARED_INDEX_REGISTRY_H 1
+
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace pandora { class Pandora; }
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lc_content
+{
+
+/**
+ *  @brief  SharedIndexRegistry class template, allowing the algorithms running in a pandora instance to find and share read-only indices
+ *          of the same input object list.
+ * 
+ *  The registry owns no index. Each index is owned by the algorithms holding it, which must release it no later than their Reset, at
+ *  the end of the event, after which the registry entry expires. No index therefore outlives the event, and the input objects, for
+ *  which it was built. The INDEX type must provide a constructor from the LIST type and a public IsIndexOf(const LIST &) const, which
+ *  should be cheap, as it is called for each live index on every request.
+ */
+template <typename INDEX, typename LIST>
+class SharedIndexRegistry
+{
+public:
+    /**
+     *  @brief  Get a live index, held by any algorithm in the pandora instance, whose contents match the list, else build a new index
+     * 
+     *  @param  pandora the pandora instance
+     *  @param  list the input object list
+     * 
+     *  @return the index, which the caller should hold no later than its Reset
+     */
+    static std::shared_ptr<const INDEX> GetIndex(const pandora::Pandora &pandora, const LIST &list);
+
+private:
+    typedef std::vector<std::weak_ptr<const INDEX> > IndexVector;
+    typedef std::unordered_map<const pandora::Pandora*, IndexVector> PandoraToIndicesMap;
+    typedef std::vector<std::shared_ptr<const INDEX> > LiveIndexVector;
+
+    /**
+     *  @brief  Get the live indices registered for a pandora instance, discarding any that have expired, or register a new index
+     * 
+     *  @param  pandora the pandora instance
+     *  @param  spNewIndex a new index to register, or null to register nothing
+     *  @param  liveIndices to receive the live indices
+     */
+    static void UpdateRegistry(const pandora::Pandora &pandora, const std::shared_ptr<const INDEX> &spNewIndex, LiveIndexVector &liveIndices);
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename INDEX, typename LIST>
+inline std::shared_ptr<const INDEX> SharedIndexRegistry<INDEX, LIST>::GetIndex(const pandora::Pandora &pandora, const LIST &list)
+{
+    // ATTN Neither the comparison with each live index nor the construction of a new index is made under the lock
+    LiveIndexVector liveIndices;
+    SharedIndexRegistry::UpdateRegistry(pandora, std::shared_ptr<const INDEX>(), liveIndices);
+
+    for (const std::shared_ptr<const INDEX> &spIndex : liveIndices)
+    {
+        if (spIndex->IsIndexOf(list))
+            return spIndex;
+    }
+
+    const std::shared_ptr<const INDEX> spNewIndex(std::make_shared<const INDEX>(list));
+    SharedIndexRegistry::UpdateRegistry(pandora, spNewIndex, liveIndices);
+
+    return spNewIndex;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename INDEX, typename LIST>
+inline void SharedIndexRegistry<INDEX, LIST>::UpdateRegistry(const pandora::Pandora &pandora, const std::shared_ptr<const INDEX> &spNewIndex,
+    LiveIndexVector &liveIndices)
+{
+    static std::mutex registryMutex;
+    static PandoraToIndicesMap pandoraToIndicesMap;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    IndexVector &indices(pandoraToIndicesMap[&pandora]);
+
+    liveIndices.clear();
+    IndexVector unexpiredIndices;
+
+    for (const std::weak_ptr<const INDEX> &wpIndex : indices)
+    {
+        const std::shared_ptr<const INDEX> spIndex(wpIndex.lock());
+
+        if (!spIndex)
+            continue;
+
+        liveIndices.push_back(spIndex);
+        unexpiredIndices.push_back(spIndex);
+    }
+
+    if (spNewIndex)
+        unexpiredIndices.push_back(spNewIndex);
+
+    if (unexpiredIndices.empty())
+    {
+        pandoraToIndicesMap.erase(&pandora);
+    }
+    else
+    {
+        indices.swap(unexpiredIndices);
+    }
+}
+
+} // namespace lc_content
+
+#endif // #ifndef LC_SHARED_INDEX_REGISTRY_H
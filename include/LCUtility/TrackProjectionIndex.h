@@ -0,0 +1,84 @@
+/**
+ *  @file   LCContent/include/LCUtility/TrackProjectionIndex.h
+ * 
+ *  @brief  Header file for the track projection index class.
+ * 
+ *  $Log: $
+ */
+#ifndef LC_TRACK_PROJECTION_INDEX_H
+#define LC_TRACK_PROJECTION_INDEX_H 1
+
+#include "Pandora/PandoraInternal.h"
+
+#include "LCObjects/LCTrack.h"
+
+#include <memory>
+#include <unordered_map>
+
+namespace pandora { class Algorithm; }
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lc_content
+{
+
+/**
+ *  @brief  TrackProjectionIndex class, a read-only, flat store of the track states to be projected into the calorimeter for each track in a
+ *          track list: all track states of an LCTrack, otherwise the single track state at the calorimeter.
+ * 
+ *  A single index may be shared by all algorithms working on the same track list in an event: a new index is only built when no index
+ *  held by an algorithm has the same list contents. Tracks are not modified during an event and no index outlives its event, so the
+ *  comparison need only examine the track addresses and their positions at the calorimeter.
+ */
+class TrackProjectionIndex
+{
+public:
+    /**
+     *  @brief  Get the index of a track list shared by all algorithms running in the same pandora instance, building a new index only if
+     *          no index of an identical list is currently held
+     * 
+     *  @param  algorithm the algorithm requesting the index
+     *  @param  trackList the track list
+     * 
+     *  @return the shared index, which the caller owns jointly and must release no later than its Reset, at the end of the event
+     */
+    static std::shared_ptr<const TrackProjectionIndex> GetSharedIndex(const pandora::Algorithm &algorithm, const pandora::TrackList &trackList);
+
+    /**
+     *  @brief  Constructor, building an index of a track list
+     * 
+     *  @param  trackList the track list
+     */
+    explicit TrackProjectionIndex(const pandora::TrackList &trackList);
+
+    /**
+     *  @brief  Get the track states to be projected into the calorimeter for an indexed track
+     * 
+     *  @param  pTrack address of the track
+     *  @param  beginIter to receive the iterator to the first track state
+     *  @param  endIter to receive the iterator past the last track state
+     */
+    void GetTrackStates(const pandora::Track *const pTrack, LCTrackStates::const_iterator &beginIter, LCTrackStates::const_iterator &endIter) const;
+
+    /**
+     *  @brief  Whether the index was built from a track list with identical contents to that provided
+     * 
+     *  @param  trackList the track list
+     * 
+     *  @return boolean
+     */
+    bool IsIndexOf(const pandora::TrackList &trackList) const;
+
+private:
+    typedef std::unordered_map<const pandora::Track*, unsigned int> TrackToIndexMap;
+
+    pandora::TrackVector            m_tracks;                   ///< The indexed tracks, in track list order
+    pandora::CartesianPointVector   m_calorimeterPositions;     ///< The track state positions at the calorimeter, in track list order
+    pandora::UIntVector             m_firstTrackStateIndices;   ///< The index of the first track state of each track, then the number of states
+    LCTrackStates                   m_trackStates;              ///< The track states of all indexed tracks, in track list order
+    TrackToIndexMap                 m_trackToIndexMap;          ///< The map from indexed track to its position in the track list
+};
+
+} // namespace lc_content
+
+#endif // #ifndef LC_TRACK_PROJECTION_INDEX_H
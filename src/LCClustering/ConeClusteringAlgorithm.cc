@@ -12,7 +12,11 @@
 
 #include "LCHelpers/SortingHelper.h"
 
-#include <list>
+#include "LCUtility/CaloHitSpatialIndex.h"
+#include "LCUtility/ParallelFor.h"
+
+#include <algorithm>
+#include <functional>
 
 using namespace pandora;
 
@@ -55,12 +59,22 @@ ConeClusteringAlgorithm::ConeClusteringAlgorithm() :
     m_fitSuccessDotProductCut2(0.50f),
     m_fitSuccessChi2Cut2(2.5f),
     m_mipTrackChi2Cut(2.5f),
+    m_nThreads(1),
+    m_minHitsPerThread(100),
+    m_pParallelFor(NULL),
     m_firstLayer(1)
 {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+ConeClusteringAlgorithm::~ConeClusteringAlgorithm()
+{
+    delete m_pParallelFor;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode ConeClusteringAlgorithm::Run()
 {
     m_firstLayer = (PandoraContentApi::GetPlugins(*this)->GetPseudoLayerPlugin()->GetPseudoLayerAtIp());
@@ -86,6 +100,10 @@ StatusCode ConeClusteringAlgorithm::Run()
 
     // do the clustering
     m_hitsToClusters.clear();
+    m_searchBuffers.resize(m_nThreads);
+    ClusterFitResultMap clusterFitResultMap;
+    ClusterToNCaloHitsMap clusterFitNCaloHitsMap;
+
     for (OrderedCaloHitList::const_iterator iter = orderedCaloHitList.begin(), iterEnd = orderedCaloHitList.end(); iter != iterEnd; ++iter)
     {
         const unsigned int pseudoLayer(iter->first);
@@ -103,8 +121,7 @@ StatusCode ConeClusteringAlgorithm::Run()
             }
         }
 
-        ClusterFitResultMap clusterFitResultMap;
-        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetCurrentClusterFitResults(clusterVector, clusterFitResultMap));
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetCurrentClusterFitResults(clusterVector, clusterFitNCaloHitsMap, clusterFitResultMap));
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->FindHitsInPreviousLayers(pseudoLayer, relevantCaloHits, clusterFitResultMap, clusterVector));
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->FindHitsInSameLayer(pseudoLayer, relevantCaloHits, clusterFitResultMap, clusterVector));
     }
@@ -113,15 +130,24 @@ StatusCode ConeClusteringAlgorithm::Run()
 
     //reset our kd trees and maps if everything turned out well
     m_tracksKdTree.clear();
-    m_hitsKdTree.clear();
     m_hitsToClusters.clear();
     m_tracksToClusters.clear();
+    m_searchBuffers.clear();
 
     return STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+StatusCode ConeClusteringAlgorithm::Reset()
+{
+    // the shared hit index is kept for the remaining algorithms in the event, then released before its hits can be deleted
+    m_spHitsSpatialIndex.reset();
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode ConeClusteringAlgorithm::InitializeKDTrees(const TrackList *const pTrackList, const CaloHitList *const pCaloHitList)
 {
     // load the kd-tree of tracks that we will use
@@ -135,12 +161,9 @@ StatusCode ConeClusteringAlgorithm::InitializeKDTrees(const TrackList *const pTr
         m_trackNodes.clear();
     }
 
-    // make sure the hit kd tree is ready
-    m_hitsKdTree.clear();
-    m_hitNodes.clear();
-    KDTreeTesseract hitsBoundingRegion = fill_and_bound_4d_kd_tree(this,*pCaloHitList,m_hitNodes);
-    m_hitsKdTree.build(m_hitNodes,hitsBoundingRegion);
-    m_hitNodes.clear();
+    // make sure the hit kd tree is ready. ATTN The shared index also contains unavailable hits, but only hits added to clusters by
+    // this algorithm, which must have been available, are ever used from the hit searches
+    m_spHitsSpatialIndex = CaloHitSpatialIndex::GetSharedIndex(*this, *pCaloHitList);
 
     return STATUS_CODE_SUCCESS;
 }
@@ -190,14 +213,22 @@ StatusCode ConeClusteringAlgorithm::SeedClustersWithTracks(const TrackList *cons
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-StatusCode ConeClusteringAlgorithm::GetCurrentClusterFitResults(const ClusterVector &clusterVector, ClusterFitResultMap &clusterFitResultMap) const
+StatusCode ConeClusteringAlgorithm::GetCurrentClusterFitResults(const ClusterVector &clusterVector, ClusterToNCaloHitsMap &clusterFitNCaloHitsMap,
+    ClusterFitResultMap &clusterFitResultMap) const
 {
-    if (!clusterFitResultMap.empty())
+    if (clusterFitNCaloHitsMap.size() != clusterFitResultMap.size())
         return STATUS_CODE_INVALID_PARAMETER;
 
     for (ClusterVector::const_iterator iter = clusterVector.begin(), iterEnd = clusterVector.end(); iter != iterEnd; ++iter)
     {
         const Cluster *const pCluster = *iter;
+
+        // Clusters only ever gain hits during clustering, so the fit result of a cluster with an unchanged number of hits is still current
+        ClusterToNCaloHitsMap::iterator nCaloHitsIter(clusterFitNCaloHitsMap.find(pCluster));
+
+        if ((clusterFitNCaloHitsMap.end() != nCaloHitsIter) && (nCaloHitsIter->second == pCluster->GetNCaloHits()))
+            continue;
+
         ClusterFitResult clusterFitResult;
 
         if (pCluster->GetNCaloHits() > 1)
@@ -237,8 +268,8 @@ StatusCode ConeClusteringAlgorithm::GetCurrentClusterFitResults(const ClusterVec
             }
         }
 
-        if (!clusterFitResultMap.insert(ClusterFitResultMap::value_type(pCluster, clusterFitResult)).second)
-            return STATUS_CODE_FAILURE;
+        clusterFitResultMap[pCluster] = clusterFitResult;
+        clusterFitNCaloHitsMap[pCluster] = pCluster->GetNCaloHits();
     }
 
     return STATUS_CODE_SUCCESS;
@@ -246,103 +277,203 @@ StatusCode ConeClusteringAlgorithm::GetCurrentClusterFitResults(const ClusterVec
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-// inprogress
 StatusCode ConeClusteringAlgorithm::FindHitsInPreviousLayers(unsigned int pseudoLayer, const CaloHitVector &relevantCaloHits,
-    const ClusterFitResultMap &clusterFitResultMap, ClusterVector & /*clusterVector*/)
+    const ClusterFitResultMap &clusterFitResultMap, ClusterVector &clusterVector)
 {
-    const float maxTrackSeedSeparation = std::sqrt(m_maxTrackSeedSeparation2);
+    const unsigned int nThreads(ParallelFor::GetNThreads(relevantCaloHits.size(), m_nThreads, m_minHitsPerThread));
+
+    if (nThreads > 1)
+        return this->FindHitsInPreviousLayersMultiThreaded(pseudoLayer, relevantCaloHits, clusterFitResultMap, clusterVector, nThreads);
 
-    std::vector<HitKDNode> found_hits;
-    std::vector<TrackKDNode> found_tracks;
-    ClusterSet nearby_clusters;
+    SearchBuffers &searchBuffers(m_searchBuffers.front());
 
     for (const CaloHit *const pCaloHit : relevantCaloHits)
     {
         if (!PandoraContentApi::IsAvailable(*this, pCaloHit))
             continue;
 
-        const float additionalPadWidths = ((PandoraContentApi::GetGeometry(*this)->GetHitTypeGranularity(pCaloHit->GetHitType()) <= FINE) ?
-            m_additionalPadWidthsFine * pCaloHit->GetCellLengthScale() : m_additionalPadWidthsCoarse * pCaloHit->GetCellLengthScale());
-        const float largestAllowedDistanceForSearch = std::max(maxTrackSeedSeparation, m_maxClusterDirProjection + additionalPadWidths);
-
         const Cluster *pBestCluster = nullptr;
-        float bestClusterEnergy(0.f);
-        float smallestGenericDistance(m_genericDistanceCut);
-        const unsigned int layersToStepBack((PandoraContentApi::GetGeometry(*this)->GetHitTypeGranularity(pCaloHit->GetHitType()) <= FINE) ?
-            m_layersToStepBackFine : m_layersToStepBackCoarse);
 
-        // Associate with existing clusters in stepBack layers. If stepBackLayer == pseudoLayer, will examine track projections
-        for (unsigned int stepBackLayer = 1; (stepBackLayer <= layersToStepBack) && (stepBackLayer <= pseudoLayer); ++stepBackLayer)
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->FindBestClusterInPreviousLayers(pseudoLayer, pCaloHit, clusterFitResultMap,
+            searchBuffers, pBestCluster, searchBuffers.m_candidateClusters));
+
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->AddToBestCluster(pCaloHit, pBestCluster));
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode ConeClusteringAlgorithm::FindHitsInPreviousLayersMultiThreaded(unsigned int pseudoLayer, const CaloHitVector &relevantCaloHits,
+    const ClusterFitResultMap &clusterFitResultMap, const ClusterVector &clusterVector, const unsigned int nThreads)
+{
+    CaloHitVector availableCaloHits;
+
+    for (const CaloHit *const pCaloHit : relevantCaloHits)
+    {
+        if (PandoraContentApi::IsAvailable(*this, pCaloHit))
+            availableCaloHits.push_back(pCaloHit);
+    }
+
+    // ATTN Where there is no cluster fit result, the cone approach distance uses the cluster initial direction, which is fitted on first
+    // access. Fit it here, serially, for every cluster with a direction to fit: any cluster may be nominated by the kd-tree searches
+    for (const Cluster *const pCluster : clusterVector)
+    {
+        if (pCluster->IsTrackSeeded() || (pCluster->GetNCaloHits() > 0))
+            (void) pCluster->GetInitialDirection();
+    }
+
+    // The searches only examine hits in previous layers, so each can be performed concurrently against the clusters as they stand at
+    // the start of this layer
+    HitAssociationVector hitAssociations(availableCaloHits.size());
+    m_pParallelFor->Run(availableCaloHits.size(), nThreads, std::bind(&ConeClusteringAlgorithm::FindBestClustersInPreviousLayers, this,
+        pseudoLayer, std::cref(availableCaloHits), std::cref(clusterFitResultMap), std::placeholders::_1, std::placeholders::_2,
+        std::placeholders::_3, std::ref(m_searchBuffers), std::ref(hitAssociations)));
+
+    // Make the associations in the original hit order. Adding a hit to a cluster changes its energy, number of hits and initial direction,
+    // so any hit for which an examined cluster has already gained a hit in this layer is searched again, against the updated clusters
+    SearchBuffers &searchBuffers(m_searchBuffers.front());
+    ClusterSet modifiedClusters;
+
+    for (unsigned int iHit = 0, nHits = availableCaloHits.size(); iHit < nHits; ++iHit)
+    {
+        const CaloHit *const pCaloHit(availableCaloHits.at(iHit));
+        const HitAssociation &hitAssociation(hitAssociations.at(iHit));
+
+        if (STATUS_CODE_SUCCESS != hitAssociation.m_statusCode)
+            return hitAssociation.m_statusCode;
+
+        const Cluster *pBestCluster(hitAssociation.m_pBestCluster);
+        bool isCandidateModified(false);
+
+        for (const Cluster *const pCandidateCluster : hitAssociation.m_candidateClusters)
         {
-            const unsigned int searchLayer(pseudoLayer - stepBackLayer);
-
-            // need to reorganize this to use a kd-tree. On rechits comprising clusters we are mutating
-            // goal -> determine search distances for KD-tree from cut values and associated scalings
-            // search for tracks that would satisfy the search criteria in GetGenericDistanceToHit()
-            KDTreeCube searchRegionTks = build_3d_kd_search_region(pCaloHit, largestAllowedDistanceForSearch, largestAllowedDistanceForSearch, largestAllowedDistanceForSearch);
-            m_tracksKdTree.search(searchRegionTks,found_tracks);
-            for (auto &track : found_tracks )
+            if (modifiedClusters.count(pCandidateCluster))
             {
-                auto assc_cluster = m_tracksToClusters.find(track.data);
-                if (assc_cluster != m_tracksToClusters.end())
-                {
-                    nearby_clusters.insert(assc_cluster->second);
-                }
+                isCandidateModified = true;
+                break;
             }
-            found_tracks.clear();
+        }
 
-            // now search for hits-in-clusters that would also satisfy the criteria
-            KDTreeTesseract searchRegionHits = build_4d_kd_search_region(pCaloHit, largestAllowedDistanceForSearch, largestAllowedDistanceForSearch, largestAllowedDistanceForSearch, searchLayer);
-            m_hitsKdTree.search(searchRegionHits,found_hits);
-            for (auto &hit : found_hits)
-            {
-                auto assc_cluster = m_hitsToClusters.find(hit.data);
-                if (assc_cluster != m_hitsToClusters.end())
-                {
-                    nearby_clusters.insert(assc_cluster->second);
-                }
-            }
-            found_hits.clear();
+        if (isCandidateModified)
+        {
+            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->FindBestClusterInPreviousLayers(pseudoLayer, pCaloHit, clusterFitResultMap,
+                searchBuffers, pBestCluster, searchBuffers.m_candidateClusters));
+        }
 
-            ClusterList nearbyClusterList(nearby_clusters.begin(), nearby_clusters.end());
-            nearbyClusterList.sort(SortingHelper::SortClustersByNHits);
-            nearby_clusters.clear();
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->AddToBestCluster(pCaloHit, pBestCluster));
 
-            // Instead of using the full cluster list we use only those clusters that are found to be nearby according to the KD-tree
-            // ---- This can be optimized further for sure. (for instance having a match by KD-tree qualifies a ton of the loops later
-            // See if hit should be associated with any existing clusters
-            for (const Cluster *const pCluster : nearbyClusterList)
-            {
-                float genericDistance(std::numeric_limits<float>::max());
-                const float clusterEnergy(pCluster->GetHadronicEnergy());
+        if (nullptr != pBestCluster)
+            modifiedClusters.insert(pBestCluster);
+    }
 
-                PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_UNCHANGED, !=, this->GetGenericDistanceToHit(pCluster,
-                    pCaloHit, searchLayer, clusterFitResultMap, genericDistance));
+    return STATUS_CODE_SUCCESS;
+}
 
-                if ((genericDistance < smallestGenericDistance) ||
-                    ((genericDistance == smallestGenericDistance) && (clusterEnergy > bestClusterEnergy)))
-                {
-                    pBestCluster = pCluster;
-                    bestClusterEnergy = clusterEnergy;
-                    smallestGenericDistance = genericDistance;
-                }
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ConeClusteringAlgorithm::FindBestClustersInPreviousLayers(const unsigned int pseudoLayer, const CaloHitVector &caloHits,
+    const ClusterFitResultMap &clusterFitResultMap, const unsigned int firstHitIndex, const unsigned int endHitIndex,
+    const unsigned int rangeIndex, SearchBuffersVector &searchBuffersVector, HitAssociationVector &hitAssociations) const
+{
+    SearchBuffers &searchBuffers(searchBuffersVector.at(rangeIndex));
+
+    for (unsigned int iHit = firstHitIndex; iHit < endHitIndex; ++iHit)
+    {
+        HitAssociation &hitAssociation(hitAssociations.at(iHit));
+
+        hitAssociation.m_statusCode = this->FindBestClusterInPreviousLayers(pseudoLayer, caloHits.at(iHit), clusterFitResultMap,
+            searchBuffers, hitAssociation.m_pBestCluster, hitAssociation.m_candidateClusters);
+
+        if (STATUS_CODE_SUCCESS != hitAssociation.m_statusCode)
+            return;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode ConeClusteringAlgorithm::FindBestClusterInPreviousLayers(const unsigned int pseudoLayer, const CaloHit *const pCaloHit,
+    const ClusterFitResultMap &clusterFitResultMap, SearchBuffers &searchBuffers, const Cluster *&pBestCluster, ClusterVector &candidateClusters) const
+{
+    const float maxTrackSeedSeparation = std::sqrt(m_maxTrackSeedSeparation2);
+    const float additionalPadWidths = ((PandoraContentApi::GetGeometry(*this)->GetHitTypeGranularity(pCaloHit->GetHitType()) <= FINE) ?
+        m_additionalPadWidthsFine * pCaloHit->GetCellLengthScale() : m_additionalPadWidthsCoarse * pCaloHit->GetCellLengthScale());
+    const float largestAllowedDistanceForSearch = std::max(maxTrackSeedSeparation, m_maxClusterDirProjection + additionalPadWidths);
+
+    pBestCluster = nullptr;
+    candidateClusters.clear();
+    float bestClusterEnergy(0.f);
+    float smallestGenericDistance(m_genericDistanceCut);
+    const unsigned int layersToStepBack((PandoraContentApi::GetGeometry(*this)->GetHitTypeGranularity(pCaloHit->GetHitType()) <= FINE) ?
+        m_layersToStepBackFine : m_layersToStepBackCoarse);
+
+    std::vector<HitKDNode> &found_hits(searchBuffers.m_foundHits);
+    std::vector<TrackKDNode> &found_tracks(searchBuffers.m_foundTracks);
+    ClusterVector &nearby_clusters(searchBuffers.m_nearbyClusters);
+
+    // Associate with existing clusters in stepBack layers. If stepBackLayer == pseudoLayer, will examine track projections
+    for (unsigned int stepBackLayer = 1; (stepBackLayer <= layersToStepBack) && (stepBackLayer <= pseudoLayer); ++stepBackLayer)
+    {
+        const unsigned int searchLayer(pseudoLayer - stepBackLayer);
+
+        // need to reorganize this to use a kd-tree. On rechits comprising clusters we are mutating
+        // goal -> determine search distances for KD-tree from cut values and associated scalings
+        // search for tracks that would satisfy the search criteria in GetGenericDistanceToHit()
+        KDTreeCube searchRegionTks = build_3d_kd_search_region(pCaloHit, largestAllowedDistanceForSearch, largestAllowedDistanceForSearch, largestAllowedDistanceForSearch);
+        m_tracksKdTree.search(searchRegionTks,found_tracks);
+        for (auto &track : found_tracks )
+        {
+            auto assc_cluster = m_tracksToClusters.find(track.data);
+            if (assc_cluster != m_tracksToClusters.end())
+            {
+                this->AddNearbyCluster(assc_cluster->second, nearby_clusters);
             }
+        }
+        found_tracks.clear();
 
-            // Add best hit found after completing examination of a stepback layer
-            if ((0 == m_clusterFormationStrategy) && (nullptr != pBestCluster))
+        // now search for hits-in-clusters that would also satisfy the criteria
+        KDTreeTesseract searchRegionHits = build_4d_kd_search_region(pCaloHit, largestAllowedDistanceForSearch, largestAllowedDistanceForSearch, largestAllowedDistanceForSearch, searchLayer);
+        m_spHitsSpatialIndex->GetKDTree4D().search(searchRegionHits,found_hits);
+        for (auto &hit : found_hits)
+        {
+            auto assc_cluster = m_hitsToClusters.find(hit.data);
+            if (assc_cluster != m_hitsToClusters.end())
             {
-                PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::AddToCluster(*this, pBestCluster, pCaloHit));
-                m_hitsToClusters.emplace(pCaloHit, pBestCluster);
-                break;
+                this->AddNearbyCluster(assc_cluster->second, nearby_clusters);
             }
         }
+        found_hits.clear();
+
+        // Instead of using the full cluster list we use only those clusters that are found to be nearby according to the KD-tree
+        // See if hit should be associated with any existing clusters
+        const Cluster *pBestLayerCluster(nullptr);
+        float bestLayerClusterEnergy(0.f);
+        float smallestLayerGenericDistance(m_genericDistanceCut);
 
-        // Add best hit found after examining all stepback layers
-        if ((1 == m_clusterFormationStrategy) && (nullptr != pBestCluster))
+        const StatusCode statusCode(this->FindBestNearbyCluster(pCaloHit, searchLayer, clusterFitResultMap, nearby_clusters,
+            pBestLayerCluster, bestLayerClusterEnergy, smallestLayerGenericDistance));
+
+        for (const Cluster *const pNearbyCluster : nearby_clusters)
+            this->AddNearbyCluster(pNearbyCluster, candidateClusters);
+
+        nearby_clusters.clear();
+
+        if (STATUS_CODE_SUCCESS != statusCode)
+            return statusCode;
+
+        // ATTN Complete ties are resolved within a stepback layer; a cluster from a later stepback layer must be strictly better
+        if ((nullptr != pBestLayerCluster) && ((smallestLayerGenericDistance < smallestGenericDistance) ||
+            ((smallestLayerGenericDistance == smallestGenericDistance) && (bestLayerClusterEnergy > bestClusterEnergy))))
         {
-            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::AddToCluster(*this, pBestCluster, pCaloHit));
-            m_hitsToClusters.emplace(pCaloHit, pBestCluster);
+            pBestCluster = pBestLayerCluster;
+            bestClusterEnergy = bestLayerClusterEnergy;
+            smallestGenericDistance = smallestLayerGenericDistance;
         }
+
+        // Use best hit found after completing examination of a stepback layer
+        if ((0 == m_clusterFormationStrategy) && (nullptr != pBestCluster))
+            break;
     }
 
     return STATUS_CODE_SUCCESS;
@@ -350,158 +481,188 @@ StatusCode ConeClusteringAlgorithm::FindHitsInPreviousLayers(unsigned int pseudo
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+void ConeClusteringAlgorithm::AddNearbyCluster(const Cluster *const pCluster, ClusterVector &nearbyClusters) const
+{
+    // ATTN Keep the (short) vector ordered by address, for quick rejection of duplicates. The order does not affect the choice of cluster
+    ClusterVector::iterator iter(std::lower_bound(nearbyClusters.begin(), nearbyClusters.end(), pCluster, std::less<const Cluster*>()));
+
+    if ((nearbyClusters.end() == iter) || (pCluster != *iter))
+        nearbyClusters.insert(iter, pCluster);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode ConeClusteringAlgorithm::FindBestNearbyCluster(const CaloHit *const pCaloHit, const unsigned int searchLayer,
+    const ClusterFitResultMap &clusterFitResultMap, const ClusterVector &nearbyClusters, const Cluster *&pBestCluster, float &bestClusterEnergy,
+    float &smallestGenericDistance) const
+{
+    for (const Cluster *const pCluster : nearbyClusters)
+    {
+        float genericDistance(std::numeric_limits<float>::max());
+        const float clusterEnergy(pCluster->GetHadronicEnergy());
+
+        PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_UNCHANGED, !=, this->GetGenericDistanceToHit(pCluster,
+            pCaloHit, searchLayer, clusterFitResultMap, genericDistance));
+
+        // Complete ties are resolved as if the clusters were examined in order of SortingHelper::SortClustersByNHits
+        if ((genericDistance < smallestGenericDistance) ||
+            ((genericDistance == smallestGenericDistance) && (clusterEnergy > bestClusterEnergy)) ||
+            ((genericDistance == smallestGenericDistance) && (clusterEnergy == bestClusterEnergy) && (nullptr != pBestCluster) &&
+                SortingHelper::SortClustersByNHits(pCluster, pBestCluster)))
+        {
+            pBestCluster = pCluster;
+            bestClusterEnergy = clusterEnergy;
+            smallestGenericDistance = genericDistance;
+        }
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode ConeClusteringAlgorithm::AddToBestCluster(const CaloHit *const pCaloHit, const Cluster *const pBestCluster)
+{
+    // Add best hit found after examining the first stepback layer with a match, or all stepback layers, depending on formation strategy
+    if ((nullptr == pBestCluster) || ((0 != m_clusterFormationStrategy) && (1 != m_clusterFormationStrategy)))
+        return STATUS_CODE_SUCCESS;
+
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::AddToCluster(*this, pBestCluster, pCaloHit));
+    m_hitsToClusters.emplace(pCaloHit, pBestCluster);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode ConeClusteringAlgorithm::FindHitsInSameLayer(unsigned int pseudoLayer, const CaloHitVector &relevantCaloHits,
     const ClusterFitResultMap &clusterFitResultMap, ClusterVector &clusterVector)
 {
     const float maxTrackSeedSeparation = std::sqrt(m_maxTrackSeedSeparation2);
 
-    //keep a list of available hits with the most energetic available hit at the back
-    std::list<unsigned> available_hits_in_layer;
+    SearchBuffers &searchBuffers(m_searchBuffers.front());
+    std::vector<HitKDNode> &found_hits(searchBuffers.m_foundHits);
+    std::vector<TrackKDNode> &found_tracks(searchBuffers.m_foundTracks);
+    ClusterVector &nearby_clusters(searchBuffers.m_nearbyClusters);
+
+    //keep a list of available hits, in their original order
+    std::vector<unsigned int> &available_hits_in_layer(searchBuffers.m_availableHitIndices);
+    available_hits_in_layer.clear();
+
+    //tactical cache hits -> tracks and hits -> hits. The kd-tree search results for the hit with index i in the relevant hit vector
+    //are stored in the ranges [offsets[i], offsets[i + 1]) of the corresponding vectors
+    std::vector<const Track*> &nearby_tracks(searchBuffers.m_nearbyTracks);
+    std::vector<unsigned int> &nearby_track_offsets(searchBuffers.m_nearbyTrackOffsets);
+    std::vector<const CaloHit*> &nearby_hits(searchBuffers.m_nearbyHits);
+    std::vector<unsigned int> &nearby_hit_offsets(searchBuffers.m_nearbyHitOffsets);
+    nearby_tracks.clear(); nearby_track_offsets.assign(1, 0);
+    nearby_hits.clear(); nearby_hit_offsets.assign(1, 0);
+
     for (unsigned i = 0; i < relevantCaloHits.size(); ++i )
     {
-        if (!PandoraContentApi::IsAvailable(*this, relevantCaloHits[i]))
-            continue;
-        available_hits_in_layer.push_back(i);
-    }
+        const CaloHit *const pCaloHit = relevantCaloHits[i];
 
-    //tactical cache hits -> tracks
-    std::unordered_multimap<const CaloHit*, const Track*> hitsToTracksLocal;
+        if (!PandoraContentApi::IsAvailable(*this, pCaloHit))
+        {
+            nearby_track_offsets.push_back(nearby_tracks.size());
+            nearby_hit_offsets.push_back(nearby_hits.size());
+            continue;
+        }
 
-    //tactical cache hits -> hits
-    std::unordered_multimap<const CaloHit*, const CaloHit*> hitsToHitsLocal;
+        available_hits_in_layer.push_back(i);
 
-    //pull out result caches to help keep memory locality
-    std::vector<TrackKDNode> found_tracks;
-    std::vector<HitKDNode> found_hits;
+        const float pad_search_width = ((PandoraContentApi::GetGeometry(*this)->GetHitTypeGranularity(pCaloHit->GetHitType()) <= FINE) ?
+            (m_sameLayerPadWidthsFine * pCaloHit->GetCellLengthScale()) :
+            (m_sameLayerPadWidthsCoarse * pCaloHit->GetCellLengthScale()) );
+
+        const float track_search_width = maxTrackSeedSeparation;
+        const float hit_search_width = pad_search_width;
+
+        // search for tracks that would satisfy the search criteria in GetGenericDistanceToHit()
+        KDTreeCube searchRegionTks = build_3d_kd_search_region(pCaloHit, track_search_width, track_search_width, track_search_width);
+        m_tracksKdTree.search(searchRegionTks,found_tracks);
+        for (auto &track : found_tracks)
+            nearby_tracks.push_back(track.data);
+        nearby_track_offsets.push_back(nearby_tracks.size());
+        found_tracks.clear();
+
+        // now search for hits-in-clusters that would also satisfy the criteria
+        KDTreeTesseract searchRegionHits = build_4d_kd_search_region(pCaloHit, hit_search_width, hit_search_width, hit_search_width, pseudoLayer);
+        m_spHitsSpatialIndex->GetKDTree4D().search(searchRegionHits,found_hits);
+        for (auto &hit : found_hits)
+            nearby_hits.push_back(hit.data);
+        nearby_hit_offsets.push_back(nearby_hits.size());
+        found_hits.clear();
+    }
 
-    ClusterSet nearby_clusters;
+    // hits before firstAvailable have been used to seed new clusters, so seeding never shifts the remaining entries
+    unsigned firstAvailable = 0;
 
-    while (!available_hits_in_layer.empty())
+    while (firstAvailable < available_hits_in_layer.size())
     {
         bool clustersModified = true;
 
         while (clustersModified)
         {
             clustersModified = false;
+            unsigned nStillAvailable = firstAvailable;
 
-            for (auto iter = available_hits_in_layer.begin(); iter != available_hits_in_layer.end();)
+            for (unsigned iAvailable = firstAvailable; iAvailable < available_hits_in_layer.size(); ++iAvailable)
             {
                 // this his is assured to be usable by the lines above and algorithm course
-                const CaloHit *const pCaloHit = relevantCaloHits[*iter];
-
-                const float pad_search_width = ((PandoraContentApi::GetGeometry(*this)->GetHitTypeGranularity(pCaloHit->GetHitType()) <= FINE) ?
-                    (m_sameLayerPadWidthsFine * pCaloHit->GetCellLengthScale()) :
-                    (m_sameLayerPadWidthsCoarse * pCaloHit->GetCellLengthScale()) );
-
-                const float track_search_width = maxTrackSeedSeparation;
-                const float hit_search_width = pad_search_width;
+                const unsigned index = available_hits_in_layer[iAvailable];
+                const CaloHit *const pCaloHit = relevantCaloHits[index];
 
                 const Cluster *pBestCluster = nullptr;
                 float bestClusterEnergy(0.f);
                 float smallestGenericDistance(m_genericDistanceCut);
 
-                // search for tracks that would satisfy the search criteria in GetGenericDistanceToHit()
-                auto track_assc_cache = hitsToTracksLocal.find(pCaloHit);
-                if (track_assc_cache != hitsToTracksLocal.end())
-                {
-                    auto range = hitsToTracksLocal.equal_range(pCaloHit);
-                    for (auto itr = range.first; itr != range.second; ++itr)
-                    {
-                        auto assc_cluster = m_tracksToClusters.find(itr->second);
-                        if(assc_cluster != m_tracksToClusters.end())
-                        {
-                            nearby_clusters.insert(assc_cluster->second);
-                        }
-                    }
-                }
-                else
-                {
-                    KDTreeCube searchRegionTks = build_3d_kd_search_region(pCaloHit, track_search_width, track_search_width, track_search_width);
-                    m_tracksKdTree.search(searchRegionTks,found_tracks);
-                    for (auto &track : found_tracks)
-                    {
-                        hitsToTracksLocal.emplace(pCaloHit, track.data);
-                        auto assc_cluster = m_tracksToClusters.find(track.data);
-                        if (assc_cluster != m_tracksToClusters.end())
-                        {
-                            nearby_clusters.insert(assc_cluster->second);
-                        }
-                    }
-                    found_tracks.clear();
-                }
-                // now search for hits-in-clusters that would also satisfy the criteria
-                auto hits_assc_cache = hitsToHitsLocal.find(pCaloHit);
-                if (hits_assc_cache != hitsToHitsLocal.end())
+                for (unsigned j = nearby_track_offsets[index]; j < nearby_track_offsets[index + 1]; ++j)
                 {
-                    auto range = hitsToHitsLocal.equal_range(pCaloHit);
-                    for (auto itr = range.first; itr != range.second; ++itr)
+                    auto assc_cluster = m_tracksToClusters.find(nearby_tracks[j]);
+                    if (assc_cluster != m_tracksToClusters.end())
                     {
-                        auto assc_cluster = m_hitsToClusters.find(itr->second);
-                        if( assc_cluster != m_hitsToClusters.end() )
-                        {
-                            nearby_clusters.insert(assc_cluster->second);
-                        }
+                        this->AddNearbyCluster(assc_cluster->second, nearby_clusters);
                     }
                 }
-                else
+
+                for (unsigned j = nearby_hit_offsets[index]; j < nearby_hit_offsets[index + 1]; ++j)
                 {
-                    KDTreeTesseract searchRegionHits = build_4d_kd_search_region(pCaloHit, hit_search_width, hit_search_width, hit_search_width, pseudoLayer);
-                    m_hitsKdTree.search(searchRegionHits,found_hits);
-                    for (auto &hit : found_hits)
+                    auto assc_cluster = m_hitsToClusters.find(nearby_hits[j]);
+                    if (assc_cluster != m_hitsToClusters.end())
                     {
-                        hitsToHitsLocal.emplace(pCaloHit, hit.data);
-                        auto assc_cluster = m_hitsToClusters.find(hit.data);
-                        if (assc_cluster != m_hitsToClusters.end())
-                        {
-                            nearby_clusters.insert(assc_cluster->second);
-                        }
+                        this->AddNearbyCluster(assc_cluster->second, nearby_clusters);
                     }
-                    found_hits.clear();
                 }
 
-                ClusterList nearbyClusterList(nearby_clusters.begin(), nearby_clusters.end());
-                nearbyClusterList.sort(SortingHelper::SortClustersByNHits);
-                nearby_clusters.clear();
-
                 // See if hit should be associated with any existing clusters
-                for (ClusterList::iterator clusterIter = nearbyClusterList.begin(), clusterIterEnd = nearbyClusterList.end();
-                    clusterIter != clusterIterEnd; ++clusterIter)
-                {
-                    const Cluster *const pCluster = *clusterIter;
-                    float genericDistance(std::numeric_limits<float>::max());
-                    const float clusterEnergy(pCluster->GetHadronicEnergy());
-
-                    PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_UNCHANGED, !=, this->GetGenericDistanceToHit(pCluster,
-                        pCaloHit, pseudoLayer, clusterFitResultMap, genericDistance));
+                const StatusCode statusCode(this->FindBestNearbyCluster(pCaloHit, pseudoLayer, clusterFitResultMap, nearby_clusters, pBestCluster,
+                    bestClusterEnergy, smallestGenericDistance));
+                nearby_clusters.clear();
 
-                    if ((genericDistance < smallestGenericDistance) || ((genericDistance == smallestGenericDistance) && (clusterEnergy > bestClusterEnergy)))
-                    {
-                        pBestCluster = pCluster;
-                        bestClusterEnergy = clusterEnergy;
-                        smallestGenericDistance = genericDistance;
-                    }
-                }
+                if (STATUS_CODE_SUCCESS != statusCode)
+                    return statusCode;
 
                 if (nullptr != pBestCluster)
                 {
                     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::AddToCluster(*this, pBestCluster, pCaloHit));
                     m_hitsToClusters.emplace(pCaloHit, pBestCluster);
                     // remove this hit and advance to the next
-                    iter = available_hits_in_layer.erase(iter);
                     clustersModified = true;
                 }
                 else
-                { // otherwise advance the iterator
-                    ++iter;
+                { // otherwise keep the hit, preserving the order of the list
+                    available_hits_in_layer[nStillAvailable++] = index;
                 }
             }
+
+            available_hits_in_layer.resize(nStillAvailable);
         }
 
         // If there is no cluster within the search radius, seed a new cluster with this hit
-        if (!available_hits_in_layer.empty())
+        if (firstAvailable < available_hits_in_layer.size())
         {
-            unsigned index = *(available_hits_in_layer.begin());
-            available_hits_in_layer.pop_front();
+            unsigned index = available_hits_in_layer[firstAvailable++];
             const CaloHit *const  pCaloHit = relevantCaloHits[index];
             // hit is assured to be valid
             const Cluster *pCluster = nullptr;
@@ -819,6 +980,16 @@ StatusCode ConeClusteringAlgorithm::RemoveEmptyClusters(const ClusterVector &clu
     return STATUS_CODE_SUCCESS;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+ConeClusteringAlgorithm::HitAssociation::HitAssociation() :
+    m_pBestCluster(nullptr),
+    m_statusCode(STATUS_CODE_NOT_INITIALIZED)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 StatusCode ConeClusteringAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
@@ -941,6 +1112,18 @@ StatusCode ConeClusteringAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
         "MipTrackChi2Cut", m_mipTrackChi2Cut));
 
+    // Multi-threading parameters
+    PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
+        "NThreads", m_nThreads));
+
+    if (0 == m_nThreads)
+        return STATUS_CODE_INVALID_PARAMETER;
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
+        "MinHitsPerThread", m_minHitsPerThread));
+
+    m_pParallelFor = new ParallelFor(m_nThreads);
+
     return STATUS_CODE_SUCCESS;
 }
 
@@ -14,7 +14,11 @@
 #include "LCHelpers/ReclusterHelper.h"
 #include "LCHelpers/SortingHelper.h"
 
+#include "LCUtility/ParallelFor.h"
+
+#include <algorithm>
 #include <cstdlib>
+#include <functional>
 
 using namespace pandora;
 
@@ -99,7 +103,10 @@ MainFragmentRemovalAlgorithm::MainFragmentRemovalAlgorithm() :
     m_photonCorrection5(2.f),
     m_photonCorrection6(2.f),
     m_photonCorrection7(0.f),
-    m_minRequiredEvidence(0.5f)
+    m_minRequiredEvidence(0.5f),
+    m_nThreads(1),
+    m_minPairsPerThread(50),
+    m_pParallelFor(NULL)
 {
     m_contactParameters.m_coneCosineHalfAngle1 = 0.9f;
     m_contactParameters.m_coneCosineHalfAngle2 = 0.95f;
@@ -118,33 +125,89 @@ MainFragmentRemovalAlgorithm::MainFragmentRemovalAlgorithm() :
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+MainFragmentRemovalAlgorithm::~MainFragmentRemovalAlgorithm()
+{
+    delete m_pParallelFor;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode MainFragmentRemovalAlgorithm::Run()
 {
-    bool isFirstPass(true), shouldRecalculate(true);
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->MakeTrackHelixTrajectories());
 
     ClusterSet affectedClusters;
     ChargedClusterContactMap chargedClusterContactMap;
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetChargedClusterContactMap(chargedClusterContactMap));
+
+    // Queue the best merge candidate for each daughter; after each merge, only the entries for the affected daughters are re-evaluated
+    MergeCandidateQueue mergeCandidateQueue;
+    MergeCandidateLocationMap mergeCandidateLocationMap;
 
-    while (shouldRecalculate)
+    for (ChargedClusterContactMap::const_iterator iter = chargedClusterContactMap.begin(), iterEnd = chargedClusterContactMap.end(); iter != iterEnd; ++iter)
+        this->UpdateMergeCandidate(iter->first, chargedClusterContactMap, mergeCandidateQueue, mergeCandidateLocationMap);
+
+    while (!mergeCandidateQueue.empty())
     {
-        shouldRecalculate = false;
-        const Cluster *pBestParentCluster(NULL), *pBestDaughterCluster(NULL);
+        const Cluster *const pBestParentCluster(mergeCandidateQueue.begin()->GetParentCluster());
+        const Cluster *const pBestDaughterCluster(mergeCandidateQueue.begin()->GetDaughterCluster());
+
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetAffectedClusters(chargedClusterContactMap, pBestParentCluster,
+            pBestDaughterCluster, affectedClusters));
 
-        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetChargedClusterContactMap(isFirstPass, affectedClusters, chargedClusterContactMap));
+        chargedClusterContactMap.erase(chargedClusterContactMap.find(pBestDaughterCluster));
+        mergeCandidateQueue.erase(mergeCandidateQueue.begin());
+        mergeCandidateLocationMap.erase(pBestDaughterCluster);
 
-        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetClusterMergingCandidates(chargedClusterContactMap, pBestParentCluster,
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::MergeAndDeleteClusters(*this, pBestParentCluster,
             pBestDaughterCluster));
 
-        if ((NULL != pBestParentCluster) && (NULL != pBestDaughterCluster))
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->UpdateChargedClusterContactMap(pBestParentCluster, affectedClusters,
+            chargedClusterContactMap));
+
+        for (ClusterSet::const_iterator iter = affectedClusters.begin(), iterEnd = affectedClusters.end(); iter != iterEnd; ++iter)
+            this->UpdateMergeCandidate(*iter, chargedClusterContactMap, mergeCandidateQueue, mergeCandidateLocationMap);
+    }
+
+    m_trackToHelixTrajectoryMap.clear();
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool MainFragmentRemovalAlgorithm::IsExcludedCluster(const Cluster *const pCluster) const
+{
+    const ParticleId *const pParticleId(PandoraContentApi::GetPlugins(*this)->GetParticleId());
+
+    return (pParticleId->IsMuon(pCluster) || pParticleId->IsElectron(pCluster));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MainFragmentRemovalAlgorithm::MakeTrackHelixTrajectories()
+{
+    m_trackToHelixTrajectoryMap.clear();
+
+    const ClusterList *pClusterList = NULL;
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetCurrentList(*this, pClusterList));
+
+    // Merges only ever add daughter candidates, without associated tracks, so the parent candidate tracks are fixed throughout the event
+    const float bField(PandoraContentApi::GetPlugins(*this)->GetBFieldPlugin()->GetBField(CartesianVector(0.f, 0.f, 0.f)));
+
+    for (ClusterList::const_iterator iter = pClusterList->begin(), iterEnd = pClusterList->end(); iter != iterEnd; ++iter)
+    {
+        const TrackList &trackList((*iter)->GetAssociatedTrackList());
+
+        for (TrackList::const_iterator trackIter = trackList.begin(), trackIterEnd = trackList.end(); trackIter != trackIterEnd; ++trackIter)
         {
-            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetAffectedClusters(chargedClusterContactMap, pBestParentCluster,
-                pBestDaughterCluster, affectedClusters));
+            const Track *const pTrack(*trackIter);
 
-            chargedClusterContactMap.erase(chargedClusterContactMap.find(pBestDaughterCluster));
-            shouldRecalculate = true;
+            if (m_trackToHelixTrajectoryMap.count(pTrack))
+                continue;
 
-            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::MergeAndDeleteClusters(*this, pBestParentCluster,
-                pBestDaughterCluster));
+            const Helix helix(pTrack->GetTrackStateAtCalorimeter().GetPosition(), pTrack->GetTrackStateAtCalorimeter().GetMomentum(), pTrack->GetCharge(), bField);
+            m_trackToHelixTrajectoryMap[pTrack].reset(new HelixTrajectory(this->GetPandora(), helix));
         }
     }
 
@@ -153,8 +216,7 @@ StatusCode MainFragmentRemovalAlgorithm::Run()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-StatusCode MainFragmentRemovalAlgorithm::GetChargedClusterContactMap(bool &isFirstPass, const ClusterSet &affectedClusters,
-    ChargedClusterContactMap &chargedClusterContactMap) const
+StatusCode MainFragmentRemovalAlgorithm::GetChargedClusterContactMap(ChargedClusterContactMap &chargedClusterContactMap) const
 {
     const ClusterList *pClusterList = NULL;
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetCurrentList(*this, pClusterList));
@@ -165,31 +227,20 @@ StatusCode MainFragmentRemovalAlgorithm::GetChargedClusterContactMap(bool &isFir
     for (ClusterList::const_iterator iter = pClusterList->begin(), iterEnd = pClusterList->end(); iter != iterEnd; ++iter)
     {
         const Cluster *const pCluster = *iter;
-        const ParticleId *const pParticleId(PandoraContentApi::GetPlugins(*this)->GetParticleId());
 
-        if (!pParticleId->IsMuon(pCluster) && !pParticleId->IsElectron(pCluster))
+        if (!this->IsExcludedCluster(pCluster))
         {
             clusterList.push_back(pCluster);
         }
     }
 
-    // Create cluster contacts
+    // Identify the candidate cluster pairings
+    ClusterPairVector clusterPairVector;
+
     for (ClusterList::const_iterator iterI = clusterList.begin(), iterIEnd = clusterList.end(); iterI != iterIEnd; ++iterI)
     {
         const Cluster *const pDaughterCluster = *iterI;
 
-        // Identify whether cluster contacts need to be recalculated
-        if (!isFirstPass)
-        {
-            if (affectedClusters.end() == affectedClusters.find(pDaughterCluster))
-                continue;
-
-            ChargedClusterContactMap::iterator pastEntryIter = chargedClusterContactMap.find(pDaughterCluster);
-
-            if (chargedClusterContactMap.end() != pastEntryIter)
-                chargedClusterContactMap.erase(pastEntryIter);
-        }
-
         // Apply simple daughter selection cuts
         if (!pDaughterCluster->GetAssociatedTrackList().empty())
             continue;
@@ -197,7 +248,6 @@ StatusCode MainFragmentRemovalAlgorithm::GetChargedClusterContactMap(bool &isFir
         if ((pDaughterCluster->GetNCaloHits() < m_minDaughterCaloHits) || (pDaughterCluster->GetHadronicEnergy() < m_minDaughterHadronicEnergy))
             continue;
 
-        // Calculate the cluster contact information
         for (ClusterList::const_iterator iterJ = clusterList.begin(), iterJEnd = clusterList.end(); iterJ != iterJEnd; ++iterJ)
         {
             const Cluster *const pParentCluster = *iterJ;
@@ -208,21 +258,169 @@ StatusCode MainFragmentRemovalAlgorithm::GetChargedClusterContactMap(bool &isFir
             if (pParentCluster->GetAssociatedTrackList().empty())
                 continue;
 
-            const ChargedClusterContact chargedClusterContact(this->GetPandora(), pDaughterCluster, pParentCluster, m_contactParameters);
+            clusterPairVector.push_back(ClusterPair(pDaughterCluster, pParentCluster));
+        }
+    }
+
+    // Calculate the cluster contact information
+    ChargedClusterContactVector chargedClusterContactVector;
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetChargedClusterContacts(clusterPairVector, chargedClusterContactVector));
+
+    for (ChargedClusterContactVector::const_iterator iter = chargedClusterContactVector.begin(), iterEnd = chargedClusterContactVector.end(); iter != iterEnd; ++iter)
+        chargedClusterContactMap[iter->GetDaughterCluster()].push_back(*iter);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MainFragmentRemovalAlgorithm::UpdateChargedClusterContactMap(const Cluster *const pParentCluster, const ClusterSet &affectedClusters,
+    ChargedClusterContactMap &chargedClusterContactMap) const
+{
+    // Daughter candidates never have associated tracks, so the merge cannot affect their eligibility, nor their contacts with other parents
+    ClusterVector daughterClusterVector;
+    ClusterPairVector clusterPairVector;
+    const bool isExcludedParent(this->IsExcludedCluster(pParentCluster));
+
+    for (ClusterSet::const_iterator iter = affectedClusters.begin(), iterEnd = affectedClusters.end(); iter != iterEnd; ++iter)
+    {
+        if (chargedClusterContactMap.end() == chargedClusterContactMap.find(*iter))
+            continue;
+
+        daughterClusterVector.push_back(*iter);
+
+        if (!isExcludedParent)
+            clusterPairVector.push_back(ClusterPair(*iter, pParentCluster));
+    }
+
+    ChargedClusterContactVector updatedContactVector;
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetChargedClusterContacts(clusterPairVector, updatedContactVector));
+
+    // The updated contacts are in daughter order, with no entry for any daughter whose contact no longer passes the contact cuts
+    ChargedClusterContactVector::const_iterator updatedIter(updatedContactVector.begin());
+
+    for (ClusterVector::const_iterator iter = daughterClusterVector.begin(), iterEnd = daughterClusterVector.end(); iter != iterEnd; ++iter)
+    {
+        const Cluster *const pDaughterCluster = *iter;
+        const bool hasUpdatedContact((updatedContactVector.end() != updatedIter) && (pDaughterCluster == updatedIter->GetDaughterCluster()));
+
+        ChargedClusterContactMap::iterator mapIter = chargedClusterContactMap.find(pDaughterCluster);
+        ChargedClusterContactVector &chargedClusterContactVector(mapIter->second);
 
-            if (this->PassesClusterContactCuts(chargedClusterContact))
+        for (ChargedClusterContactVector::iterator contactIter = chargedClusterContactVector.begin(); contactIter != chargedClusterContactVector.end(); )
+        {
+            if (pParentCluster != contactIter->GetParentCluster())
+            {
+                ++contactIter;
+            }
+            else if (hasUpdatedContact)
             {
-                chargedClusterContactMap[pDaughterCluster].push_back(chargedClusterContact);
+                *contactIter = *updatedIter;
+                ++contactIter;
             }
+            else
+            {
+                contactIter = chargedClusterContactVector.erase(contactIter);
+            }
+        }
+
+        if (hasUpdatedContact)
+            ++updatedIter;
+
+        if (chargedClusterContactVector.empty())
+            chargedClusterContactMap.erase(mapIter);
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MainFragmentRemovalAlgorithm::GetChargedClusterContacts(const ClusterPairVector &clusterPairVector,
+    ChargedClusterContactVector &chargedClusterContactVector) const
+{
+    const unsigned int nPairs(clusterPairVector.size());
+    const unsigned int nThreads(ParallelFor::GetNThreads(nPairs, m_nThreads, m_minPairsPerThread));
+
+    if (nThreads > 1)
+    {
+        // ATTN The hit distance comparison reads the initial direction of both clusters, fitted on first access, so fit each here, serially.
+        // The cone fractions would also read the parent shower start layer, but only for parents without tracks, which are never paired
+        for (ClusterPairVector::const_iterator iter = clusterPairVector.begin(), iterEnd = clusterPairVector.end(); iter != iterEnd; ++iter)
+        {
+            (void) iter->first->GetInitialDirection();
+            (void) iter->second->GetInitialDirection();
         }
     }
-    isFirstPass = false;
+
+    // Each contact depends only upon its pair of clusters, so contiguous ranges of pairs can be shared between threads
+    ContactCalculationVector contactCalculations(nThreads);
+    m_pParallelFor->Run(nPairs, nThreads, std::bind(&MainFragmentRemovalAlgorithm::CalculateChargedClusterContacts, this,
+        std::cref(clusterPairVector), std::placeholders::_1, std::placeholders::_2, std::placeholders::_3, std::ref(contactCalculations)));
+
+    // Gather the results in range order, so the contacts are always in cluster pair order, independent of the number of threads
+    for (ContactCalculationVector::const_iterator iter = contactCalculations.begin(), iterEnd = contactCalculations.end(); iter != iterEnd; ++iter)
+    {
+        chargedClusterContactVector.insert(chargedClusterContactVector.end(), iter->m_chargedClusterContactVector.begin(),
+            iter->m_chargedClusterContactVector.end());
+    }
 
     return STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+void MainFragmentRemovalAlgorithm::CalculateChargedClusterContacts(const ClusterPairVector &clusterPairVector, const unsigned int firstPairIndex,
+    const unsigned int endPairIndex, const unsigned int rangeIndex, ContactCalculationVector &contactCalculations) const
+{
+    ChargedClusterContactVector &chargedClusterContactVector(contactCalculations.at(rangeIndex).m_chargedClusterContactVector);
+
+    for (unsigned int iPair = firstPairIndex; iPair < endPairIndex; ++iPair)
+    {
+        const ClusterPair &clusterPair(clusterPairVector.at(iPair));
+        const ChargedClusterContact chargedClusterContact(this->GetPandora(), clusterPair.first, clusterPair.second, m_contactParameters,
+            m_trackToHelixTrajectoryMap);
+
+        if (this->PassesClusterContactCuts(chargedClusterContact))
+            chargedClusterContactVector.push_back(chargedClusterContact);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void MainFragmentRemovalAlgorithm::UpdateMergeCandidate(const Cluster *const pDaughterCluster, const ChargedClusterContactMap &chargedClusterContactMap,
+    MergeCandidateQueue &mergeCandidateQueue, MergeCandidateLocationMap &mergeCandidateLocationMap)
+{
+    MergeCandidateLocationMap::iterator locationIter = mergeCandidateLocationMap.find(pDaughterCluster);
+
+    if (mergeCandidateLocationMap.end() != locationIter)
+    {
+        mergeCandidateQueue.erase(locationIter->second);
+        mergeCandidateLocationMap.erase(locationIter);
+    }
+
+    ChargedClusterContactMap::const_iterator mapIter = chargedClusterContactMap.find(pDaughterCluster);
+
+    if (chargedClusterContactMap.end() == mapIter)
+        return;
+
+    const Cluster *pBestParentCluster(NULL);
+    float highestExcessEvidence(0.f), highestEvidenceParentEnergy(0.f);
+
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetClusterMergingCandidate(pDaughterCluster, mapIter->second, pBestParentCluster,
+        highestExcessEvidence, highestEvidenceParentEnergy));
+
+    if (NULL == pBestParentCluster)
+        return;
+
+    const MergeCandidateQueue::const_iterator queueIter(mergeCandidateQueue.insert(MergeCandidate(pDaughterCluster, pBestParentCluster,
+        highestExcessEvidence, highestEvidenceParentEnergy)).first);
+
+    mergeCandidateLocationMap.insert(MergeCandidateLocationMap::value_type(pDaughterCluster, queueIter));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 bool MainFragmentRemovalAlgorithm::PassesClusterContactCuts(const ChargedClusterContact &chargedClusterContact) const
 {
     if (chargedClusterContact.GetDistanceToClosestHit() > m_contactCutMaxDistance)
@@ -244,46 +442,35 @@ bool MainFragmentRemovalAlgorithm::PassesClusterContactCuts(const ChargedCluster
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-StatusCode MainFragmentRemovalAlgorithm::GetClusterMergingCandidates(const ChargedClusterContactMap &chargedClusterContactMap, const Cluster *&pBestParentCluster,
-    const Cluster *&pBestDaughterCluster)
+StatusCode MainFragmentRemovalAlgorithm::GetClusterMergingCandidate(const Cluster *const pDaughterCluster,
+    const ChargedClusterContactVector &chargedClusterContactVector, const Cluster *&pBestParentCluster, float &highestExcessEvidence,
+    float &highestEvidenceParentEnergy)
 {
-    float highestExcessEvidence(0.f);
-    float highestEvidenceParentEnergy(0.);
+    float globalDeltaChi2(0.f);
 
-    ClusterList clusterList;
-    for (const auto &mapEntry : chargedClusterContactMap) clusterList.push_back(mapEntry.first);
-    clusterList.sort(SortingHelper::SortClustersByNHits);
+    // Check to see if merging parent and daughter clusters would improve track-cluster compatibility
+    if (!this->PassesPreselection(pDaughterCluster, chargedClusterContactVector, globalDeltaChi2))
+        return STATUS_CODE_SUCCESS;
+
+    const unsigned int daughterCorrectionLayer(this->GetClusterCorrectionLayer(pDaughterCluster));
 
-    for (const Cluster *const pDaughterCluster : clusterList)
+    for (const ChargedClusterContact &chargedClusterContact : chargedClusterContactVector)
     {
-        const ChargedClusterContactVector &contactVector(chargedClusterContactMap.at(pDaughterCluster));
-        float globalDeltaChi2(0.f);
+        if (pDaughterCluster != chargedClusterContact.GetDaughterCluster())
+            return STATUS_CODE_FAILURE;
 
-        // Check to see if merging parent and daughter clusters would improve track-cluster compatibility
-        if (!this->PassesPreselection(pDaughterCluster, contactVector, globalDeltaChi2))
-            continue;
+        const float totalEvidence(this->GetTotalEvidenceForMerge(chargedClusterContact));
+        const float requiredEvidence(this->GetRequiredEvidenceForMerge(pDaughterCluster, chargedClusterContact, daughterCorrectionLayer,
+            globalDeltaChi2));
+        const float excessEvidence(totalEvidence - requiredEvidence);
 
-        const unsigned int daughterCorrectionLayer(this->GetClusterCorrectionLayer(pDaughterCluster));
+        const float parentEnergy(chargedClusterContact.GetParentCluster()->GetHadronicEnergy());
 
-        for (const ChargedClusterContact &chargedClusterContact : contactVector)
+        if ((excessEvidence > highestExcessEvidence) || ((excessEvidence == highestExcessEvidence) && (parentEnergy > highestEvidenceParentEnergy)))
         {
-            if (pDaughterCluster != chargedClusterContact.GetDaughterCluster())
-                throw StatusCodeException(STATUS_CODE_FAILURE);
-
-            const float totalEvidence(this->GetTotalEvidenceForMerge(chargedClusterContact));
-            const float requiredEvidence(this->GetRequiredEvidenceForMerge(pDaughterCluster, chargedClusterContact, daughterCorrectionLayer,
-                globalDeltaChi2));
-            const float excessEvidence(totalEvidence - requiredEvidence);
-
-            const float parentEnergy(chargedClusterContact.GetParentCluster()->GetHadronicEnergy());
-
-            if ((excessEvidence > highestExcessEvidence) || ((excessEvidence == highestExcessEvidence) && (parentEnergy > highestEvidenceParentEnergy)))
-            {
-                highestExcessEvidence = excessEvidence;
-                pBestDaughterCluster = pDaughterCluster;
-                pBestParentCluster = chargedClusterContact.GetParentCluster();
-                highestEvidenceParentEnergy = parentEnergy;
-            }
+            highestExcessEvidence = excessEvidence;
+            pBestParentCluster = chargedClusterContact.GetParentCluster();
+            highestEvidenceParentEnergy = parentEnergy;
         }
     }
 
@@ -581,21 +768,53 @@ StatusCode MainFragmentRemovalAlgorithm::GetAffectedClusters(const ChargedCluste
 //------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+bool MainFragmentRemovalAlgorithm::MergeCandidate::operator< (const MergeCandidate &rhs) const
+{
+    if (m_excessEvidence != rhs.m_excessEvidence)
+        return (m_excessEvidence > rhs.m_excessEvidence);
+
+    if (m_parentEnergy != rhs.m_parentEnergy)
+        return (m_parentEnergy > rhs.m_parentEnergy);
+
+    // ATTN Exact ties are resolved as by SortingHelper::SortClustersByNHits, but with exact energy comparisons, as std::set requires a
+    // strict weak ordering. The values were captured on creation, so a queued key cannot change
+    if (m_daughterNCaloHits != rhs.m_daughterNCaloHits)
+        return (m_daughterNCaloHits > rhs.m_daughterNCaloHits);
+
+    if (m_daughterEnergy != rhs.m_daughterEnergy)
+        return (m_daughterEnergy > rhs.m_daughterEnergy);
+
+    if (m_daughterIsolatedEnergy != rhs.m_daughterIsolatedEnergy)
+        return (m_daughterIsolatedEnergy > rhs.m_daughterIsolatedEnergy);
+
+    if (m_pDaughterCluster == rhs.m_pDaughterCluster)
+        return false;
+
+    // Distinct daughter clusters share no calo hits
+    if (!m_pDaughterFirstCaloHit || !rhs.m_pDaughterFirstCaloHit)
+        throw StatusCodeException(STATUS_CODE_NOT_FOUND);
+
+    return (*m_pDaughterFirstCaloHit < *rhs.m_pDaughterFirstCaloHit);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 ChargedClusterContact::ChargedClusterContact(const Pandora &pandora, const Cluster *const pDaughterCluster, const Cluster *const pParentCluster,
-        const Parameters &parameters) :
+        const Parameters &parameters, const TrackToHelixTrajectoryMap &trackToHelixTrajectoryMap) :
     ClusterContact(pandora, pDaughterCluster, pParentCluster, parameters),
     m_coneFraction2(FragmentRemovalHelper::GetFractionOfHitsInCone(pandora, pDaughterCluster, pParentCluster, parameters.m_coneCosineHalfAngle2)),
     m_coneFraction3(FragmentRemovalHelper::GetFractionOfHitsInCone(pandora, pDaughterCluster, pParentCluster, parameters.m_coneCosineHalfAngle3)),
     m_meanDistanceToHelix(std::numeric_limits<float>::max()),
     m_closestDistanceToHelix(std::numeric_limits<float>::max())
 {
-    this->ClusterHelixComparison(pandora, pDaughterCluster, pParentCluster, parameters);
+    this->ClusterHelixComparison(pDaughterCluster, pParentCluster, parameters, trackToHelixTrajectoryMap);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void ChargedClusterContact::ClusterHelixComparison(const Pandora &pandora, const Cluster *const pDaughterCluster, const Cluster *const pParentCluster,
-    const Parameters &parameters)
+void ChargedClusterContact::ClusterHelixComparison(const Cluster *const pDaughterCluster, const Cluster *const pParentCluster,
+    const Parameters &parameters, const TrackToHelixTrajectoryMap &trackToHelixTrajectoryMap)
 {
     // Configure range of layers in which daughter cluster will be compared to helix fits
     const bool passMipFractionCut(pParentCluster->GetMipFraction() - parameters.m_helixComparisonMipFractionCut > std::numeric_limits<float>::epsilon());
@@ -611,7 +830,6 @@ void ChargedClusterContact::ClusterHelixComparison(const Pandora &pandora, const
     // Calculate closest distance between daughter cluster and helix fits to parent associated tracks
     float trackEnergySum(0.);
     const TrackList &parentTrackList(pParentCluster->GetAssociatedTrackList());
-    const float bField(pandora.GetPlugins()->GetBFieldPlugin()->GetBField(CartesianVector(0.f, 0.f, 0.f)));
 
     for (TrackList::const_iterator iter = parentTrackList.begin(), iterEnd = parentTrackList.end(); iter != iterEnd; ++iter)
     {
@@ -619,8 +837,13 @@ void ChargedClusterContact::ClusterHelixComparison(const Pandora &pandora, const
 
         // Extract track information
         trackEnergySum += pTrack->GetEnergyAtDca();
-        const Helix helix(pTrack->GetTrackStateAtCalorimeter().GetPosition(), pTrack->GetTrackStateAtCalorimeter().GetMomentum(), pTrack->GetCharge(), bField);
         const float trackCalorimeterZPosition((*iter)->GetTrackStateAtCalorimeter().GetPosition().GetZ());
+        TrackToHelixTrajectoryMap::const_iterator trajectoryIter(trackToHelixTrajectoryMap.find(pTrack));
+
+        if (trackToHelixTrajectoryMap.end() == trajectoryIter)
+            throw StatusCodeException(STATUS_CODE_NOT_FOUND);
+
+        const HelixTrajectory &helixTrajectory(*(trajectoryIter->second));
 
         // Check proximity of track projection and cluster
         if ((std::fabs(trackCalorimeterZPosition) > (std::fabs(clusterZPosition) + parameters.m_maxTrackClusterDeltaZ)) ||
@@ -630,7 +853,7 @@ void ChargedClusterContact::ClusterHelixComparison(const Pandora &pandora, const
         }
 
         // Check number of layers crossed by helix
-        const unsigned int nLayersCrossed(FragmentRemovalHelper::GetNLayersCrossed(pandora, helix, trackCalorimeterZPosition, clusterZPosition));
+        const unsigned int nLayersCrossed(helixTrajectory.GetNLayersCrossed(trackCalorimeterZPosition, clusterZPosition));
 
         if (nLayersCrossed > parameters.m_maxLayersCrossedByHelix)
             continue;
@@ -638,7 +861,7 @@ void ChargedClusterContact::ClusterHelixComparison(const Pandora &pandora, const
         // Calculate distance to helix
         float meanDistanceToHelix(std::numeric_limits<float>::max()), closestDistanceToHelix(std::numeric_limits<float>::max());
 
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, FragmentRemovalHelper::GetClusterHelixDistance(pDaughterCluster, helix,
+        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, FragmentRemovalHelper::GetClusterHelixDistance(pDaughterCluster, helixTrajectory,
             startLayer, endLayer, maxOccupiedLayers, closestDistanceToHelix, meanDistanceToHelix));
 
         if (closestDistanceToHelix < m_closestDistanceToHelix)
@@ -960,6 +1183,18 @@ StatusCode MainFragmentRemovalAlgorithm::ReadSettings(const TiXmlHandle xmlHandl
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
         "MinRequiredEvidence", m_minRequiredEvidence));
 
+    // Multi-threading parameters
+    PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
+        "NThreads", m_nThreads));
+
+    if (0 == m_nThreads)
+        return STATUS_CODE_INVALID_PARAMETER;
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
+        "MinPairsPerThread", m_minPairsPerThread));
+
+    m_pParallelFor = new ParallelFor(m_nThreads);
+
     return STATUS_CODE_SUCCESS;
 }
 
@@ -102,6 +102,9 @@ StatusCode NeutralFragmentRemovalAlgorithm::GetNeutralClusterContactMap(bool &is
     const ClusterList *pClusterList = NULL;
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetCurrentList(*this, pClusterList));
 
+    // Bounding boxes are cached for the duration of this call only, as merges change the parent clusters
+    ClusterBoundingBoxMap clusterBoundingBoxMap;
+
     for (ClusterList::const_iterator iterI = pClusterList->begin(), iterIEnd = pClusterList->end(); iterI != iterIEnd; ++iterI)
     {
         const Cluster *const pDaughterCluster = *iterI;
@@ -136,6 +139,10 @@ StatusCode NeutralFragmentRemovalAlgorithm::GetNeutralClusterContactMap(bool &is
             if (!pParentCluster->GetAssociatedTrackList().empty() || pParentCluster->PassPhotonId(this->GetPandora()))
                 continue;
 
+            // Quickly reject parent candidates that cannot pass the closest hit distance cut
+            if (!FragmentRemovalHelper::CanBeWithinDistance(pDaughterCluster, pParentCluster, m_contactCutMaxDistance, clusterBoundingBoxMap))
+                continue;
+
             const NeutralClusterContact neutralClusterContact(this->GetPandora(), pDaughterCluster, pParentCluster, m_contactParameters);
 
             if (this->PassesClusterContactCuts(neutralClusterContact))
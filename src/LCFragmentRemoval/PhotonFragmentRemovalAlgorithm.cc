@@ -100,6 +100,9 @@ StatusCode PhotonFragmentRemovalAlgorithm::GetClusterContactMap(bool &isFirstPas
     const ClusterList *pClusterList = NULL;
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetCurrentList(*this, pClusterList));
 
+    // Bounding boxes are cached for the duration of this call only, as merges change the parent clusters
+    ClusterBoundingBoxMap clusterBoundingBoxMap;
+
     for (ClusterList::const_iterator iterI = pClusterList->begin(), iterIEnd = pClusterList->end(); iterI != iterIEnd; ++iterI)
     {
         const Cluster *const pDaughterCluster = *iterI;
@@ -149,6 +152,10 @@ StatusCode PhotonFragmentRemovalAlgorithm::GetClusterContactMap(bool &isFirstPas
             if (!pParentCluster->PassPhotonId(this->GetPandora()))
                 continue;
 
+            // Quickly reject parent candidates that cannot pass the closest hit distance cut
+            if (!FragmentRemovalHelper::CanBeWithinDistance(pDaughterCluster, pParentCluster, m_contactCutMaxDistance, clusterBoundingBoxMap))
+                continue;
+
             // Evaluate cluster contact properties
             const ClusterContact clusterContact(this->GetPandora(), pDaughterCluster, pParentCluster, m_contactParameters);
 
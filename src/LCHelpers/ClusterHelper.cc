@@ -10,6 +10,11 @@
 
 #include "LCHelpers/ClusterHelper.h"
 
+#include "LCUtility/ClusterHitPositions.h"
+
+#include <algorithm>
+#include <memory>
+
 using namespace pandora;
 
 namespace lc_content
@@ -77,36 +82,25 @@ float ClusterHelper::GetDistanceToClosestHit(const ClusterFitResult &clusterFitR
 
 float ClusterHelper::GetDistanceToClosestHit(const Cluster *const pClusterI, const Cluster *const pClusterJ)
 {
-    bool distanceFound(false);
-    float minDistanceSquared(std::numeric_limits<float>::max());
-    const OrderedCaloHitList &orderedCaloHitListI(pClusterI->GetOrderedCaloHitList());
-    const OrderedCaloHitList &orderedCaloHitListJ(pClusterJ->GetOrderedCaloHitList());
+    return ClusterHelper::GetDistanceToClosestHit(pClusterI, pClusterJ, std::numeric_limits<float>::max());
+}
 
-    // Loop over hits in cluster I
-    for (OrderedCaloHitList::const_iterator iterI = orderedCaloHitListI.begin(), iterIEnd = orderedCaloHitListI.end(); iterI != iterIEnd; ++iterI)
-    {
-        for (CaloHitList::const_iterator hitIterI = iterI->second->begin(), hitIterIEnd = iterI->second->end(); hitIterI != hitIterIEnd; ++hitIterI)
-        {
-            const CartesianVector &positionVectorI((*hitIterI)->GetPositionVector());
+//------------------------------------------------------------------------------------------------------------------------------------------
 
-            // For each hit in cluster I, find closest distance to a hit in cluster J
-            for (OrderedCaloHitList::const_iterator iterJ = orderedCaloHitListJ.begin(), iterJEnd = orderedCaloHitListJ.end(); iterJ != iterJEnd; ++iterJ)
-            {
-                for (CaloHitList::const_iterator hitIterJ = iterJ->second->begin(), hitIterJEnd = iterJ->second->end(); hitIterJ != hitIterJEnd; ++hitIterJ)
-                {
-                    const float distanceSquared(positionVectorI.GetDistanceSquared((*hitIterJ)->GetPositionVector()));
-
-                    if (distanceSquared < minDistanceSquared)
-                    {
-                        minDistanceSquared = distanceSquared;
-                        distanceFound = true;
-                    }
-                }
-            }
-        }
-    }
+float ClusterHelper::GetDistanceToClosestHit(const Cluster *const pClusterI, const Cluster *const pClusterJ, const float maxDistance)
+{
+    PositionVector positionsI, positionsJ;
+    ClusterHelper::GetHitPositions(pClusterI, positionsI);
+    ClusterHelper::GetHitPositions(pClusterJ, positionsJ);
 
-    if (!distanceFound)
+    const float maxDistanceSquared(ClusterHelper::GetPaddedDistanceSquaredCut(maxDistance));
+
+    // Sweep through the larger set of hits
+    const float minDistanceSquared((positionsI.size() < positionsJ.size()) ?
+        ClusterHelper::GetClosestDistanceSquared(positionsI, positionsJ, maxDistanceSquared) :
+        ClusterHelper::GetClosestDistanceSquared(positionsJ, positionsI, maxDistanceSquared));
+
+    if (!(minDistanceSquared < maxDistanceSquared))
         return std::numeric_limits<float>::max();
 
     return std::sqrt(minDistanceSquared);
@@ -155,33 +149,24 @@ StatusCode ClusterHelper::GetDistanceToClosestCentroid(const Cluster *const pClu
     if ((pClusterI->GetOuterPseudoLayer() < pClusterJ->GetInnerPseudoLayer()) || (pClusterJ->GetOuterPseudoLayer() < pClusterI->GetInnerPseudoLayer()))
         return STATUS_CODE_NOT_FOUND;
 
-    bool distanceFound(false);
-    float minDistanceSquared(std::numeric_limits<float>::max());
     const OrderedCaloHitList &orderedCaloHitListI(pClusterI->GetOrderedCaloHitList());
     const OrderedCaloHitList &orderedCaloHitListJ(pClusterJ->GetOrderedCaloHitList());
 
-    for (OrderedCaloHitList::const_iterator iterI = orderedCaloHitListI.begin(), iterIEnd = orderedCaloHitListI.end(); iterI != iterIEnd; ++iterI)
-    {
-        const CartesianVector centroidI(pClusterI->GetCentroid(iterI->first));
-
-        for (OrderedCaloHitList::const_iterator iterJ = orderedCaloHitListJ.begin(), iterJEnd = orderedCaloHitListJ.end(); iterJ != iterJEnd; ++iterJ)
-        {
-            if (orderedCaloHitListI.end() == orderedCaloHitListI.find(iterJ->first))
-                continue;
-
-            const CartesianVector centroidJ(pClusterJ->GetCentroid(iterJ->first));
+    // Every centroid in cluster I is compared with the centroids of cluster J in layers also occupied by cluster I
+    PositionVector centroidsI, centroidsJ;
 
-            const float distanceSquared(centroidI.GetDistanceSquared(centroidJ));
+    for (OrderedCaloHitList::const_iterator iterI = orderedCaloHitListI.begin(), iterIEnd = orderedCaloHitListI.end(); iterI != iterIEnd; ++iterI)
+        centroidsI.push_back(pClusterI->GetCentroid(iterI->first));
 
-            if (distanceSquared < minDistanceSquared)
-            {
-                minDistanceSquared = distanceSquared;
-                distanceFound = true;
-            }
-        }
+    for (OrderedCaloHitList::const_iterator iterJ = orderedCaloHitListJ.begin(), iterJEnd = orderedCaloHitListJ.end(); iterJ != iterJEnd; ++iterJ)
+    {
+        if (orderedCaloHitListI.end() != orderedCaloHitListI.find(iterJ->first))
+            centroidsJ.push_back(pClusterJ->GetCentroid(iterJ->first));
     }
 
-    if (!distanceFound)
+    const float minDistanceSquared(ClusterHelper::GetClosestDistanceSquared(centroidsI, centroidsJ, std::numeric_limits<float>::max()));
+
+    if (!(minDistanceSquared < std::numeric_limits<float>::max()))
         return STATUS_CODE_NOT_FOUND;
 
     centroidDistance = std::sqrt(minDistanceSquared);
@@ -201,14 +186,25 @@ StatusCode ClusterHelper::GetClosestIntraLayerDistance(const Cluster *const pClu
     const OrderedCaloHitList &orderedCaloHitListI(pClusterI->GetOrderedCaloHitList());
     const OrderedCaloHitList &orderedCaloHitListJ(pClusterJ->GetOrderedCaloHitList());
 
-    for (OrderedCaloHitList::const_iterator iterI = orderedCaloHitListI.begin(), iterIEnd = orderedCaloHitListI.end(); iterI != iterIEnd; ++iterI)
+    // Step through the (ordered) layers of both clusters together, rather than searching one for each layer of the other
+    OrderedCaloHitList::const_iterator iterI = orderedCaloHitListI.begin();
+    OrderedCaloHitList::const_iterator iterJ = orderedCaloHitListJ.begin();
+
+    while ((orderedCaloHitListI.end() != iterI) && (orderedCaloHitListJ.end() != iterJ))
     {
-        const unsigned int pseudoLayer(iterI->first);
-        OrderedCaloHitList::const_iterator iterJ = orderedCaloHitListJ.find(pseudoLayer);
+        if (iterI->first < iterJ->first)
+        {
+            ++iterI;
+            continue;
+        }
 
-        if (orderedCaloHitListJ.end() == iterJ)
+        if (iterJ->first < iterI->first)
+        {
+            ++iterJ;
             continue;
+        }
 
+        const unsigned int pseudoLayer(iterI->first);
         const CartesianVector centroidI(pClusterI->GetCentroid(pseudoLayer));
         const CartesianVector centroidJ(pClusterJ->GetCentroid(pseudoLayer));
 
@@ -219,6 +215,9 @@ StatusCode ClusterHelper::GetClosestIntraLayerDistance(const Cluster *const pClu
             minDistanceSquared = distanceSquared;
             distanceFound = true;
         }
+
+        ++iterI;
+        ++iterJ;
     }
 
     if (!distanceFound)
@@ -289,10 +288,16 @@ StatusCode ClusterHelper::GetTrackClusterDistance(const TrackStateVector *const
 {
     bool successful(false);
 
+    // Copy the hit positions once, to be shared by all the track states
+    const std::unique_ptr<const ClusterHitPositions> pClusterHitPositions((pTrackStates->size() > 1) ?
+        new ClusterHitPositions(pCluster, maxSearchLayer) : nullptr);
+
     for (auto const& trackState: *pTrackStates)
     {
         float trackClusterDistanceTemp(std::numeric_limits<float>::max());
-        const StatusCode statusCode(GetTrackClusterDistance(&trackState, pCluster, maxSearchLayer, parallelDistanceCut, minTrackClusterCosAngle, trackClusterDistanceTemp));
+        const StatusCode statusCode(pClusterHitPositions ?
+            GetTrackClusterDistance(&trackState, *pClusterHitPositions, maxSearchLayer, parallelDistanceCut, minTrackClusterCosAngle, trackClusterDistanceTemp) :
+            GetTrackClusterDistance(&trackState, pCluster, maxSearchLayer, parallelDistanceCut, minTrackClusterCosAngle, trackClusterDistanceTemp));
 
         if (STATUS_CODE_SUCCESS == statusCode)
         {
@@ -307,6 +312,33 @@ StatusCode ClusterHelper::GetTrackClusterDistance(const TrackStateVector *const
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+StatusCode ClusterHelper::GetTrackClusterDistance(const TrackState *const pTrackState, const ClusterHitPositions &clusterHitPositions,
+    const unsigned int maxSearchLayer, const float parallelDistanceCut, const float minTrackClusterCosAngle, float &trackClusterDistance)
+{
+    const Cluster *const pCluster(clusterHitPositions.GetCluster());
+
+    if ((0 == pCluster->GetNCaloHits()) || (pCluster->GetInnerPseudoLayer() > maxSearchLayer))
+        return STATUS_CODE_NOT_FOUND;
+
+    const CartesianVector trackDirection(pTrackState->GetMomentum().GetUnitVector());
+
+    if (trackDirection.GetCosOpeningAngle(pCluster->GetInitialDirection()) < minTrackClusterCosAngle)
+        return STATUS_CODE_NOT_FOUND;
+
+    float minDistanceSquared(std::numeric_limits<float>::max());
+
+    if (!clusterHitPositions.GetMinPerpendicularDistanceSquared(pTrackState->GetPosition(), trackDirection, maxSearchLayer, parallelDistanceCut,
+        minDistanceSquared))
+    {
+        return STATUS_CODE_NOT_FOUND;
+    }
+
+    trackClusterDistance = std::sqrt(minDistanceSquared);
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 bool ClusterHelper::CanMergeCluster(const Pandora &pandora, const Cluster *const pCluster, const float minMipFraction, const float maxAllHitsFitRms)
 {
     if (0 == pCluster->GetNCaloHits())
@@ -471,4 +503,153 @@ bool ClusterHelper::ContainsHitInOuterSamplingLayer(const Cluster *const pCluste
     return (0 != pCluster->GetNHitsInOuterLayer());
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+float ClusterHelper::GetPaddedDistanceSquaredCut(const float distance)
+{
+    // ATTN Pad the squared distance cut, so that no pair of positions within the distance cut is lost to rounding
+    if (!(distance < std::sqrt(std::numeric_limits<float>::max())))
+        return std::numeric_limits<float>::max();
+
+    return distance * distance * (1.f + 4.f * std::numeric_limits<float>::epsilon());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+float ClusterHelper::GetBoxDistanceSquared(const float lowI[3], const float highI[3], const float lowJ[3], const float highJ[3])
+{
+    float boxDistanceSquared(0.f);
+
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        const float gap(std::max(0.f, std::max(lowJ[i] - highI[i], lowI[i] - highJ[i])));
+        boxDistanceSquared += gap * gap;
+    }
+
+    return boxDistanceSquared;
+}
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ClusterHelper::GetHitPositions(const Cluster *const pCluster, PositionVector &positionVector)
+{
+    const OrderedCaloHitList &orderedCaloHitList(pCluster->GetOrderedCaloHitList());
+    positionVector.reserve(pCluster->GetNCaloHits());
+
+    for (OrderedCaloHitList::const_iterator iter = orderedCaloHitList.begin(), iterEnd = orderedCaloHitList.end(); iter != iterEnd; ++iter)
+    {
+        for (CaloHitList::const_iterator hitIter = iter->second->begin(), hitIterEnd = iter->second->end(); hitIter != hitIterEnd; ++hitIter)
+            positionVector.push_back((*hitIter)->GetPositionVector());
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+float ClusterHelper::GetClosestDistanceSquared(const PositionVector &positionsI, const PositionVector &positionsJ, const float maxDistanceSquared)
+{
+    if (positionsI.empty() || positionsJ.empty())
+        return maxDistanceSquared;
+
+    // Bounding boxes, in x, y, z
+    const float maxValue(std::numeric_limits<float>::max());
+    float lowI[3] = {maxValue, maxValue, maxValue}, highI[3] = {-maxValue, -maxValue, -maxValue};
+    float lowJ[3] = {maxValue, maxValue, maxValue}, highJ[3] = {-maxValue, -maxValue, -maxValue};
+
+    for (const CartesianVector &positionI : positionsI)
+    {
+        const float coordinates[3] = {positionI.GetX(), positionI.GetY(), positionI.GetZ()};
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            lowI[i] = std::min(lowI[i], coordinates[i]);
+            highI[i] = std::max(highI[i], coordinates[i]);
+        }
+    }
+
+    for (const CartesianVector &positionJ : positionsJ)
+    {
+        const float coordinates[3] = {positionJ.GetX(), positionJ.GetY(), positionJ.GetZ()};
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            lowJ[i] = std::min(lowJ[i], coordinates[i]);
+            highJ[i] = std::max(highJ[i], coordinates[i]);
+        }
+    }
+
+    // ATTN All separations below are calculated as for an exhaustive search, so they are never larger than the distance between any
+    // pair of positions that they bound, even after rounding
+    const float boxDistanceSquared(ClusterHelper::GetBoxDistanceSquared(lowI, highI, lowJ, highJ));
+
+    if (!(boxDistanceSquared < maxDistanceSquared))
+        return maxDistanceSquared;
+
+    // Sort the second set along the longest axis of its bounding box, then sweep outwards from the projection of each position in the first
+    unsigned int axis(0);
+
+    for (unsigned int i = 1; i < 3; ++i)
+    {
+        if ((highJ[i] - lowJ[i]) > (highJ[axis] - lowJ[axis]))
+            axis = i;
+    }
+
+    CoordinateIndexVector coordinatesJ;
+    coordinatesJ.reserve(positionsJ.size());
+
+    for (unsigned int j = 0, nJ = positionsJ.size(); j < nJ; ++j)
+    {
+        const CartesianVector &positionJ(positionsJ[j]);
+        coordinatesJ.push_back(CoordinateIndex((0 == axis) ? positionJ.GetX() : (1 == axis) ? positionJ.GetY() : positionJ.GetZ(), j));
+    }
+
+    std::sort(coordinatesJ.begin(), coordinatesJ.end());
+
+    float minDistanceSquared(maxDistanceSquared);
+
+    for (const CartesianVector &positionI : positionsI)
+    {
+        const float coordinates[3] = {positionI.GetX(), positionI.GetY(), positionI.GetZ()};
+        float pointDistanceSquared(0.f);
+
+        for (unsigned int i = 0; i < 3; ++i)
+        {
+            const float gap((coordinates[i] < lowJ[i]) ? lowJ[i] - coordinates[i] : (coordinates[i] > highJ[i]) ? coordinates[i] - highJ[i] : 0.f);
+            pointDistanceSquared += gap * gap;
+        }
+
+        if (!(pointDistanceSquared < minDistanceSquared))
+            continue;
+
+        const float coordinateI(coordinates[axis]);
+        const unsigned int start(std::lower_bound(coordinatesJ.begin(), coordinatesJ.end(), CoordinateIndex(coordinateI, 0)) - coordinatesJ.begin());
+
+        for (unsigned int j = start, nJ = coordinatesJ.size(); j < nJ; ++j)
+        {
+            const float separation(coordinatesJ[j].first - coordinateI);
+
+            if (!(separation * separation < minDistanceSquared))
+                break;
+
+            const float distanceSquared(positionI.GetDistanceSquared(positionsJ[coordinatesJ[j].second]));
+
+            if (distanceSquared < minDistanceSquared)
+                minDistanceSquared = distanceSquared;
+        }
+
+        for (unsigned int j = start; j > 0; --j)
+        {
+            const float separation(coordinateI - coordinatesJ[j - 1].first);
+
+            if (!(separation * separation < minDistanceSquared))
+                break;
+
+            const float distanceSquared(positionI.GetDistanceSquared(positionsJ[coordinatesJ[j - 1].second]));
+
+            if (distanceSquared < minDistanceSquared)
+                minDistanceSquared = distanceSquared;
+        }
+    }
+
+    return minDistanceSquared;
+}
+
 } // namespace lc_content
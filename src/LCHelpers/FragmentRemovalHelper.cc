@@ -8,8 +8,15 @@
 
 #include "Pandora/AlgorithmHeaders.h"
 
+#include "LCHelpers/ClusterHelper.h"
 #include "LCHelpers/FragmentRemovalHelper.h"
 
+#include "LCPlugins/LCPseudoLayerPlugin.h"
+
+#include "LCUtility/HelixTrajectory.h"
+
+#include <algorithm>
+
 using namespace pandora;
 
 namespace lc_content
@@ -161,43 +168,43 @@ unsigned int FragmentRemovalHelper::GetNLayersCrossed(const Pandora &pandora, co
     if (std::fabs(deltaZ) < 0.001f)
         return 0;
 
+    // Positions sampled along the helix often lie outside the detector, so their pseudo layers are found without raising exceptions
     CartesianVector intersectionPoint(0.f, 0.f, 0.f);
     const CartesianVector &referencePoint(helix.GetReferencePoint());
     PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, != , helix.GetPointInZ(zStart, referencePoint, intersectionPoint));
 
-    const PseudoLayerPlugin *const pPseudoLayerPlugin(pandora.GetPlugins()->GetPseudoLayerPlugin());
     const unsigned int MAX_LAYER(std::numeric_limits<unsigned int>::max());
-    unsigned int startLayer(MAX_LAYER);
+    CartesianPointVector samplingPoints(1, intersectionPoint);
+    UIntVector pseudoLayers;
 
-    try
-    {
-        startLayer = pPseudoLayerPlugin->GetPseudoLayer(intersectionPoint);
-    }
-    catch (StatusCodeException &)
-    {
+    FragmentRemovalHelper::GetPseudoLayers(pandora, samplingPoints, pseudoLayers);
+    const unsigned int startLayer(pseudoLayers.front());
+
+    if (MAX_LAYER == startLayer)
         return MAX_LAYER;
-    }
 
-    unsigned int currentLayer(startLayer), layerCount(0);
+    samplingPoints.clear();
+    samplingPoints.reserve(nSamplingPoints + 1);
 
     for (float z = zStart; std::fabs(z) < std::fabs(zEnd + 0.5 * deltaZ); z += deltaZ)
     {
         PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, != , helix.GetPointInZ(z, referencePoint, intersectionPoint));
+        samplingPoints.push_back(intersectionPoint);
+    }
 
-        try
-        {
-            const unsigned int iLayer(pPseudoLayerPlugin->GetPseudoLayer(intersectionPoint));
+    FragmentRemovalHelper::GetPseudoLayers(pandora, samplingPoints, pseudoLayers);
 
-            if (iLayer != currentLayer)
-            {
-                layerCount += ((iLayer > currentLayer) ? iLayer - currentLayer : currentLayer - iLayer);
-                currentLayer = iLayer;
-            }
-        }
-        catch (StatusCodeException &)
-        {
+    unsigned int currentLayer(startLayer), layerCount(0);
+
+    for (UIntVector::const_iterator iter = pseudoLayers.begin(), iterEnd = pseudoLayers.end(); iter != iterEnd; ++iter)
+    {
+        const unsigned int iLayer(*iter);
+
+        if ((MAX_LAYER == iLayer) || (iLayer == currentLayer))
             continue;
-        }
+
+        layerCount += ((iLayer > currentLayer) ? iLayer - currentLayer : currentLayer - iLayer);
+        currentLayer = iLayer;
     }
 
     return layerCount;
@@ -252,6 +259,54 @@ StatusCode FragmentRemovalHelper::GetClusterHelixDistance(const Cluster *const p
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+StatusCode FragmentRemovalHelper::GetClusterHelixDistance(const Cluster *const pCluster, const HelixTrajectory &helixTrajectory,
+    const unsigned int startLayer, const unsigned int endLayer, const unsigned int maxOccupiedLayers, float &closestDistanceToHit,
+    float &meanDistanceToHits)
+{
+    if (startLayer > endLayer)
+        return STATUS_CODE_INVALID_PARAMETER;
+
+    unsigned int nHits(0), nOccupiedLayers(0);
+    float sumDistanceToHits(0.), minDistanceToHit(std::numeric_limits<float>::max());
+    const OrderedCaloHitList &orderedCaloHitList(pCluster->GetOrderedCaloHitList());
+    FloatVector distances;
+
+    for (unsigned int iLayer = startLayer; iLayer <= endLayer; ++iLayer)
+    {
+        OrderedCaloHitList::const_iterator iter = orderedCaloHitList.find(iLayer);
+
+        if (orderedCaloHitList.end() == iter)
+            continue;
+
+        if (++nOccupiedLayers > maxOccupiedLayers)
+            break;
+
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, helixTrajectory.GetDistancesToHits(*(iter->second), distances));
+
+        for (FloatVector::const_iterator distanceIter = distances.begin(), distanceIterEnd = distances.end(); distanceIter != distanceIterEnd; ++distanceIter)
+        {
+            const float distance(*distanceIter);
+
+            if (distance < minDistanceToHit)
+                minDistanceToHit = distance;
+
+            sumDistanceToHits += distance;
+            nHits++;
+        }
+    }
+
+    if (0 != nHits)
+    {
+        meanDistanceToHits = sumDistanceToHits / static_cast<float>(nHits);
+        closestDistanceToHit = minDistanceToHit;
+        return STATUS_CODE_SUCCESS;
+    }
+
+    return STATUS_CODE_NOT_FOUND;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode FragmentRemovalHelper::GetClusterContactDetails(const Cluster *const pClusterI, const Cluster *const pClusterJ,
     const float distanceThreshold, unsigned int &nContactLayers, float &contactFraction)
 {
@@ -390,6 +445,52 @@ CartesianVector FragmentRemovalHelper::GetEMEnergyWeightedPosition(const Cluster
     return (weightedPosition * (1.f / energySum));
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool FragmentRemovalHelper::CanBeWithinDistance(const Cluster *const pClusterI, const Cluster *const pClusterJ, const float distance,
+    ClusterBoundingBoxMap &clusterBoundingBoxMap)
+{
+    ClusterBoundingBoxMap::const_iterator iterI = clusterBoundingBoxMap.find(pClusterI);
+
+    if (clusterBoundingBoxMap.end() == iterI)
+        iterI = clusterBoundingBoxMap.insert(ClusterBoundingBoxMap::value_type(pClusterI, ClusterBoundingBox(pClusterI))).first;
+
+    ClusterBoundingBoxMap::const_iterator iterJ = clusterBoundingBoxMap.find(pClusterJ);
+
+    if (clusterBoundingBoxMap.end() == iterJ)
+        iterJ = clusterBoundingBoxMap.insert(ClusterBoundingBoxMap::value_type(pClusterJ, ClusterBoundingBox(pClusterJ))).first;
+
+    return iterI->second.IsWithinDistance(iterJ->second, distance);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void FragmentRemovalHelper::GetPseudoLayers(const Pandora &pandora, const CartesianPointVector &positionVector, UIntVector &pseudoLayers)
+{
+    const PseudoLayerPlugin *const pPseudoLayerPlugin(pandora.GetPlugins()->GetPseudoLayerPlugin());
+    const LCPseudoLayerPlugin *const pLCPseudoLayerPlugin(dynamic_cast<const LCPseudoLayerPlugin*>(pPseudoLayerPlugin));
+
+    if (pLCPseudoLayerPlugin)
+    {
+        pLCPseudoLayerPlugin->GetPseudoLayers(positionVector, pseudoLayers);
+        return;
+    }
+
+    pseudoLayers.clear();
+
+    for (CartesianPointVector::const_iterator iter = positionVector.begin(), iterEnd = positionVector.end(); iter != iterEnd; ++iter)
+    {
+        try
+        {
+            pseudoLayers.push_back(pPseudoLayerPlugin->GetPseudoLayer(*iter));
+        }
+        catch (StatusCodeException &)
+        {
+            pseudoLayers.push_back(std::numeric_limits<unsigned int>::max());
+        }
+    }
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -473,4 +574,48 @@ void ClusterContact::HitDistanceComparison(const Cluster *const pDaughterCluster
     m_closeHitFraction2 = static_cast<float>(nCloseHits2) / static_cast<float>(nDaughterCaloHits);
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+ClusterBoundingBox::ClusterBoundingBox(const Cluster *const pCluster) :
+    m_isEmpty(true),
+    m_minX(std::numeric_limits<float>::max()),
+    m_minY(std::numeric_limits<float>::max()),
+    m_minZ(std::numeric_limits<float>::max()),
+    m_maxX(-std::numeric_limits<float>::max()),
+    m_maxY(-std::numeric_limits<float>::max()),
+    m_maxZ(-std::numeric_limits<float>::max())
+{
+    const OrderedCaloHitList &orderedCaloHitList(pCluster->GetOrderedCaloHitList());
+
+    for (OrderedCaloHitList::const_iterator iter = orderedCaloHitList.begin(), iterEnd = orderedCaloHitList.end(); iter != iterEnd; ++iter)
+    {
+        for (CaloHitList::const_iterator hitIter = iter->second->begin(), hitIterEnd = iter->second->end(); hitIter != hitIterEnd; ++hitIter)
+        {
+            const CartesianVector &positionVector((*hitIter)->GetPositionVector());
+
+            m_minX = std::min(m_minX, positionVector.GetX());
+            m_minY = std::min(m_minY, positionVector.GetY());
+            m_minZ = std::min(m_minZ, positionVector.GetZ());
+            m_maxX = std::max(m_maxX, positionVector.GetX());
+            m_maxY = std::max(m_maxY, positionVector.GetY());
+            m_maxZ = std::max(m_maxZ, positionVector.GetZ());
+            m_isEmpty = false;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool ClusterBoundingBox::IsWithinDistance(const ClusterBoundingBox &rhs, const float distance) const
+{
+    if (m_isEmpty || rhs.m_isEmpty)
+        return true;
+
+    const float low[3] = {m_minX, m_minY, m_minZ}, high[3] = {m_maxX, m_maxY, m_maxZ};
+    const float rhsLow[3] = {rhs.m_minX, rhs.m_minY, rhs.m_minZ}, rhsHigh[3] = {rhs.m_maxX, rhs.m_maxY, rhs.m_maxZ};
+
+    return (ClusterHelper::GetBoxDistanceSquared(low, high, rhsLow, rhsHigh) <= ClusterHelper::GetPaddedDistanceSquaredCut(distance));
+}
+
 } // namespace lc_content
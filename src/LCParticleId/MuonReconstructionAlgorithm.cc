@@ -52,8 +52,9 @@ StatusCode MuonReconstructionAlgorithm::Run()
 
     if (!pMuonClusterList->empty())
     {
-        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->AssociateMuonTracks(pMuonClusterList));
-        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->AddCaloHits(pMuonClusterList));
+        TrackHelixCache trackHelixCache(*this);
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->AssociateMuonTracks(pMuonClusterList, trackHelixCache));
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->AddCaloHits(pMuonClusterList, trackHelixCache));
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CreateMuonPfos(pMuonClusterList));
     }
 
@@ -64,16 +65,8 @@ StatusCode MuonReconstructionAlgorithm::Run()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-StatusCode MuonReconstructionAlgorithm::AssociateMuonTracks(const ClusterList *const pMuonClusterList) const
+StatusCode MuonReconstructionAlgorithm::AssociateMuonTracks(const ClusterList *const pMuonClusterList, TrackHelixCache &trackHelixCache) const
 {
-    const GeometryManager *const pGeometryManager(PandoraContentApi::GetGeometry(*this));
-    const BFieldPlugin *const pBFieldPlugin(PandoraContentApi::GetPlugins(*this)->GetBFieldPlugin());
-    const float innerBField(pBFieldPlugin->GetBField(CartesianVector(0.f, 0.f, 0.f)));
-
-    const float coilMidPointR(0.5f * (pGeometryManager->GetSubDetector(COIL).GetInnerRCoordinate() + pGeometryManager->GetSubDetector(COIL).GetOuterRCoordinate()));
-    const float muonBarrelBField(pBFieldPlugin->GetBField(CartesianVector(pGeometryManager->GetSubDetector(MUON_BARREL).GetInnerRCoordinate(), 0.f, 0.f)));
-    const float muonEndCapBField(pBFieldPlugin->GetBField(CartesianVector(0.f, 0.f, std::fabs(pGeometryManager->GetSubDetector(MUON_ENDCAP).GetInnerZCoordinate()))));
-
     const TrackList *pTrackList = NULL;
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetList(*this, m_inputTrackListName, pTrackList));
 
@@ -123,33 +116,14 @@ StatusCode MuonReconstructionAlgorithm::AssociateMuonTracks(const ClusterList *c
             if (pTrack->IsProjectedToEndCap() && (pTrack->GetTrackStateAtCalorimeter().GetPosition().GetZ() * clusterInnerCentroid.GetZ() < 0.f))
                 continue;
 
-            // Extract track helix fit
-            const Helix helix(pTrack->GetTrackStateAtCalorimeter().GetPosition(), pTrack->GetTrackStateAtCalorimeter().GetMomentum(), pTrack->GetCharge(), innerBField);
-
-            // Compare cluster and helix directions
-            CartesianVector muonEntryPoint(0.f, 0.f, 0.f);
-            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetMuonEntryPoint(helix, isPositiveZ, muonEntryPoint));
-
-            bool isInBarrel(false);
-            const float muonEntryR(std::sqrt(muonEntryPoint.GetX() * muonEntryPoint.GetX() + muonEntryPoint.GetY() * muonEntryPoint.GetY()));
+            // Extract track helix fit, projected into the muon system
+            const MuonProjection *pMuonProjection(NULL);
+            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, trackHelixCache.GetMuonProjection(pTrack, isPositiveZ, pMuonProjection));
 
-            if (muonEntryR > coilMidPointR)
-            {
-                isInBarrel = true;
-                PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, helix.GetPointOnCircle(coilMidPointR, helix.GetReferencePoint(), muonEntryPoint));
-            }
+            const Helix &externalHelix(pMuonProjection->m_externalHelix);
 
-            // Create helix that can be propagated in muon system, outside central detector
-            const float externalBField(isInBarrel ? muonBarrelBField : muonEndCapBField);
-
-            const Helix externalHelix(muonEntryPoint, helix.GetExtrapolatedMomentum(muonEntryPoint),
-                (externalBField < 0.f) ? -helix.GetCharge() : helix.GetCharge(), std::fabs(externalBField));
-
-            CartesianVector correctedMuonEntryPoint(0.f, 0.f, 0.f);
-            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetMuonEntryPoint(externalHelix, isPositiveZ, correctedMuonEntryPoint));
-
-            const CartesianVector helixDirection(externalHelix.GetExtrapolatedMomentum(correctedMuonEntryPoint).GetUnitVector());
-            const float helixClusterCosAngle(helixDirection.GetCosOpeningAngle(clusterFitResult.GetDirection()));
+            // Compare cluster and helix directions
+            const float helixClusterCosAngle(pMuonProjection->m_helixDirection.GetCosOpeningAngle(clusterFitResult.GetDirection()));
 
             if (helixClusterCosAngle < m_minHelixClusterCosAngle)
                 continue;
@@ -236,14 +210,12 @@ StatusCode MuonReconstructionAlgorithm::GetMuonEntryPoint(const Helix &helix, co
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-StatusCode MuonReconstructionAlgorithm::AddCaloHits(const ClusterList *const pMuonClusterList) const
+StatusCode MuonReconstructionAlgorithm::AddCaloHits(const ClusterList *const pMuonClusterList, TrackHelixCache &trackHelixCache) const
 {
     const GeometryManager *const pGeometryManager(PandoraContentApi::GetGeometry(*this));
     const float hCalEndCapInnerR(pGeometryManager->GetSubDetector(HCAL_ENDCAP).GetInnerRCoordinate());
     const float eCalEndCapInnerR(pGeometryManager->GetSubDetector(ECAL_ENDCAP).GetInnerRCoordinate());
 
-    const float innerBField(PandoraContentApi::GetPlugins(*this)->GetBFieldPlugin()->GetBField(CartesianVector(0.f, 0.f, 0.f)));
-
     const CaloHitList *pCaloHitList = NULL;
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetList(*this, m_inputCaloHitListName, pCaloHitList));
 
@@ -261,7 +233,7 @@ StatusCode MuonReconstructionAlgorithm::AddCaloHits(const ClusterList *const pMu
             continue;
 
         const Track *const pTrack = *(trackList.begin());
-        const Helix helix(pTrack->GetTrackStateAtCalorimeter().GetPosition(), pTrack->GetTrackStateAtCalorimeter().GetMomentum(), pTrack->GetCharge(), innerBField);
+        const Helix &helix(trackHelixCache.GetHelix(pTrack));
 
         for (OrderedCaloHitList::const_iterator layerIter = orderedCaloHitList.begin(), layerIterEnd = orderedCaloHitList.end(); layerIter != layerIterEnd; ++layerIter)
         {
@@ -488,6 +460,89 @@ StatusCode MuonReconstructionAlgorithm::GetPfoComponents(TrackList &pfoTrackList
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+MuonReconstructionAlgorithm::MuonProjection::MuonProjection(const Helix &externalHelix, const CartesianVector &helixDirection) :
+    m_externalHelix(externalHelix),
+    m_helixDirection(helixDirection)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+MuonReconstructionAlgorithm::TrackHelixCache::TrackHelixCache(const MuonReconstructionAlgorithm &algorithm) :
+    m_algorithm(algorithm)
+{
+    const GeometryManager *const pGeometryManager(PandoraContentApi::GetGeometry(algorithm));
+    const BFieldPlugin *const pBFieldPlugin(PandoraContentApi::GetPlugins(algorithm)->GetBFieldPlugin());
+
+    m_innerBField = pBFieldPlugin->GetBField(CartesianVector(0.f, 0.f, 0.f));
+    m_coilMidPointR = 0.5f * (pGeometryManager->GetSubDetector(COIL).GetInnerRCoordinate() + pGeometryManager->GetSubDetector(COIL).GetOuterRCoordinate());
+    m_muonBarrelBField = pBFieldPlugin->GetBField(CartesianVector(pGeometryManager->GetSubDetector(MUON_BARREL).GetInnerRCoordinate(), 0.f, 0.f));
+    m_muonEndCapBField = pBFieldPlugin->GetBField(CartesianVector(0.f, 0.f, std::fabs(pGeometryManager->GetSubDetector(MUON_ENDCAP).GetInnerZCoordinate())));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const Helix &MuonReconstructionAlgorithm::TrackHelixCache::GetHelix(const Track *const pTrack)
+{
+    TrackToHelixMap::const_iterator iter(m_trackToHelixMap.find(pTrack));
+
+    if (m_trackToHelixMap.end() == iter)
+    {
+        const Helix helix(pTrack->GetTrackStateAtCalorimeter().GetPosition(), pTrack->GetTrackStateAtCalorimeter().GetMomentum(), pTrack->GetCharge(), m_innerBField);
+        iter = m_trackToHelixMap.insert(TrackToHelixMap::value_type(pTrack, helix)).first;
+    }
+
+    return iter->second;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MuonReconstructionAlgorithm::TrackHelixCache::GetMuonProjection(const Track *const pTrack, const bool isPositiveZ, const MuonProjection *&pMuonProjection)
+{
+    const TrackEndCapPair trackEndCapPair(pTrack, isPositiveZ);
+    MuonProjectionMap::const_iterator iter(m_muonProjectionMap.find(trackEndCapPair));
+
+    if (m_muonProjectionMap.end() != iter)
+    {
+        pMuonProjection = &(iter->second);
+        return STATUS_CODE_SUCCESS;
+    }
+
+    const Helix &helix(this->GetHelix(pTrack));
+
+    CartesianVector muonEntryPoint(0.f, 0.f, 0.f);
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, m_algorithm.GetMuonEntryPoint(helix, isPositiveZ, muonEntryPoint));
+
+    bool isInBarrel(false);
+    const float muonEntryR(std::sqrt(muonEntryPoint.GetX() * muonEntryPoint.GetX() + muonEntryPoint.GetY() * muonEntryPoint.GetY()));
+
+    if (muonEntryR > m_coilMidPointR)
+    {
+        isInBarrel = true;
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, helix.GetPointOnCircle(m_coilMidPointR, helix.GetReferencePoint(), muonEntryPoint));
+    }
+
+    // Create helix that can be propagated in muon system, outside central detector
+    const float externalBField(isInBarrel ? m_muonBarrelBField : m_muonEndCapBField);
+
+    const Helix externalHelix(muonEntryPoint, helix.GetExtrapolatedMomentum(muonEntryPoint),
+        (externalBField < 0.f) ? -helix.GetCharge() : helix.GetCharge(), std::fabs(externalBField));
+
+    CartesianVector correctedMuonEntryPoint(0.f, 0.f, 0.f);
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, m_algorithm.GetMuonEntryPoint(externalHelix, isPositiveZ, correctedMuonEntryPoint));
+
+    const CartesianVector helixDirection(externalHelix.GetExtrapolatedMomentum(correctedMuonEntryPoint).GetUnitVector());
+
+    iter = m_muonProjectionMap.insert(MuonProjectionMap::value_type(trackEndCapPair, MuonProjection(externalHelix, helixDirection))).first;
+    pMuonProjection = &(iter->second);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode MuonReconstructionAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
 {
     // Input lists
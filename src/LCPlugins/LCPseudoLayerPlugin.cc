@@ -10,6 +10,9 @@
 
 #include "LCPlugins/LCPseudoLayerPlugin.h"
 
+#include <algorithm>
+#include <limits>
+
 using namespace pandora;
 
 namespace lc_content
@@ -51,40 +54,64 @@ StatusCode LCPseudoLayerPlugin::Initialize()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+void LCPseudoLayerPlugin::GetPseudoLayers(const CartesianPointVector &positionVector, UIntVector &pseudoLayers) const
+{
+    pseudoLayers.clear();
+    pseudoLayers.reserve(positionVector.size());
+
+    for (CartesianPointVector::const_iterator iter = positionVector.begin(), iterEnd = positionVector.end(); iter != iterEnd; ++iter)
+    {
+        unsigned int pseudoLayer(std::numeric_limits<unsigned int>::max());
+
+        if (STATUS_CODE_SUCCESS != this->FindPseudoLayer(*iter, pseudoLayer))
+            pseudoLayer = std::numeric_limits<unsigned int>::max();
+
+        pseudoLayers.push_back(pseudoLayer);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 unsigned int LCPseudoLayerPlugin::GetPseudoLayer(const CartesianVector &positionVector) const
+{
+    unsigned int pseudoLayer(0);
+    const StatusCode statusCode(this->FindPseudoLayer(positionVector, pseudoLayer));
+
+    if (STATUS_CODE_SUCCESS != statusCode)
+        throw StatusCodeException(statusCode);
+
+    return pseudoLayer;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode LCPseudoLayerPlugin::FindPseudoLayer(const CartesianVector &positionVector, unsigned int &pseudoLayer) const
 {
     const float zCoordinate(std::fabs(positionVector.GetZ()));
 
     if (zCoordinate > m_endCapEdgeZ)
-        throw StatusCodeException(STATUS_CODE_NOT_FOUND);
+        return STATUS_CODE_NOT_FOUND;
 
-    const float rCoordinate(this->GetMaximumRadius(m_eCalBarrelAngleVector, positionVector.GetX(), positionVector.GetY()));
-    const float rCoordinateMuon(this->GetMaximumRadius(m_muonBarrelAngleVector, positionVector.GetX(), positionVector.GetY()));
+    const float rCoordinate(this->GetMaximumRadius(m_eCalBarrelAngleVector, m_eCalBarrelPolygonLookup, positionVector.GetX(),
+        positionVector.GetY()));
+    const float rCoordinateMuon(this->GetMaximumRadius(m_muonBarrelAngleVector, m_muonBarrelPolygonLookup, positionVector.GetX(),
+        positionVector.GetY()));
 
     if ((rCoordinateMuon > m_barrelEdgeR) || (rCoordinate > m_barrelEdgeR))
-        throw StatusCodeException(STATUS_CODE_NOT_FOUND);
+        return STATUS_CODE_NOT_FOUND;
 
-    unsigned int pseudoLayer;
+    // ATTN Failures are common for positions sampled along helices, so are returned without any error reporting
+    unsigned int layer(0);
+    const StatusCode statusCode(((zCoordinate < m_endCapInnerZMuon) && (rCoordinateMuon < m_barrelInnerRMuon)) ?
+        this->GetPseudoLayer(rCoordinate, zCoordinate, m_rCorrection, m_zCorrection, m_barrelInnerR, m_endCapInnerZ, layer) :
+        this->GetPseudoLayer(rCoordinateMuon, zCoordinate, m_rCorrectionMuon, m_zCorrectionMuon, m_barrelInnerRMuon, m_endCapInnerZMuon, layer));
 
-    if ((zCoordinate < m_endCapInnerZMuon) && (rCoordinateMuon < m_barrelInnerRMuon))
-    {
-        const StatusCode statusCode(this->GetPseudoLayer(rCoordinate, zCoordinate, m_rCorrection, m_zCorrection, m_barrelInnerR,
-            m_endCapInnerZ, pseudoLayer));
-
-        if (STATUS_CODE_SUCCESS != statusCode)
-            throw StatusCodeException(statusCode);
-    }
-    else
-    {
-        const StatusCode statusCode(this->GetPseudoLayer(rCoordinateMuon, zCoordinate, m_rCorrectionMuon, m_zCorrectionMuon,
-            m_barrelInnerRMuon, m_endCapInnerZMuon, pseudoLayer));
-
-        if (STATUS_CODE_SUCCESS != statusCode)
-            throw StatusCodeException(statusCode);
-    }
+    if (STATUS_CODE_SUCCESS != statusCode)
+        return statusCode;
 
     // Reserve a pseudo layer for track projections, etc.
-    return (1 + pseudoLayer);
+    pseudoLayer = 1 + layer;
+    return STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -94,19 +121,21 @@ StatusCode LCPseudoLayerPlugin::GetPseudoLayer(const float rCoordinate, const fl
 {
     if (zCoordinate < endCapInnerZ)
     {
-        return this->FindMatchingLayer(rCoordinate, m_barrelLayerPositions, pseudoLayer);
+        return this->FindMatchingLayer(rCoordinate, m_barrelLayerPositions, m_barrelLayerLookup, pseudoLayer);
     }
     else if (rCoordinate < barrelInnerR)
     {
-        return this->FindMatchingLayer(zCoordinate, m_endCapLayerPositions, pseudoLayer);
+        return this->FindMatchingLayer(zCoordinate, m_endCapLayerPositions, m_endCapLayerLookup, pseudoLayer);
     }
     else
     {
         unsigned int bestBarrelLayer(0);
-        const StatusCode barrelStatusCode(this->FindMatchingLayer(rCoordinate - rCorrection, m_barrelLayerPositions, bestBarrelLayer));
+        const StatusCode barrelStatusCode(this->FindMatchingLayer(rCoordinate - rCorrection, m_barrelLayerPositions,
+            m_barrelLayerLookup, bestBarrelLayer));
 
         unsigned int bestEndCapLayer(0);
-        const StatusCode endCapStatusCode(this->FindMatchingLayer(zCoordinate - zCorrection, m_endCapLayerPositions, bestEndCapLayer));
+        const StatusCode endCapStatusCode(this->FindMatchingLayer(zCoordinate - zCorrection, m_endCapLayerPositions,
+            m_endCapLayerLookup, bestEndCapLayer));
 
         if ((STATUS_CODE_SUCCESS != barrelStatusCode) && (STATUS_CODE_SUCCESS != endCapStatusCode))
             return STATUS_CODE_NOT_FOUND;
@@ -118,31 +147,51 @@ StatusCode LCPseudoLayerPlugin::GetPseudoLayer(const float rCoordinate, const fl
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-StatusCode LCPseudoLayerPlugin::FindMatchingLayer(const float position, const LayerPositionList &layerPositionList,
+StatusCode LCPseudoLayerPlugin::FindMatchingLayer(const float position, const LayerPositionList &layerPositionList, const LayerLookup &layerLookup,
     unsigned int &layer) const
 {
-    LayerPositionList::const_iterator upperIter = std::upper_bound(layerPositionList.begin(), layerPositionList.end(), position);
+    // Find the first layer position beyond the specified position, as would std::upper_bound
+    const unsigned int nLayerPositions(layerPositionList.size());
+    unsigned int upperIndex(nLayerPositions);
+
+    if (position < layerPositionList.front())
+    {
+        upperIndex = 0;
+    }
+    else if (position < layerPositionList.back())
+    {
+        const unsigned int nBins(layerLookup.m_upperIndices.size());
+        const unsigned int bin(std::min(nBins - 1, static_cast<unsigned int>((position - layerLookup.m_minPosition) * layerLookup.m_inverseBinWidth)));
+        upperIndex = layerLookup.m_upperIndices[bin];
+
+        // Bins are no wider than the layer spacing, so a single step usually suffices; these steps also absorb any rounding of the bin
+        while ((upperIndex > 0) && (layerPositionList[upperIndex - 1] > position))
+            --upperIndex;
 
-    if (layerPositionList.end() == upperIter)
+        while ((upperIndex < nLayerPositions) && (layerPositionList[upperIndex] <= position))
+            ++upperIndex;
+    }
+
+    if (nLayerPositions == upperIndex)
     {
         return STATUS_CODE_NOT_FOUND;
     }
 
-    if (layerPositionList.begin() == upperIter)
+    if (0 == upperIndex)
     {
         layer = 0;
         return STATUS_CODE_SUCCESS;
     }
 
-    LayerPositionList::const_iterator lowerIter = upperIter - 1;
+    const unsigned int lowerIndex(upperIndex - 1);
 
-    if (std::fabs(position - *lowerIter) < std::fabs(position - *upperIter))
+    if (std::fabs(position - layerPositionList[lowerIndex]) < std::fabs(position - layerPositionList[upperIndex]))
     {
-        layer = std::distance(layerPositionList.begin(), lowerIter);
+        layer = lowerIndex;
     }
     else
     {
-        layer = std::distance(layerPositionList.begin(), upperIter);
+        layer = upperIndex;
     }
 
     return STATUS_CODE_SUCCESS;
@@ -150,6 +199,33 @@ StatusCode LCPseudoLayerPlugin::FindMatchingLayer(const float position, const La
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+void LCPseudoLayerPlugin::FillLayerLookup(const LayerPositionList &layerPositionList, LayerLookup &layerLookup) const
+{
+    // Use bins no wider than the smallest layer spacing, within a limit on the size of the table
+    const unsigned int maxNBins(10000);
+    float minLayerSpacing(std::numeric_limits<float>::max());
+
+    for (unsigned int iLayer = 1, nLayerPositions = layerPositionList.size(); iLayer < nLayerPositions; ++iLayer)
+        minLayerSpacing = std::min(minLayerSpacing, layerPositionList[iLayer] - layerPositionList[iLayer - 1]);
+
+    const float positionRange(layerPositionList.back() - layerPositionList.front());
+    const float nBinsRequired((positionRange > 0.f) ? std::ceil(positionRange / minLayerSpacing) : 1.f);
+    const unsigned int nBins((nBinsRequired < static_cast<float>(maxNBins)) ? std::max(1U, static_cast<unsigned int>(nBinsRequired)) : maxNBins);
+
+    layerLookup.m_minPosition = layerPositionList.front();
+    layerLookup.m_inverseBinWidth = ((positionRange > 0.f) ? static_cast<float>(nBins) / positionRange : 0.f);
+    layerLookup.m_upperIndices.clear();
+
+    for (unsigned int iBin = 0; iBin < nBins; ++iBin)
+    {
+        const float binLowEdge(layerLookup.m_minPosition + positionRange * static_cast<float>(iBin) / static_cast<float>(nBins));
+        layerLookup.m_upperIndices.push_back(std::distance(layerPositionList.begin(),
+            std::upper_bound(layerPositionList.begin(), layerPositionList.end(), binLowEdge)));
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 void LCPseudoLayerPlugin::StoreLayerPositions()
 {
     const GeometryManager *const pGeometryManager(this->GetPandora().GetGeometry());
@@ -220,6 +296,9 @@ void LCPseudoLayerPlugin::StoreDetectorOuterEdge()
 
     m_barrelLayerPositions.push_back(m_barrelEdgeR);
     m_endCapLayerPositions.push_back(m_endCapEdgeZ);
+
+    this->FillLayerLookup(m_barrelLayerPositions, m_barrelLayerLookup);
+    this->FillLayerLookup(m_endCapLayerPositions, m_endCapLayerLookup);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -233,6 +312,9 @@ void LCPseudoLayerPlugin::StorePolygonAngles()
 
     this->FillAngleVector(pGeometryManager->GetSubDetector(MUON_BARREL).GetInnerSymmetryOrder(),
         pGeometryManager->GetSubDetector(MUON_BARREL).GetInnerPhiCoordinate(), m_muonBarrelAngleVector);
+
+    this->FillPolygonLookup(m_eCalBarrelAngleVector, m_eCalBarrelPolygonLookup);
+    this->FillPolygonLookup(m_muonBarrelAngleVector, m_muonBarrelPolygonLookup);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -260,6 +342,36 @@ void LCPseudoLayerPlugin::StoreOverlapCorrectionDetails()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+float LCPseudoLayerPlugin::GetMaximumRadius(const AngleVector &angleVector, const PolygonLookup &polygonLookup, const float x, const float y) const
+{
+    if (angleVector.size() <= 2)
+        return std::sqrt((x * x) + (y * y));
+
+    const float pseudoPhi(this->GetPseudoPhi(x, y));
+
+    if (!(pseudoPhi >= 0.f) || !(pseudoPhi <= 4.f))
+        return this->GetMaximumRadius(angleVector, x, y);
+
+    // Only the candidate faces for this direction can provide the maximum, so the result is identical to that using all faces
+    const unsigned int nFaces(angleVector.size()), nBins(polygonLookup.m_firstFaces.size());
+    const unsigned int bin(std::min(nBins - 1, static_cast<unsigned int>(pseudoPhi * 0.25f * static_cast<float>(nBins))));
+
+    float maxRadius(0.);
+    for (unsigned int iFace = polygonLookup.m_firstFaces[bin], iCandidate = 0, nCandidates = polygonLookup.m_nFaces[bin]; iCandidate < nCandidates; ++iCandidate)
+    {
+        const float radius((x * angleVector[iFace].first) + (y * angleVector[iFace].second));
+
+        if (radius > maxRadius)
+            maxRadius = radius;
+
+        iFace = ((iFace + 1 < nFaces) ? iFace + 1 : 0);
+    }
+
+    return maxRadius;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 float LCPseudoLayerPlugin::GetMaximumRadius(const AngleVector &angleVector, const float x, const float y) const
 {
     if (angleVector.size() <= 2)
@@ -293,6 +405,77 @@ void LCPseudoLayerPlugin::FillAngleVector(const unsigned int symmetryOrder, cons
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+float LCPseudoLayerPlugin::GetPseudoPhi(const float x, const float y) const
+{
+    const float sum(std::fabs(x) + std::fabs(y));
+
+    if (!(sum > 0.f) || !(sum <= std::numeric_limits<float>::max()))
+        return -1.f;
+
+    if (y >= 0.f)
+        return ((x >= 0.f) ? y / sum : 1.f - x / sum);
+
+    return ((x < 0.f) ? 2.f - y / sum : 3.f + x / sum);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LCPseudoLayerPlugin::FillPolygonLookup(const AngleVector &angleVector, PolygonLookup &polygonLookup) const
+{
+    polygonLookup.m_firstFaces.clear();
+    polygonLookup.m_nFaces.clear();
+
+    const unsigned int nFaces(angleVector.size());
+
+    if (nFaces <= 2)
+        return;
+
+    // Each bin spans less than a sixteenth of a face, so the range spanned by a bin and its neighbours contains at most one change of face
+    const unsigned int nBins(16 * nFaces);
+
+    for (unsigned int iBin = 0; iBin < nBins; ++iBin)
+    {
+        const unsigned int lowEdgeBin((iBin + nBins - 1) % nBins), highEdgeBin((iBin + 2) % nBins);
+        unsigned int edgeFaces[2] = {0, 0};
+
+        for (unsigned int iEdge = 0; iEdge < 2; ++iEdge)
+        {
+            // Convert the pseudo phi value at the edge of the range into a direction in the x-y plane
+            const float pseudoPhi(4.f * static_cast<float>((0 == iEdge) ? lowEdgeBin : highEdgeBin) / static_cast<float>(nBins));
+            const float x((pseudoPhi < 2.f) ? 1.f - pseudoPhi : pseudoPhi - 3.f);
+            const float y((pseudoPhi < 1.f) ? pseudoPhi : (pseudoPhi < 3.f) ? 2.f - pseudoPhi : pseudoPhi - 4.f);
+
+            float maxRadius(-std::numeric_limits<float>::max());
+
+            for (unsigned int iFace = 0; iFace < nFaces; ++iFace)
+            {
+                const float radius((x * angleVector[iFace].first) + (y * angleVector[iFace].second));
+
+                if (radius > maxRadius)
+                {
+                    maxRadius = radius;
+                    edgeFaces[iEdge] = iFace;
+                }
+            }
+        }
+
+        polygonLookup.m_firstFaces.push_back(edgeFaces[0]);
+        polygonLookup.m_nFaces.push_back(1 + ((edgeFaces[1] + nFaces - edgeFaces[0]) % nFaces));
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LCPseudoLayerPlugin::LayerLookup::LayerLookup() :
+    m_minPosition(0.f),
+    m_inverseBinWidth(0.f)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode LCPseudoLayerPlugin::ReadSettings(const TiXmlHandle /*xmlHandle*/)
 {
     return STATUS_CODE_SUCCESS;
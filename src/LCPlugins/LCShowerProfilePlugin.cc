@@ -33,6 +33,15 @@ LCShowerProfilePlugin::LCShowerProfilePlugin() :
     m_transProfileMinTrackToPeakCut(1.6),
     m_transProfileMinDisTrackMatch(1.6)
 {
+    this->FillLongitudinalProfileTables();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LCShowerProfilePlugin::~LCShowerProfilePlugin()
+{
+    for (TwoDShowerProfilePool::const_iterator iter = m_twoDShowerProfilePool.begin(), iterEnd = m_twoDShowerProfilePool.end(); iter != iterEnd; ++iter)
+        delete *iter;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -235,38 +244,32 @@ void LCShowerProfilePlugin::CalculateLongitudinalProfile(const Cluster *const pC
     if ((0 == profileEndBin) || (eCalEnergy < std::numeric_limits<float>::epsilon()))
         throw StatusCodeException(STATUS_CODE_FAILURE);
 
-    // 2. Construct expected cluster profile
+    // 2. Construct expected cluster profile, only the bins compared with the cluster profile are required
     const double a(m_longProfileParameter0 + m_longProfileParameter1 * std::log(clusterEnergy / m_longProfileCriticalEnergy));
     const double gammaA(std::exp(lgamma(a)));
+    const float exponent(static_cast<float>(a - 1.));
 
-    float t(0.f);
-    FloatVector expectedProfile;
-    for (unsigned int iBin = 0; iBin < m_longProfileNBins; ++iBin)
+    FloatVector expectedProfile(profileEndBin, 0.f);
+    for (unsigned int iBin = 0; iBin < profileEndBin; ++iBin)
     {
-        t += m_longProfileBinWidth;
-        expectedProfile.push_back(static_cast<float>(clusterEnergy / 2. * std::pow(t / 2.f, static_cast<float>(a - 1.)) *
-            std::exp(-t / 2.) * m_longProfileBinWidth / gammaA));
+        expectedProfile[iBin] = static_cast<float>(clusterEnergy / 2. * std::pow(m_longProfileHalfDepths[iBin], exponent) *
+            m_longProfileExpTerms[iBin] * m_longProfileBinWidth / gammaA);
     }
 
-    // 3. Compare the cluster profile with the expected profile
+    // 3. Compare the cluster profile with the expected profile, sliding the expected profile along and reusing the sum of skipped bins
     unsigned int binOffsetAtMinDifference(0);
     float minProfileDifference(std::numeric_limits<float>::max());
+    float skippedProfileSum(0.f);
 
     for (unsigned int iBinOffset = 0; iBinOffset < profileEndBin; ++iBinOffset)
     {
-        float profileDifference(0.);
+        if (iBinOffset > 0)
+            skippedProfileSum += profile[iBinOffset - 1];
 
-        for (unsigned int iBin = 0; iBin < profileEndBin; ++iBin)
-        {
-            if (iBin < iBinOffset)
-            {
-                profileDifference += profile[iBin];
-            }
-            else
-            {
-                profileDifference += std::fabs(expectedProfile[iBin - iBinOffset] - profile[iBin]);
-            }
-        }
+        float profileDifference(skippedProfileSum);
+
+        for (unsigned int iBin = iBinOffset; iBin < profileEndBin; ++iBin)
+            profileDifference += std::fabs(expectedProfile[iBin - iBinOffset] - profile[iBin]);
 
         if (profileDifference < minProfileDifference)
         {
@@ -288,7 +291,8 @@ void LCShowerProfilePlugin::CalculateTransverseProfile(const Cluster *const pClu
     const bool inclusiveMode) const
 {
     // ATTN could combine trackless and tracked approach
-    TwoDShowerProfile showerProfile;
+    const TwoDShowerProfileHandle showerProfileHandle(*this);
+    TwoDShowerProfile &showerProfile(showerProfileHandle.GetShowerProfile());
     ShowerPeakObjectVector showerPeakObjectVector;
     this->CalculateTracklessTransverseShowers(pCluster, maxPseudoLayer, showerProfile, showerPeakObjectVector);
 
@@ -312,10 +316,11 @@ void LCShowerProfilePlugin::CalculateTrackBasedTransverseProfile(const Cluster *
     const unsigned int pseudoLayerPerSlice(maxPseudoLayer / m_transProfileTrackNearbyNSlices);
 
     // process first slice
-    TwoDShowerProfile showerProfileFirst;
+    TwoDShowerProfileHandle showerProfileHandleFirst(*this);
     ShowerPeakObjectVector showerPeakObjectVectorFirst;
     TwoDBinVector trackProjectionVector;
-    this->CalculateTrackNearbyTransverseShowers(pCluster, pseudoLayerPerSlice, pMinTrack, trackVector, showerProfileFirst, showerPeakObjectVectorFirst, trackProjectionVector);
+    this->CalculateTrackNearbyTransverseShowers(pCluster, pseudoLayerPerSlice, pMinTrack, trackVector, showerProfileHandleFirst.GetShowerProfile(),
+        showerPeakObjectVectorFirst, trackProjectionVector);
 
     if (m_transProfileTrackNearbyNSlices > 1)
     {
@@ -326,17 +331,17 @@ void LCShowerProfilePlugin::CalculateTrackBasedTransverseProfile(const Cluster *
 
             const unsigned int pseudoLayerEnd(nIter == m_transProfileTrackNearbyNSlices - 1 ? maxPseudoLayer : pseudoLayerPerSlice * (nIter + 1));
 
-            TwoDShowerProfile showerProfileNext;
+            TwoDShowerProfileHandle showerProfileHandleNext(*this);
             ShowerPeakObjectVector showerPeakObjectVectorNext;
-            this->CalculateTracklessTransverseShowers(pCluster, pseudoLayerEnd, showerProfileNext, showerPeakObjectVectorNext);
+            this->CalculateTracklessTransverseShowers(pCluster, pseudoLayerEnd, showerProfileHandleNext.GetShowerProfile(), showerPeakObjectVectorNext);
             this->MarkPeaksCloseToTracks(trackProjectionVector, showerPeakObjectVectorNext);
             this->MatchPeaksInTwoSlices(showerPeakObjectVectorFirst, showerPeakObjectVectorNext);
-            showerProfileFirst = showerProfileNext;
+            showerProfileHandleFirst.Swap(showerProfileHandleNext);
             showerPeakObjectVectorFirst = showerPeakObjectVectorNext;
         }
     }
 
-    this->ConvertBinsToShowerLists(showerProfileFirst, showerPeakObjectVectorFirst, showerPeakListPhoton, showerPeakListNonPhoton, false);
+    this->ConvertBinsToShowerLists(showerProfileHandleFirst.GetShowerProfile(), showerPeakObjectVectorFirst, showerPeakListPhoton, showerPeakListNonPhoton, false);
     std::sort(showerPeakListPhoton.begin(), showerPeakListPhoton.end(), LCShowerProfilePlugin::SortShowerPeakListByEnergy);
     std::sort(showerPeakListNonPhoton.begin(), showerPeakListNonPhoton.end(), LCShowerProfilePlugin::SortShowerPeakListByEnergy);
 }
@@ -362,13 +367,6 @@ void LCShowerProfilePlugin::CalculateTrackNearbyTransverseShowers(const Cluster
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LCShowerProfilePlugin::CreateEmptyTwoDShowerProfile(TwoDShowerProfile &twoDShowerProfile) const
-{
-    twoDShowerProfile = TwoDShowerProfile(m_transProfileNBins, ShowerProfile(m_transProfileNBins, ShowerProfileEntry()));
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-
 void LCShowerProfilePlugin::InitialiseTransverseProfile(const pandora::Cluster *const pCluster, const unsigned int maxPseudoLayer, TwoDShowerProfile &showerProfile) const
 {
     CartesianVector innerLayerCentroid(0.f, 0.f, 0.f), uAxis(0.f, 0.f, 0.f), vAxis(0.f, 0.f, 0.f);
@@ -414,7 +412,7 @@ void LCShowerProfilePlugin::CalculateProjectionAxes(const Cluster *const pCluste
 void LCShowerProfilePlugin::InitialiseTwoDShowerProfile(const Cluster *const pCluster, const unsigned int maxPseudoLayer, const CartesianVector &innerLayerCentroid,
     const CartesianVector &uAxis, const CartesianVector &vAxis, TwoDShowerProfile &showerProfile) const
 {
-    this->CreateEmptyTwoDShowerProfile(showerProfile);
+    showerProfile.Clear();
     const OrderedCaloHitList &orderedCaloHitList(pCluster->GetOrderedCaloHitList());
     const int nOffsetBins(m_transProfileNBins / 2);
     for (OrderedCaloHitList::const_iterator iter = orderedCaloHitList.begin(), iterEnd = orderedCaloHitList.end(); iter != iterEnd; ++iter)
@@ -433,19 +431,18 @@ void LCShowerProfilePlugin::InitialiseTwoDShowerProfile(const Cluster *const pCl
             {
                 if (iter->first > maxPseudoLayer)
                 {
-                    showerProfile[uBin][vBin].m_unusedCaloHitList.push_back(pCaloHit);
+                    showerProfile.AddUnusedCaloHit(uBin, vBin, pCaloHit);
                 }
                 else
                 {
-                    showerProfile[uBin][vBin].m_energy += pCaloHit->GetElectromagneticEnergy();
-                    showerProfile[uBin][vBin].m_caloHitList.push_back(pCaloHit);
+                    showerProfile.AddCaloHit(uBin, vBin, pCaloHit);
                 }
             }
             else
             {
                 int uEdgeBin(0), vEdgeBin(0);
                 this->FindBoundaryBins(uBin, vBin, 0, m_transProfileNBins - 1, 0, m_transProfileNBins - 1, uEdgeBin, vEdgeBin);
-                showerProfile[uEdgeBin][vEdgeBin].m_unusedCaloHitList.push_back(pCaloHit);
+                showerProfile.AddUnusedCaloHit(uEdgeBin, vEdgeBin, pCaloHit);
             }
         }
     }
@@ -494,36 +491,51 @@ float LCShowerProfilePlugin::GetCellLengthScale(const Cluster *const pCluster) c
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LCShowerProfilePlugin::MaskLowHeightRegions(TwoDShowerProfile &showerProfile) const
+void LCShowerProfilePlugin::GetBinsToScan(const TwoDShowerProfile &showerProfile, TwoDBinVector &binsToScan) const
 {
+    // ATTN Unoccupied bins can only be masked out if a bin with zero energy would fail the peak threshold, otherwise scan every bin
+    if (m_transProfilePeakThreshold >= std::numeric_limits<float>::epsilon())
+    {
+        showerProfile.GetOccupiedBins(binsToScan);
+        return;
+    }
+
     for (int uBin = 0; uBin < m_transProfileNBins; ++uBin)
     {
         for (int vBin = 0; vBin < m_transProfileNBins; ++vBin)
-        {
-            if (showerProfile[uBin][vBin].m_energy < m_transProfilePeakThreshold)
-            {
-                showerProfile[uBin][vBin].m_isAvailable = false;
-                showerProfile[uBin][vBin].m_potentialPeak = false;
-            }
-        }
+            binsToScan.push_back(std::make_pair(uBin, vBin));
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LCShowerProfilePlugin::FindRawPeaksInTwoDShowerProfile(TwoDShowerProfile &showerProfile, ShowerPeakObjectVector &showerPeakObjectVector) const
+void LCShowerProfilePlugin::MaskLowHeightRegions(const TwoDBinVector &binsToScan, TwoDShowerProfile &showerProfile) const
 {
-    for (int uBin = 0; uBin < m_transProfileNBins; ++uBin)
+    for (TwoDBinVector::const_iterator iter = binsToScan.begin(), iterEnd = binsToScan.end(); iter != iterEnd; ++iter)
     {
-        for (int vBin = 0; vBin < m_transProfileNBins; ++vBin)
+        ShowerProfileEntry &showerProfileEntry(showerProfile.GetEntry(iter->first, iter->second));
+        const bool isAboveThreshold(!(showerProfileEntry.m_energy < m_transProfilePeakThreshold));
+        showerProfileEntry.m_isAvailable = isAboveThreshold;
+        showerProfileEntry.m_potentialPeak = isAboveThreshold;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LCShowerProfilePlugin::FindRawPeaksInTwoDShowerProfile(const TwoDBinVector &binsToScan, TwoDShowerProfile &showerProfile,
+    ShowerPeakObjectVector &showerPeakObjectVector) const
+{
+    for (TwoDBinVector::const_iterator iter = binsToScan.begin(), iterEnd = binsToScan.end(); iter != iterEnd; ++iter)
+    {
+        const int uBin(iter->first), vBin(iter->second);
+        const ShowerProfileEntry &showerProfileEntry(showerProfile.GetEntry(uBin, vBin));
+
+        if (!showerProfileEntry.m_isAvailable)
+            continue;
+        if (showerProfileEntry.m_potentialPeak && this->IsPeak(showerProfile,uBin,vBin))
         {
-            if (!showerProfile[uBin][vBin].m_isAvailable)
-                continue;
-            if (showerProfile[uBin][vBin].m_potentialPeak && this->IsPeak(showerProfile,uBin,vBin))
-            {
-                ShowerPeakObject showerPeakObject(showerProfile[uBin][vBin].m_energy, uBin, vBin);
-                showerPeakObjectVector.push_back(showerPeakObject);
-            }
+            ShowerPeakObject showerPeakObject(showerProfileEntry.m_energy, uBin, vBin);
+            showerPeakObjectVector.push_back(showerPeakObject);
         }
     }
 }
@@ -532,43 +544,47 @@ void LCShowerProfilePlugin::FindRawPeaksInTwoDShowerProfile(TwoDShowerProfile &s
 
 void LCShowerProfilePlugin::AssociateUnavailableBinsToPeaks(const TwoDShowerProfile &showerProfile, ShowerPeakObjectVector &showerPeakObjectVector) const
 {
-    for (int uBin = 0; uBin < m_transProfileNBins; ++uBin)
+    // ATTN Any unscanned bins are empty and would contribute neither energy nor calo hits to a peak
+    TwoDBinVector binsToScan;
+    this->GetBinsToScan(showerProfile, binsToScan);
+
+    for (TwoDBinVector::const_iterator iter = binsToScan.begin(), iterEnd = binsToScan.end(); iter != iterEnd; ++iter)
     {
-        for (int vBin = 0; vBin < m_transProfileNBins; ++vBin)
-        {
-            if (showerProfile[uBin][vBin].m_isAvailable)
-                continue;
+        const int uBin(iter->first), vBin(iter->second);
 
-            ShowerPeakObject  * bestShowerPeakObject = NULL;;
-            this->CalculateBestPeakUsingMetric(showerPeakObjectVector, uBin, vBin, bestShowerPeakObject);
-            if (bestShowerPeakObject)
-            {
-                bestShowerPeakObject->m_associatedBins.push_back(std::make_pair(uBin,vBin));
-            }
+        if (showerProfile.GetEntry(uBin, vBin).m_isAvailable)
+            continue;
+
+        ShowerPeakObject  * bestShowerPeakObject = NULL;;
+        this->CalculateBestPeakUsingMetric(showerPeakObjectVector, uBin, vBin, bestShowerPeakObject);
+        if (bestShowerPeakObject)
+        {
+            bestShowerPeakObject->m_associatedBins.push_back(std::make_pair(uBin,vBin));
         }
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LCShowerProfilePlugin::AssociateBinsToPeaks(const TwoDShowerProfile &showerProfile, ShowerPeakObjectVector &showerPeakObjectVector) const
+void LCShowerProfilePlugin::AssociateBinsToPeaks(const TwoDBinVector &binsToScan, const TwoDShowerProfile &showerProfile,
+    ShowerPeakObjectVector &showerPeakObjectVector) const
 {
-    for (int uBin = 0; uBin < m_transProfileNBins; ++uBin)
+    for (TwoDBinVector::const_iterator iter = binsToScan.begin(), iterEnd = binsToScan.end(); iter != iterEnd; ++iter)
     {
-        for (int vBin = 0; vBin < m_transProfileNBins; ++vBin)
-        {
-            if (!showerProfile[uBin][vBin].m_isAvailable)
-                continue;
+        const int uBin(iter->first), vBin(iter->second);
 
-            ShowerPeakObject  * bestShowerPeakObject = NULL;;
-            this->CalculateBestPeakUsingMetric(showerPeakObjectVector, uBin, vBin, bestShowerPeakObject);
-            if (bestShowerPeakObject)
-            {
-                bestShowerPeakObject->m_associatedBins.push_back(std::make_pair(uBin,vBin));
-            }
+        if (!showerProfile.GetEntry(uBin, vBin).m_isAvailable)
+            continue;
+
+        ShowerPeakObject  * bestShowerPeakObject = NULL;;
+        this->CalculateBestPeakUsingMetric(showerPeakObjectVector, uBin, vBin, bestShowerPeakObject);
+        if (bestShowerPeakObject)
+        {
+            bestShowerPeakObject->m_associatedBins.push_back(std::make_pair(uBin,vBin));
         }
     }
 }
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 void LCShowerProfilePlugin::AssociateBinsToPeaks(const TwoDBinVector &twoDBinVector, ShowerPeakObjectVector &showerPeakObjectVector) const
@@ -667,9 +683,11 @@ void LCShowerProfilePlugin::MatchPeaksInTwoSlices(const ShowerPeakObjectVector &
 
 void LCShowerProfilePlugin::ProcessShowerProfile(TwoDShowerProfile &showerProfile, ShowerPeakObjectVector &showerPeakObjectVector) const
 {
-    this->MaskLowHeightRegions(showerProfile);
-    this->FindRawPeaksInTwoDShowerProfile(showerProfile, showerPeakObjectVector);
-    this->AssociateBinsToPeaks(showerProfile, showerPeakObjectVector);
+    TwoDBinVector binsToScan;
+    this->GetBinsToScan(showerProfile, binsToScan);
+    this->MaskLowHeightRegions(binsToScan, showerProfile);
+    this->FindRawPeaksInTwoDShowerProfile(binsToScan, showerProfile, showerPeakObjectVector);
+    this->AssociateBinsToPeaks(binsToScan, showerProfile, showerPeakObjectVector);
     TwoDBinVector twoDBinVector;
     this->ApplyQualityCutPeakNBin(showerPeakObjectVector, twoDBinVector);
     this->AssociateBinsToPeaks(twoDBinVector, showerPeakObjectVector);
@@ -739,7 +757,7 @@ void LCShowerProfilePlugin::ConvertBinsToShowerLists(const TwoDShowerProfile &sh
         for (TwoDBinVector::const_iterator bIter = showerPeakObject.m_associatedBins.begin(), bIterEnd = showerPeakObject.m_associatedBins.end(); bIter!= bIterEnd; ++bIter )
         {
             const TwoDBin  &twoDBin(*bIter);
-            const ShowerProfileEntry &showerProfileEntry(showerProfile[twoDBin.first][twoDBin.second]);
+            const ShowerProfileEntry &showerProfileEntry(showerProfile.GetEntry(twoDBin.first, twoDBin.second));
             const float energy(showerProfileEntry.m_energy);
             peakTotalEnergy += energy;
             const float uBinDifference(twoDBin.first - showerPeakObject.GetPeakUBin());
@@ -748,10 +766,10 @@ void LCShowerProfilePlugin::ConvertBinsToShowerLists(const TwoDShowerProfile &sh
             vBar += vBinDifference * energy;
             uuBar += uBinDifference * uBinDifference * energy;
             vvBar += vBinDifference * vBinDifference * energy;
-            caloHitList.insert(caloHitList.end(), showerProfileEntry.m_caloHitList.begin(), showerProfileEntry.m_caloHitList.end());
+            showerProfile.GetCaloHits(twoDBin.first, twoDBin.second, caloHitList);
 
             if (inclusiveMode)
-                caloHitList.insert(caloHitList.end(), showerProfileEntry.m_unusedCaloHitList.begin(), showerProfileEntry.m_unusedCaloHitList.end());
+                showerProfile.GetUnusedCaloHits(twoDBin.first, twoDBin.second, caloHitList);
         }
         if (peakTotalEnergy < std::numeric_limits<float>::epsilon())
             throw StatusCodeException(STATUS_CODE_FAILURE);
@@ -800,17 +818,17 @@ bool LCShowerProfilePlugin::Check8NeighbourFull(TwoDShowerProfile &showerProfile
                 continue;
             if (uBinStart < 0 || uBinStart > m_transProfileNBins - 1 || vBinStart < 0 || vBinStart > m_transProfileNBins - 1)
                 continue;
-            if (!showerProfile[uBinStart][vBinStart].m_isAvailable)
+            if (!showerProfile.GetEntry(uBinStart, vBinStart).m_isAvailable)
                 continue;
 
-            if (showerProfile[uBinStart][vBinStart].m_energy >showerProfile[uBin][vBin].m_energy)
+            if (showerProfile.GetEntry(uBinStart, vBinStart).m_energy >showerProfile.GetEntry(uBin, vBin).m_energy)
             {
-                showerProfile[uBin][vBin].m_potentialPeak = false;
+                showerProfile.GetEntry(uBin, vBin).m_potentialPeak = false;
                 return false;
             }
             else
             {
-                showerProfile[uBinStart][vBinStart].m_potentialPeak = false;
+                showerProfile.GetEntry(uBinStart, vBinStart).m_potentialPeak = false;
             }
         }
     }
@@ -827,17 +845,17 @@ bool LCShowerProfilePlugin::Check8NeighbourFast(TwoDShowerProfile &showerProfile
         {
             if (uBinStart == uBin && vBinStart == vBin)
                 continue;
-            if (!showerProfile[uBinStart][vBinStart].m_isAvailable)
+            if (!showerProfile.GetEntry(uBinStart, vBinStart).m_isAvailable)
                 continue;
 
-            if (showerProfile[uBinStart][vBinStart].m_energy >showerProfile[uBin][vBin].m_energy)
+            if (showerProfile.GetEntry(uBinStart, vBinStart).m_energy >showerProfile.GetEntry(uBin, vBin).m_energy)
             {
-                showerProfile[uBin][vBin].m_potentialPeak = false;
+                showerProfile.GetEntry(uBin, vBin).m_potentialPeak = false;
                 return false;
             }
             else
             {
-                showerProfile[uBinStart][vBinStart].m_potentialPeak = false;
+                showerProfile.GetEntry(uBinStart, vBinStart).m_potentialPeak = false;
             }
         }
     }
@@ -918,6 +936,136 @@ bool LCShowerProfilePlugin::SortShowerPeakListByEnergy(const ShowerPeak &lhs, co
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+LCShowerProfilePlugin::TwoDShowerProfile *LCShowerProfilePlugin::BorrowTwoDShowerProfile() const
+{
+    {
+        std::lock_guard<std::mutex> lock(m_twoDShowerProfilePoolMutex);
+
+        while (!m_twoDShowerProfilePool.empty())
+        {
+            TwoDShowerProfile *const pShowerProfile(m_twoDShowerProfilePool.back());
+            m_twoDShowerProfilePool.pop_back();
+
+            if (m_transProfileNBins == pShowerProfile->GetNBins())
+                return pShowerProfile;
+
+            delete pShowerProfile;
+        }
+    }
+
+    return new TwoDShowerProfile(m_transProfileNBins);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LCShowerProfilePlugin::ReturnTwoDShowerProfile(TwoDShowerProfile *const pShowerProfile) const
+{
+    std::lock_guard<std::mutex> lock(m_twoDShowerProfilePoolMutex);
+    m_twoDShowerProfilePool.push_back(pShowerProfile);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LCShowerProfilePlugin::FillLongitudinalProfileTables()
+{
+    m_longProfileHalfDepths.clear();
+    m_longProfileExpTerms.clear();
+
+    float t(0.f);
+    for (unsigned int iBin = 0; iBin < m_longProfileNBins; ++iBin)
+    {
+        t += m_longProfileBinWidth;
+        m_longProfileHalfDepths.push_back(t / 2.f);
+        m_longProfileExpTerms.push_back(std::exp(-t / 2.));
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LCShowerProfilePlugin::TwoDShowerProfile::TwoDShowerProfile(const int nBins) :
+    m_nBins(nBins),
+    m_entries((nBins > 0) ? nBins * nBins : 0, ShowerProfileEntry())
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LCShowerProfilePlugin::TwoDShowerProfile::AddCaloHit(const int uBin, const int vBin, const CaloHit *const pCaloHit)
+{
+    const int binIndex(this->GetBinIndex(uBin, vBin));
+    ShowerProfileEntry &showerProfileEntry(m_entries[binIndex]);
+    showerProfileEntry.m_energy += pCaloHit->GetElectromagneticEnergy();
+    this->AppendCaloHit(binIndex, pCaloHit, showerProfileEntry.m_firstHitIndex, showerProfileEntry.m_lastHitIndex);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LCShowerProfilePlugin::TwoDShowerProfile::AddUnusedCaloHit(const int uBin, const int vBin, const CaloHit *const pCaloHit)
+{
+    const int binIndex(this->GetBinIndex(uBin, vBin));
+    ShowerProfileEntry &showerProfileEntry(m_entries[binIndex]);
+    this->AppendCaloHit(binIndex, pCaloHit, showerProfileEntry.m_firstUnusedHitIndex, showerProfileEntry.m_lastUnusedHitIndex);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LCShowerProfilePlugin::TwoDShowerProfile::GetOccupiedBins(TwoDBinVector &occupiedBins) const
+{
+    IntVector occupiedBinIndices(m_occupiedBinIndices);
+    std::sort(occupiedBinIndices.begin(), occupiedBinIndices.end());
+
+    for (IntVector::const_iterator iter = occupiedBinIndices.begin(), iterEnd = occupiedBinIndices.end(); iter != iterEnd; ++iter)
+        occupiedBins.push_back(std::make_pair(*iter / m_nBins, *iter % m_nBins));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LCShowerProfilePlugin::TwoDShowerProfile::Clear()
+{
+    for (IntVector::const_iterator iter = m_occupiedBinIndices.begin(), iterEnd = m_occupiedBinIndices.end(); iter != iterEnd; ++iter)
+        m_entries[*iter] = ShowerProfileEntry();
+
+    m_caloHits.clear();
+    m_nextHitIndices.clear();
+    m_occupiedBinIndices.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LCShowerProfilePlugin::TwoDShowerProfile::AppendCaloHit(const int binIndex, const CaloHit *const pCaloHit, int &firstHitIndex, int &lastHitIndex)
+{
+    const ShowerProfileEntry &showerProfileEntry(m_entries[binIndex]);
+
+    if ((showerProfileEntry.m_firstHitIndex < 0) && (showerProfileEntry.m_firstUnusedHitIndex < 0))
+        m_occupiedBinIndices.push_back(binIndex);
+
+    const int hitIndex(static_cast<int>(m_caloHits.size()));
+    m_caloHits.push_back(pCaloHit);
+    m_nextHitIndices.push_back(-1);
+
+    if (lastHitIndex < 0)
+    {
+        firstHitIndex = hitIndex;
+    }
+    else
+    {
+        m_nextHitIndices[lastHitIndex] = hitIndex;
+    }
+
+    lastHitIndex = hitIndex;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LCShowerProfilePlugin::TwoDShowerProfile::GetCaloHits(const int firstHitIndex, CaloHitList &caloHitList) const
+{
+    for (int hitIndex = firstHitIndex; hitIndex >= 0; hitIndex = m_nextHitIndices[hitIndex])
+        caloHitList.push_back(m_caloHits[hitIndex]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode LCShowerProfilePlugin::ReadSettings(const TiXmlHandle xmlHandle)
 {
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
@@ -962,6 +1110,9 @@ StatusCode LCShowerProfilePlugin::ReadSettings(const TiXmlHandle xmlHandle)
     PANDORA_THROW_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
         "TransProfilePeakFindingMetric", m_transProfilePeakFindingMetric));
 
+    if (m_transProfilePeakFindingMetric > 3)
+        throw StatusCodeException(STATUS_CODE_INVALID_PARAMETER);
+
     PANDORA_THROW_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
         "TransProfileMinNBinsCut", m_transProfileMinNBinsCut));
 
@@ -974,6 +1125,8 @@ StatusCode LCShowerProfilePlugin::ReadSettings(const TiXmlHandle xmlHandle)
     PANDORA_THROW_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
         "TransProfileMinDisTrackMatch", m_transProfileMinDisTrackMatch));
 
+    this->FillLongitudinalProfileTables();
+
     return STATUS_CODE_SUCCESS;
 }
 
@@ -29,6 +29,12 @@ LCSoftwareCompensation::LCSoftwareCompensation(const LCSoftwareCompensationParam
         std::cout << "LCSoftwareCompensation:LCSoftwareCompensation - Incorrect number of parameters required for software compensation technique." << std::endl;
         throw STATUS_CODE_INVALID_PARAMETER;
     }
+    if (m_softCompEnergyDensityBins.empty())
+    {
+        std::cout << "LCSoftwareCompensation:LCSoftwareCompensation - No input density bins" << std::endl;
+        throw STATUS_CODE_INVALID_PARAMETER;
+    }
+
     std::sort(m_softCompEnergyDensityBins.begin(), m_softCompEnergyDensityBins.end());
 
     if (m_softCompEnergyDensityBins.front() < 0.f)
@@ -42,6 +48,11 @@ LCSoftwareCompensation::LCSoftwareCompensation(const LCSoftwareCompensationParam
         std::cout << "LCSoftwareCompensation::LCSoftwareCompensation - Input energy density final bin inconsistent with input density bins" << std::endl;
         throw STATUS_CODE_FAILURE;
     }
+
+    for (unsigned int iBin = 0; iBin < m_softCompEnergyDensityBins.size() - 1; iBin++)
+        m_binnedEnergyDensities.push_back((m_softCompEnergyDensityBins.at(iBin) + m_softCompEnergyDensityBins.at(iBin + 1)) * 0.5f);
+
+    m_binnedEnergyDensities.push_back(m_energyDensityFinalBin);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -60,10 +71,8 @@ StatusCode LCSoftwareCompensation::MakeEnergyCorrections(const pandora::Cluster
     if (correctedHadronicEnergy < m_maxClusterEnergyToApplySoftComp)
     {
         const float clusterHadEnergy = pCluster->GetHadronicEnergy();
-        pandora::CaloHitList clusterCaloHitList;
-        pCluster->GetOrderedCaloHitList().FillCaloHitList(clusterCaloHitList);
-        clusterCaloHitList.insert(clusterCaloHitList.end(), pCluster->GetIsolatedCaloHitList().begin(),pCluster->GetIsolatedCaloHitList().end());
-        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->SoftComp(clusterHadEnergy, clusterCaloHitList, correctedHadronicEnergy));
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->SoftComp(clusterHadEnergy, pCluster->GetOrderedCaloHitList(), pCluster->GetIsolatedCaloHitList(),
+            correctedHadronicEnergy));
     }
 
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CleanCluster(pCluster, correctedHadronicEnergy));
@@ -84,6 +93,9 @@ StatusCode LCSoftwareCompensation::CleanCluster(const pandora::Cluster *const pC
     bool isFineGranularity(true);
     const OrderedCaloHitList &orderedCaloHitList(pCluster->GetOrderedCaloHitList());
 
+    // Layer energies are only summed once a hit requires cleaning
+    FloatVector layerHadronicEnergies;
+
     for (OrderedCaloHitList::const_iterator layerIter = orderedCaloHitList.begin(), layerIterEnd = orderedCaloHitList.end(); (layerIter != layerIterEnd) && isFineGranularity; ++layerIter)
     {
         const unsigned int pseudoLayer(layerIter->first);
@@ -102,17 +114,20 @@ StatusCode LCSoftwareCompensation::CleanCluster(const pandora::Cluster *const pC
 
             if ((hitHadronicEnergy > m_minCleanHitEnergy) && (hitHadronicEnergy / clusterHadronicEnergy > m_minCleanHitEnergyFraction))
             {
+                if (layerHadronicEnergies.empty())
+                    this->GetLayerHadronicEnergies(orderedCaloHitList, layerHadronicEnergies);
+
                 float energyInPreviousLayer(0.f);
 
                 if (pseudoLayer > firstPseudoLayer)
-                    energyInPreviousLayer = this->GetHadronicEnergyInLayer(orderedCaloHitList, pseudoLayer - 1);
+                    energyInPreviousLayer = this->GetHadronicEnergyInLayer(orderedCaloHitList, layerHadronicEnergies, pseudoLayer - 1);
 
                 float energyInNextLayer(0.f);
 
                 if (pseudoLayer < std::numeric_limits<unsigned int>::max())
-                    energyInNextLayer = this->GetHadronicEnergyInLayer(orderedCaloHitList, pseudoLayer + 1);
+                    energyInNextLayer = this->GetHadronicEnergyInLayer(orderedCaloHitList, layerHadronicEnergies, pseudoLayer + 1);
 
-                const float energyInCurrentLayer = this->GetHadronicEnergyInLayer(orderedCaloHitList, pseudoLayer);
+                const float energyInCurrentLayer = this->GetHadronicEnergyInLayer(orderedCaloHitList, layerHadronicEnergies, pseudoLayer);
                 float energyInAdjacentLayers(energyInPreviousLayer + energyInNextLayer);
 
                 if (pseudoLayer > firstPseudoLayer)
@@ -132,26 +147,41 @@ StatusCode LCSoftwareCompensation::CleanCluster(const pandora::Cluster *const pC
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-float LCSoftwareCompensation::GetHadronicEnergyInLayer(const OrderedCaloHitList &orderedCaloHitList, const unsigned int pseudoLayer) const
+void LCSoftwareCompensation::GetLayerHadronicEnergies(const OrderedCaloHitList &orderedCaloHitList, FloatVector &layerHadronicEnergies) const
 {
-    OrderedCaloHitList::const_iterator iter = orderedCaloHitList.find(pseudoLayer);
-
-    float hadronicEnergy(0.f);
+    const unsigned int innerLayer(orderedCaloHitList.begin()->first), outerLayer(orderedCaloHitList.rbegin()->first);
+    layerHadronicEnergies.assign(outerLayer - innerLayer + 1, 0.f);
 
-    if (iter != orderedCaloHitList.end())
+    for (OrderedCaloHitList::const_iterator iter = orderedCaloHitList.begin(), iterEnd = orderedCaloHitList.end(); iter != iterEnd; ++iter)
     {
+        float hadronicEnergy(0.f);
+
         for (const CaloHit *const pCaloHit : *iter->second)
         {
             hadronicEnergy += pCaloHit->GetHadronicEnergy();
         }
+
+        layerHadronicEnergies[iter->first - innerLayer] = hadronicEnergy;
     }
+}
 
-    return hadronicEnergy;
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+float LCSoftwareCompensation::GetHadronicEnergyInLayer(const OrderedCaloHitList &orderedCaloHitList, const FloatVector &layerHadronicEnergies,
+    const unsigned int pseudoLayer) const
+{
+    const unsigned int innerLayer(orderedCaloHitList.begin()->first);
+
+    if ((pseudoLayer < innerLayer) || (pseudoLayer - innerLayer >= layerHadronicEnergies.size()))
+        return 0.f;
+
+    return layerHadronicEnergies[pseudoLayer - innerLayer];
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-StatusCode LCSoftwareCompensation::SoftComp(float clusterEnergyEstimation, const pandora::CaloHitList &caloHitList, float &energyCorrection) const
+StatusCode LCSoftwareCompensation::SoftComp(float clusterEnergyEstimation, const pandora::OrderedCaloHitList &orderedCaloHitList,
+    const pandora::CaloHitList &isolatedCaloHitList, float &energyCorrection) const
 {
     float energySoftComp(0.f);
 
@@ -159,22 +189,50 @@ StatusCode LCSoftwareCompensation::SoftComp(float clusterEnergyEstimation, const
     const float p2 = m_softCompParameters.at(3) + m_softCompParameters.at(4)*clusterEnergyEstimation + m_softCompParameters.at(5)*clusterEnergyEstimation*clusterEnergyEstimation;
     const float p3 = m_softCompParameters.at(6)/(m_softCompParameters.at(7) + exp(m_softCompParameters.at(8)*clusterEnergyEstimation));
 
+    // ATTN Hit energy densities are binned, so the weights need only be calculated once per bin, rather than once per hit
+    FloatVector binnedWeights;
+    binnedWeights.reserve(m_binnedEnergyDensities.size());
+
+    for (const float rho : m_binnedEnergyDensities)
+        binnedWeights.push_back(p1*exp(p2*rho) + p3);
+
+    const float unknownDensity(0.f);
+    const float unknownDensityWeight(p1*exp(p2*unknownDensity) + p3);
+
+    for (OrderedCaloHitList::const_iterator iter = orderedCaloHitList.begin(), iterEnd = orderedCaloHitList.end(); iter != iterEnd; ++iter)
+    {
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->AddSoftCompEnergy(*iter->second, binnedWeights, unknownDensityWeight, energySoftComp));
+    }
+
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->AddSoftCompEnergy(isolatedCaloHitList, binnedWeights, unknownDensityWeight, energySoftComp));
+
+    energyCorrection = energySoftComp;
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode LCSoftwareCompensation::AddSoftCompEnergy(const pandora::CaloHitList &caloHitList, const pandora::FloatVector &binnedWeights,
+    const float unknownDensityWeight, float &energySoftComp) const
+{
     for (const pandora::CaloHit *const pCaloHit : caloHitList)
     {
         if (HCAL == pCaloHit->GetHitType())
         {
             const float hitEnergy = pCaloHit->GetHadronicEnergy();
-            float rho(0.f);
+            float weight(unknownDensityWeight);
 
             try 
             {
-                PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->FindDensity(pCaloHit,rho));
+                unsigned int densityBin(0);
+                PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->FindDensityBin(pCaloHit, densityBin));
+                weight = binnedWeights[densityBin];
             }
             catch (const StatusCodeException &)
             {
                 std::cout << "LCSoftwareCompensation: Unable to find energy density of calorimeter hit" << std::endl;
             }
-            const float weight(p1*exp(p2*rho) + p3);
             const float correctedHitEnergy(hitEnergy*weight);
             energySoftComp += correctedHitEnergy;
         }	
@@ -184,14 +242,12 @@ StatusCode LCSoftwareCompensation::SoftComp(float clusterEnergyEstimation, const
         }
     }
 
-    energyCorrection = energySoftComp;
-
     return STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-StatusCode LCSoftwareCompensation::FindDensity(const pandora::CaloHit *const pCaloHit, float &energyDensity) const
+StatusCode LCSoftwareCompensation::FindDensityBin(const pandora::CaloHit *const pCaloHit, unsigned int &densityBin) const
 {
     const float mm3Todm3 = 1e-6f;    // ATTN: Cell energy density defined in GeV per dm3 but Pandora cell size defined in mm, so needs conversion
     const float cellVolume = pCaloHit->GetCellSize0() * pCaloHit->GetCellSize1() * pCaloHit->GetCellThickness() * mm3Todm3;
@@ -206,25 +262,18 @@ StatusCode LCSoftwareCompensation::FindDensity(const pandora::CaloHit *const pCa
 
     if (hitEnergyDensity >= m_softCompEnergyDensityBins.back())
     {
-        energyDensity = m_energyDensityFinalBin;
+        densityBin = m_binnedEnergyDensities.size() - 1;
         return STATUS_CODE_SUCCESS;
     }
-    else
+    else if (hitEnergyDensity >= m_softCompEnergyDensityBins.front())
     {
-        for (unsigned int iBin = 0; iBin < m_softCompEnergyDensityBins.size() - 1; iBin++)
-        {
-            const float lowBinContent = m_softCompEnergyDensityBins.at(iBin);
-            const float highBinContent = m_softCompEnergyDensityBins.at(iBin+1);
-
-            if (hitEnergyDensity >= lowBinContent && hitEnergyDensity < highBinContent)
-            {
-                energyDensity = (lowBinContent + highBinContent) * 0.5f;
-                return STATUS_CODE_SUCCESS;
-            }
-        }
+        // Bin edges are strictly increasing, so the first bin edge above the density is the upper edge of its bin
+        const FloatVector::const_iterator upperIter(std::upper_bound(m_softCompEnergyDensityBins.begin(), m_softCompEnergyDensityBins.end(), hitEnergyDensity));
+        densityBin = (upperIter - m_softCompEnergyDensityBins.begin()) - 1;
+        return STATUS_CODE_SUCCESS;
     }
 
-    std::cout << "LCSoftwareCompensation::FindDensity - EnergyDensity binning inconsistency" << std::endl;
+    std::cout << "LCSoftwareCompensation::FindDensityBin - EnergyDensity binning inconsistency" << std::endl;
 
     return STATUS_CODE_FAILURE;
 }
@@ -233,6 +282,16 @@ StatusCode LCSoftwareCompensation::FindDensity(const pandora::CaloHit *const pCa
 
 StatusCode LCSoftwareCompensation::ReadSettings(const TiXmlHandle /*xmlHandle*/)
 {
+    // The density bin search requires strictly increasing bin edges
+    for (unsigned int iBin = 1; iBin < m_softCompEnergyDensityBins.size(); ++iBin)
+    {
+        if (!(m_softCompEnergyDensityBins.at(iBin - 1) < m_softCompEnergyDensityBins.at(iBin)))
+        {
+            std::cout << "LCSoftwareCompensation::ReadSettings - Input density bins must be strictly increasing" << std::endl;
+            return STATUS_CODE_INVALID_PARAMETER;
+        }
+    }
+
     return STATUS_CODE_SUCCESS;
 }
 
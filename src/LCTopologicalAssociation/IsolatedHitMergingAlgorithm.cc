@@ -12,6 +12,8 @@
 
 #include "LCTopologicalAssociation/IsolatedHitMergingAlgorithm.h"
 
+#include "LCUtility/KDTreeLinkerAlgoT.h"
+
 #include <algorithm>
 
 using namespace pandora;
@@ -64,6 +66,13 @@ StatusCode IsolatedHitMergingAlgorithm::Run()
     ClusterVector clusterVector(clusterList.begin(), clusterList.end());
     std::sort(clusterVector.begin(), clusterVector.end(), SortingHelper::SortClustersByInnerLayer);
 
+    // ATTN Isolated hits do not contribute to the cluster layer centroids, so these remain valid throughout
+    std::vector<CentroidKDNode> centroidNodes;
+    CentroidKDTree centroidKDTree;
+    this->InitializeKDTree(clusterVector, centroidNodes, centroidKDTree);
+
+    KDTreeNeighbourSearchBuffer searchBuffer;
+    std::vector<CentroidKDNeighbour> nearbyCentroids;
 
     // FIRST PART - find "small" clusters, below threshold number of calo hits, delete them and associate hits with other clusters
     for (ClusterVector::iterator iterI = clusterVector.begin(), iterIEnd = clusterVector.end(); iterI != iterIEnd; ++iterI)
@@ -84,6 +93,8 @@ StatusCode IsolatedHitMergingAlgorithm::Run()
         CaloHitList caloHitList;
         pClusterToDelete->GetOrderedCaloHitList().FillCaloHitList(caloHitList);
 
+        this->EraseClusterCentroids(clusterVector, iterI - clusterVector.begin(), centroidKDTree);
+
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::Delete(*this, pClusterToDelete));
         *iterI = NULL;
 
@@ -92,32 +103,9 @@ StatusCode IsolatedHitMergingAlgorithm::Run()
         {
             const CaloHit *const pCaloHit = *hitIter;
 
-            const Cluster *pBestHostCluster(NULL);
-            float bestHostClusterEnergy(0.);
-            float minDistance(m_maxRecombinationDistance);
-
             // Find the most appropriate cluster for this newly-available hit
-            for (ClusterVector::const_iterator iterJ = clusterVector.begin(), iterJEnd = clusterVector.end(); iterJ != iterJEnd; ++iterJ)
-            {
-                const Cluster *const pNewHostCluster = *iterJ;
-
-                if (NULL == pNewHostCluster)
-                    continue;
-
-                if (pNewHostCluster->GetNCaloHits() < nCaloHits)
-                    continue;
-
-                const float distance(this->GetDistanceToHit(pNewHostCluster, pCaloHit));
-                const float hostClusterEnergy(pNewHostCluster->GetHadronicEnergy());
-
-                // In event of equidistant host candidates, choose highest energy cluster
-                if ((distance < minDistance) || ((distance == minDistance) && (hostClusterEnergy > bestHostClusterEnergy)))
-                {
-                    minDistance = distance;
-                    pBestHostCluster = pNewHostCluster;
-                    bestHostClusterEnergy = hostClusterEnergy;
-                }
-            }
+            const Cluster *const pBestHostCluster(this->FindBestHostCluster(clusterVector, centroidKDTree, pCaloHit, nCaloHits, searchBuffer,
+                nearbyCentroids));
 
             if (NULL != pBestHostCluster)
             {
@@ -138,36 +126,106 @@ StatusCode IsolatedHitMergingAlgorithm::Run()
         if (!pCaloHit->IsIsolated() || !PandoraContentApi::IsAvailable(*this, pCaloHit))
             continue;
 
-        const Cluster *pBestHostCluster(NULL);
-        float bestHostClusterEnergy(0.);
-        float minDistance(m_maxRecombinationDistance);
-
         // Find most appropriate cluster for this isolated hit
-        for (ClusterVector::const_iterator iterJ = clusterVector.begin(), iterJEnd = clusterVector.end(); iterJ != iterJEnd; ++iterJ)
+        const Cluster *const pBestHostCluster(this->FindBestHostCluster(clusterVector, centroidKDTree, pCaloHit, 0, searchBuffer, nearbyCentroids));
+
+        if (NULL != pBestHostCluster)
         {
-            const Cluster *const pCluster = *iterJ;
+            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::AddIsolatedToCluster(*this, pBestHostCluster, pCaloHit));
+        }
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
 
-            if (NULL == pCluster)
-                continue;
+//------------------------------------------------------------------------------------------------------------------------------------------
 
-            const float distance(this->GetDistanceToHit(pCluster, pCaloHit));
-            const float hostClusterEnergy(pCluster->GetHadronicEnergy());
+void IsolatedHitMergingAlgorithm::InitializeKDTree(const ClusterVector &clusterVector, std::vector<CentroidKDNode> &centroidNodes,
+    CentroidKDTree &centroidKDTree) const
+{
+    centroidKDTree.clear();
+    centroidNodes.clear();
 
-            if ((distance < minDistance) || ((distance == minDistance) && (hostClusterEnergy > bestHostClusterEnergy)))
-            {
-                minDistance = distance;
-                pBestHostCluster = pCluster;
-                bestHostClusterEnergy = hostClusterEnergy;
-            }
+    for (unsigned int index = 0; index < clusterVector.size(); ++index)
+    {
+        const Cluster *const pCluster = clusterVector.at(index);
+        const OrderedCaloHitList &orderedCaloHitList(pCluster->GetOrderedCaloHitList());
+
+        for (OrderedCaloHitList::const_iterator iter = orderedCaloHitList.begin(), iterEnd = orderedCaloHitList.end(); iter != iterEnd; ++iter)
+        {
+            const CartesianVector centroid(pCluster->GetCentroid(iter->first));
+            centroidNodes.emplace_back(index, centroid.GetX(), centroid.GetY(), centroid.GetZ());
         }
+    }
 
-        if (NULL != pBestHostCluster)
+    centroidKDTree.build(centroidNodes, bound_kd_tree_nodes(centroidNodes));
+    centroidNodes.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void IsolatedHitMergingAlgorithm::EraseClusterCentroids(const ClusterVector &clusterVector, const unsigned int clusterIndex,
+    CentroidKDTree &centroidKDTree) const
+{
+    const Cluster *const pCluster = clusterVector.at(clusterIndex);
+    const OrderedCaloHitList &orderedCaloHitList(pCluster->GetOrderedCaloHitList());
+
+    for (OrderedCaloHitList::const_iterator iter = orderedCaloHitList.begin(), iterEnd = orderedCaloHitList.end(); iter != iterEnd; ++iter)
+    {
+        const CartesianVector centroid(pCluster->GetCentroid(iter->first));
+        centroidKDTree.erase(CentroidKDNode(clusterIndex, centroid.GetX(), centroid.GetY(), centroid.GetZ()));
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const Cluster *IsolatedHitMergingAlgorithm::FindBestHostCluster(const ClusterVector &clusterVector, const CentroidKDTree &centroidKDTree,
+    const CaloHit *const pCaloHit, const unsigned int minHostCaloHits, KDTreeNeighbourSearchBuffer &searchBuffer,
+    std::vector<CentroidKDNeighbour> &nearbyCentroids) const
+{
+    // ATTN The kd-tree only nominates candidates, the host cluster being chosen using the exact comparisons below (see findNearestCandidates)
+    const float distanceTolerance(0.01f);
+
+    const CartesianVector &hitPosition(pCaloHit->GetPositionVector());
+    const CentroidKDNode searchPoint(0, hitPosition.GetX(), hitPosition.GetY(), hitPosition.GetZ());
+    const HostClusterFilter hostClusterFilter(clusterVector, pCaloHit, minHostCaloHits, m_minCosOpeningAngle);
+
+    centroidKDTree.findNearestCandidates(searchPoint, m_maxRecombinationDistance, distanceTolerance, nearbyCentroids, searchBuffer,
+        hostClusterFilter);
+
+    if (nearbyCentroids.empty())
+        return NULL;
+
+    // Consider the nominated clusters in their original order, to preserve the choice between equivalent host candidates
+    UIntVector candidateIndices;
+
+    for (const CentroidKDNeighbour &nearbyCentroid : nearbyCentroids)
+        candidateIndices.push_back(nearbyCentroid.info->data);
+
+    std::sort(candidateIndices.begin(), candidateIndices.end());
+    candidateIndices.erase(std::unique(candidateIndices.begin(), candidateIndices.end()), candidateIndices.end());
+
+    const Cluster *pBestHostCluster(NULL);
+    float bestHostClusterEnergy(0.);
+    float minDistance(m_maxRecombinationDistance);
+
+    for (const unsigned int index : candidateIndices)
+    {
+        const Cluster *const pCluster = clusterVector.at(index);
+
+        const float distance(this->GetDistanceToHit(pCluster, pCaloHit));
+        const float hostClusterEnergy(pCluster->GetHadronicEnergy());
+
+        // In event of equidistant host candidates, choose highest energy cluster
+        if ((distance < minDistance) || ((distance == minDistance) && (hostClusterEnergy > bestHostClusterEnergy)))
         {
-            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::AddIsolatedToCluster(*this, pBestHostCluster, pCaloHit));
+            minDistance = distance;
+            pBestHostCluster = pCluster;
+            bestHostClusterEnergy = hostClusterEnergy;
         }
     }
 
-    return STATUS_CODE_SUCCESS;
+    return pBestHostCluster;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -196,6 +254,35 @@ float IsolatedHitMergingAlgorithm::GetDistanceToHit(const Cluster *const pCluste
     return std::numeric_limits<float>::max();
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+IsolatedHitMergingAlgorithm::HostClusterFilter::HostClusterFilter(const ClusterVector &clusterVector, const CaloHit *const pCaloHit,
+        const unsigned int minHostCaloHits, const float minCosOpeningAngle) :
+    m_clusterVector(clusterVector),
+    m_pCaloHit(pCaloHit),
+    m_minHostCaloHits(minHostCaloHits),
+    m_minCosOpeningAngle(minCosOpeningAngle)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool IsolatedHitMergingAlgorithm::HostClusterFilter::operator()(const CentroidKDNode &centroidNode) const
+{
+    const Cluster *const pCluster = m_clusterVector.at(centroidNode.data);
+
+    if (NULL == pCluster)
+        return false;
+
+    if (pCluster->GetNCaloHits() < m_minHostCaloHits)
+        return false;
+
+    // Same preselection as GetDistanceToHit, which would otherwise reject the cluster
+    return !(m_pCaloHit->GetExpectedDirection().GetCosOpeningAngle(pCluster->GetInitialDirection()) < m_minCosOpeningAngle);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 StatusCode IsolatedHitMergingAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
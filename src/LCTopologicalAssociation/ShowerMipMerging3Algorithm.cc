@@ -93,7 +93,7 @@ StatusCode ShowerMipMerging3Algorithm::Run()
                 continue;
 
             // Cluster approach is the smallest distance between a hit in daughter cluster and a hit in parent cluster
-            const float clusterApproach(ClusterHelper::GetDistanceToClosestHit(pDaughterCluster, pParentCluster));
+            const float clusterApproach(ClusterHelper::GetDistanceToClosestHit(pDaughterCluster, pParentCluster, m_maxClusterApproach));
 
             if (clusterApproach > m_maxClusterApproach)
                 continue;
@@ -13,7 +13,7 @@
 
 #include "LCTopologicalAssociation/SoftClusterMergingAlgorithm.h"
 
-#include "LCUtility/KDTreeLinkerAlgoT.h"
+#include "LCUtility/CaloHitSpatialIndex.h"
 #include "LCUtility/QuickUnion.h"
 
 #include <algorithm>
@@ -40,9 +40,8 @@ SoftClusterMergingAlgorithm::SoftClusterMergingAlgorithm() :
     m_innerLayerCut2(40),
     m_maxClusterDistanceFine(100.f),
     m_maxClusterDistanceCoarse(250.f),
-    m_hitsToHitsCacheMap(new HitsToHitsCacheMap),
-    m_hitNodes3D(new std::vector<HitKDNode3D>),
-    m_hitsKdTree3D(new HitKDTree3D)
+    m_hitSearchDistanceMap(new HitToSearchDistanceMap),
+    m_pQuickUnion(new QuickUnion(0))
 {
 }
 
@@ -50,9 +49,8 @@ SoftClusterMergingAlgorithm::SoftClusterMergingAlgorithm() :
 
 SoftClusterMergingAlgorithm::~SoftClusterMergingAlgorithm()
 {
-    delete m_hitsToHitsCacheMap;
-    delete m_hitNodes3D;
-    delete m_hitsKdTree3D;
+    delete m_hitSearchDistanceMap;
+    delete m_pQuickUnion;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -65,7 +63,8 @@ StatusCode SoftClusterMergingAlgorithm::Run()
 
     ClusterVector clusterVector(clusterList.begin(), clusterList.end());
     std::sort(clusterVector.begin(), clusterVector.end(), lc_content::SortingHelper::SortClustersByInnerLayer);
-    QuickUnion quickUnion(clusterVector.size());
+    QuickUnion &quickUnion(*m_pQuickUnion);
+    quickUnion.Reset(clusterVector.size());
 
     CaloHitList fullCaloHitList;
     HitToClusterMap hitToClusterMap;
@@ -94,6 +93,7 @@ StatusCode SoftClusterMergingAlgorithm::Run()
         }
     }
 
+    m_spHitsSpatialIndex.reset();
     return STATUS_CODE_SUCCESS;
 }
 
@@ -155,12 +155,28 @@ void SoftClusterMergingAlgorithm::GetInputCaloHits(const ClusterVector &clusterV
 
 void SoftClusterMergingAlgorithm::InitializeKDTree(const CaloHitList *const pCaloHitList) 
 {
-    m_hitsToHitsCacheMap->clear();
-    m_hitsKdTree3D->clear();
-    m_hitNodes3D->clear();
-    KDTreeCube hitsBoundingRegion3D = fill_and_bound_3d_kd_tree(this, *pCaloHitList, *m_hitNodes3D, true);
-    m_hitsKdTree3D->build(*m_hitNodes3D, hitsBoundingRegion3D);
-    m_hitNodes3D->clear();
+    m_hitSearchDistanceMap->clear();
+    m_spHitsSpatialIndex.reset();
+
+    // Use the shared spatial index of the current calo hits if it contains all the input hits, only these being used from hit searches
+    const CaloHitList *pCurrentCaloHitList = nullptr;
+
+    if (STATUS_CODE_SUCCESS == PandoraContentApi::GetCurrentList(*this, pCurrentCaloHitList))
+    {
+        m_spHitsSpatialIndex = CaloHitSpatialIndex::GetSharedIndex(*this, *pCurrentCaloHitList);
+
+        for (const CaloHit *const pCaloHit : *pCaloHitList)
+        {
+            if (!m_spHitsSpatialIndex->IsIndexed(pCaloHit))
+            {
+                m_spHitsSpatialIndex.reset();
+                break;
+            }
+        }
+    }
+
+    if (!m_spHitsSpatialIndex)
+        m_spHitsSpatialIndex = std::make_shared<const CaloHitSpatialIndex>(*pCaloHitList);
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -206,57 +222,51 @@ bool SoftClusterMergingAlgorithm::IsSoftCluster(const Cluster *const pDaughterCl
 int SoftClusterMergingAlgorithm::FindBestParentCluster(const ClusterVector &clusterVector, const HitToClusterMap &hitToClusterMap,
     QuickUnion &quickUnion, const Cluster *const pDaughterCluster, const CaloHitList &daughterHits, float &closestDistance) const
 {
+    // ATTN The kd-tree only nominates candidate parent hits, the best parent being chosen using the exact comparisons below (see
+    // findNearestCandidates)
+    const float distanceTolerance(0.01f);
+
     int bestParentIndex(-1);
     closestDistance = std::numeric_limits<float>::max();
 
-    const float searchDistance((PandoraContentApi::GetGeometry(*this)->GetHitTypeGranularity(pDaughterCluster->GetOuterLayerHitType()) <= FINE) ?
+    const float daughterSearchDistance((PandoraContentApi::GetGeometry(*this)->GetHitTypeGranularity(pDaughterCluster->GetOuterLayerHitType()) <= FINE) ?
         m_maxClusterDistanceFine : m_maxClusterDistanceCoarse);
 
     float bestParentClusterEnergy(0.);
     float minDistanceSquared(std::numeric_limits<float>::max());
 
+    const CaloHitSet daughterHitSet(daughterHits.begin(), daughterHits.end());
+    const HitKDTree3D &hitsKdTree3D(m_spHitsSpatialIndex->GetKDTree3D());
+    KDTreeNeighbourSearchBuffer searchBuffer;
+    std::vector<HitKDNeighbour3D> nearbyHits;
+    CaloHitVector candidateHits;
+
     for (const CaloHit *const pCaloHitI : daughterHits)
     {
+        // ATTN Hits are always searched using the distance applied when they were first examined, as part of an earlier daughter
+        const float searchDistance(m_hitSearchDistanceMap->insert(HitToSearchDistanceMap::value_type(pCaloHitI, daughterSearchDistance)).first->second);
+
         const CartesianVector &positionVectorI(pCaloHitI->GetPositionVector());
-        CaloHitList nearby_hits;
+        const HitKDNode3D searchPoint(pCaloHitI, positionVectorI.GetX(), positionVectorI.GetY(), positionVectorI.GetZ());
+        const KDTreeCube searchRegionHits(build_3d_kd_search_region(pCaloHitI, searchDistance, searchDistance, searchDistance));
+        const ParentHitFilter parentHitFilter(searchRegionHits, daughterHitSet, clusterVector, hitToClusterMap, quickUnion, m_minClusterHadEnergy,
+            m_maxHitsInSoftCluster);
 
-        if (m_hitsToHitsCacheMap->count(pCaloHitI))
-        {
-            const auto range = m_hitsToHitsCacheMap->equal_range(pCaloHitI);
+        hitsKdTree3D.findNearestCandidates(searchPoint, std::sqrt(3.f) * searchDistance, distanceTolerance, nearbyHits, searchBuffer,
+            parentHitFilter);
 
-            for (auto rangeIter = range.first; rangeIter != range.second; ++rangeIter)
-                nearby_hits.push_back(rangeIter->second);
-        }
-        else
-        {
-            KDTreeCube searchRegionHits = build_3d_kd_search_region(pCaloHitI, searchDistance, searchDistance, searchDistance);
-            std::vector<HitKDNode3D> found;
-            m_hitsKdTree3D->search(searchRegionHits, found);
+        candidateHits.clear();
 
-            for (const auto &hit : found)
-            {
-                m_hitsToHitsCacheMap->emplace(pCaloHitI, hit.data);
-                nearby_hits.push_back(hit.data);
-            }
-        }
+        for (const HitKDNeighbour3D &nearbyHit : nearbyHits)
+            candidateHits.push_back(nearbyHit.info->data);
 
-        nearby_hits.sort(PointerLessThan<CaloHit>());
+        std::sort(candidateHits.begin(), candidateHits.end(), PointerLessThan<CaloHit>());
 
-        for (const CaloHit *const pCaloHitJ : nearby_hits)
+        for (const CaloHit *const pCaloHitJ : candidateHits)
         {
-            if (daughterHits.end() != std::find(daughterHits.begin(), daughterHits.end(), pCaloHitJ))
-                continue;
-
             const int parentIndex(static_cast<int>(quickUnion.Find(hitToClusterMap.at(pCaloHitJ))));
             const Cluster *const pClusterJ = clusterVector.at(parentIndex);
             const float clusterEnergyJ(pClusterJ->GetHadronicEnergy());
-
-            if (clusterEnergyJ < m_minClusterHadEnergy)
-                continue;
-
-            if (pClusterJ->GetNCaloHits() <= m_maxHitsInSoftCluster)
-                continue;
-
             const float distanceSquared((positionVectorI - pCaloHitJ->GetPositionVector()).GetMagnitudeSquared());
 
             if ((distanceSquared < minDistanceSquared) || ((distanceSquared == minDistanceSquared) && (clusterEnergyJ > bestParentClusterEnergy)))
@@ -334,6 +344,46 @@ StatusCode SoftClusterMergingAlgorithm::GetClusterListName(const Cluster *const
     return STATUS_CODE_NOT_FOUND;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+SoftClusterMergingAlgorithm::ParentHitFilter::ParentHitFilter(const KDTreeCube &searchRegion, const CaloHitSet &daughterHits,
+        const ClusterVector &clusterVector, const HitToClusterMap &hitToClusterMap, const QuickUnion &quickUnion,
+        const float minClusterHadEnergy, const unsigned int maxHitsInSoftCluster) :
+    m_searchRegion(searchRegion),
+    m_daughterHits(daughterHits),
+    m_clusterVector(clusterVector),
+    m_hitToClusterMap(hitToClusterMap),
+    m_quickUnion(quickUnion),
+    m_minClusterHadEnergy(minClusterHadEnergy),
+    m_maxHitsInSoftCluster(maxHitsInSoftCluster)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool SoftClusterMergingAlgorithm::ParentHitFilter::operator()(const HitKDNode3D &hitNode) const
+{
+    for (unsigned int i = 0; i < 3; ++i)
+    {
+        if ((hitNode.dims[i] < m_searchRegion.dimmin[i]) || (hitNode.dims[i] > m_searchRegion.dimmax[i]))
+            return false;
+    }
+
+    const HitToClusterMap::const_iterator clusterIter(m_hitToClusterMap.find(hitNode.data));
+
+    if ((m_hitToClusterMap.end() == clusterIter) || m_daughterHits.count(hitNode.data))
+        return false;
+
+    const Cluster *const pClusterJ = m_clusterVector.at(m_quickUnion.FindTarget(clusterIter->second));
+
+    if (pClusterJ->GetHadronicEnergy() < m_minClusterHadEnergy)
+        return false;
+
+    return (pClusterJ->GetNCaloHits() > m_maxHitsInSoftCluster);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 StatusCode SoftClusterMergingAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
@@ -13,30 +13,15 @@
 
 #include "LCTrackClusterAssociation/TrackClusterAssociationAlgorithm.h"
 
-#include "LCUtility/KDTreeLinkerAlgoT.h"
+#include "LCUtility/CaloHitSpatialIndex.h"
+#include "LCUtility/ParallelFor.h"
+#include "LCUtility/TrackProjectionIndex.h"
 
-#include "LCObjects/LCTrack.h"
+#include <algorithm>
+#include <functional>
 
 using namespace pandora;
 
-// setup templates for tracking track:pseudolayer pair
-namespace std
-{
-    template<>
-    struct hash<std::pair<const pandora::Track*,unsigned> >
-    {
-        std::size_t operator()(std::pair<const pandora::Track*,unsigned> const& tps) const 
-        {
-            std::size_t h1 = std::hash<const pandora::Track*>()(tps.first);
-            std::size_t h2 = std::hash<unsigned>()(tps.second);
-            return h1 ^ (h2 << 1);
-        }
-    };
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-//------------------------------------------------------------------------------------------------------------------------------------------
-
 namespace lc_content
 {
 
@@ -45,12 +30,22 @@ TrackClusterAssociationAlgorithm::TrackClusterAssociationAlgorithm() :
     m_maxTrackClusterDistance(10.f),
     m_maxSearchLayer(9),
     m_parallelDistanceCut(100.f),
-    m_minTrackClusterCosAngle(0.f)
+    m_minTrackClusterCosAngle(0.f),
+    m_nThreads(1),
+    m_minTracksPerThread(20),
+    m_pParallelFor(NULL)
 {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+TrackClusterAssociationAlgorithm::~TrackClusterAssociationAlgorithm()
+{
+    delete m_pParallelFor;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode TrackClusterAssociationAlgorithm::Run()
 {
     const TrackList *pTrackList = nullptr;
@@ -65,13 +60,21 @@ StatusCode TrackClusterAssociationAlgorithm::Run()
     // Clear any existing track - cluster associations
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::RemoveCurrentTrackClusterAssociations(*this));
 
-    HitKDTree hits_kdtree;
-    std::vector<HitKDNode> hit_nodes;
+    // use the shared spatial index of the current calo hits, only hits in the input clusters being used from the hit searches. The index
+    // is held until the end of the event, as the algorithm is typically run many times per event, on the same hits, by reclustering
+    const CaloHitList *pCaloHitList = nullptr;
+    m_spHitsSpatialIndex.reset();
+
+    if (STATUS_CODE_SUCCESS == PandoraContentApi::GetCurrentList(*this, pCaloHitList))
+        m_spHitsSpatialIndex = CaloHitSpatialIndex::GetSharedIndex(*this, *pCaloHitList);
+
+    std::shared_ptr<const CaloHitSpatialIndex> spHitsSpatialIndex(m_spHitsSpatialIndex);
+
+    bool areAllHitsIndexed(nullptr != spHitsSpatialIndex);
     CaloHitList hit_list, clusterHits;
-    TracksToHitsInPseudoLayerMap tracks_to_hits;
     HitsToClustersMap hits_to_clusters;
 
-    // build the kd-tree of hits from the input clusters and save the map of hits to clusters
+    // save the map of hits to clusters
     for (const Cluster *const pCluster : *pClusterList)
     {
         pCluster->GetOrderedCaloHitList().FillCaloHitList(clusterHits);
@@ -80,20 +83,33 @@ StatusCode TrackClusterAssociationAlgorithm::Run()
         {
             hit_list.push_back(pCaloHit);
             hits_to_clusters.emplace(pCaloHit, pCluster);
+            areAllHitsIndexed = areAllHitsIndexed && spHitsSpatialIndex->IsIndexed(pCaloHit);
         }
         clusterHits.clear();
     }
 
-    KDTreeTesseract hitsBoundingRegion = fill_and_bound_4d_kd_tree(this, hit_list, hit_nodes, true);
+    // otherwise build a private index of the hits from the input clusters
+    if (!areAllHitsIndexed)
+        spHitsSpatialIndex = std::make_shared<const CaloHitSpatialIndex>(hit_list);
+
     hit_list.clear();
-    hits_kdtree.build(hit_nodes,hitsBoundingRegion);
-    hit_nodes.clear();
+    const HitKDTree &hits_kdtree(spHitsSpatialIndex->GetKDTree4D());
+
+    // the track states to project, shared by all runs of the algorithm for the same track list in an event
+    m_spTrackProjectionIndex = TrackProjectionIndex::GetSharedIndex(*this, *pTrackList);
+    const TrackProjectionIndex &trackProjectionIndex(*m_spTrackProjectionIndex);
 
     // move result caches out of the loop
     ClusterSet nearby_clusters;
     std::vector<HitKDNode> found_hits;
+    std::vector<ClusterVector> layer_clusters(m_maxSearchLayer + 1);
+    std::vector<bool> is_layer_search_pending(m_maxSearchLayer + 1, true);
+
+    // Collect the nearby clusters for each track state, serially, so the candidate order is independent of the number of threads
+    TrackCandidatesVector trackCandidatesVector;
+    ClusterHitPositionsVector clusterHitPositionsVector;
+    ClusterToIndexMap clusterToIndexMap;
 
-    // Look to make new associations
     for (const Track *const pTrack : trackVector)
     {
         // Use only tracks that can be used to form a pfo
@@ -103,133 +119,222 @@ StatusCode TrackClusterAssociationAlgorithm::Run()
         if (!pTrack->GetDaughterList().empty())
             continue;
 
-        const Cluster *pBestCluster = nullptr;
-        const Cluster *pBestLowEnergyCluster = nullptr;
+        trackCandidatesVector.push_back(TrackCandidates(pTrack));
+        TrackStateCandidatesVector &trackStateCandidatesVector(trackCandidatesVector.back().m_trackStateCandidates);
 
-        float minDistance(m_maxTrackClusterDistance);
-        float minLowEnergyDistance(m_maxTrackClusterDistance);
+        LCTrackStates::const_iterator trackStatesBegin, trackStatesEnd;
+        trackProjectionIndex.GetTrackStates(pTrack, trackStatesBegin, trackStatesEnd);
 
-        float minEnergyDifference(std::numeric_limits<float>::max());
-        float minLowEnergyDifference(std::numeric_limits<float>::max());
+        for (ClusterVector &clusterVector : layer_clusters)
+            clusterVector.clear();
 
-        LCTrackStates trackStates;
-        const LCTrack* lcTrack = dynamic_cast<const LCTrack*>(pTrack);
-        if( lcTrack )
-        {
-            trackStates = lcTrack->GetTrackStates();
-        }
-        else
+        for (LCTrackStates::const_iterator trackStateIter = trackStatesBegin; trackStateIter != trackStatesEnd; ++trackStateIter)
         {
-            const TrackState &trackState(pTrack->GetTrackStateAtCalorimeter());
-            trackStates.push_back( trackState );
-        }
-
-        for (auto const& trackState : trackStates)
-        {
-
+            const TrackState &trackState(*trackStateIter);
             const CartesianVector &trackPosition(trackState.GetPosition());
 
+            // nearby clusters found in a pseudo layer are kept for the later track states, so only search the layers without any
+            unsigned int minPendingLayer(std::numeric_limits<unsigned int>::max()), maxPendingLayer(0);
 
-            // short circuit this loop with a kd-tree search beforehand
-            // iterating over a std::map is expensive, avoid where possible
             for (unsigned iPseudoLayer = 0; iPseudoLayer <= m_maxSearchLayer; ++iPseudoLayer)
             {
-                // save the hash key since we may use it a few times
-                auto hash_key = std::make_pair(pTrack, iPseudoLayer);
-                // see if we have a cached search, otherwise do the search and cache
-                auto cached_result = tracks_to_hits.equal_range(hash_key);
-                if (cached_result.first != tracks_to_hits.end())
+                is_layer_search_pending[iPseudoLayer] = layer_clusters[iPseudoLayer].empty();
+
+                if (is_layer_search_pending[iPseudoLayer])
                 {
-                    for (auto iter = cached_result.first; iter != cached_result.second; ++iter )
-                    {
-                        // build a list of nearby clusters
-                        nearby_clusters.insert(hits_to_clusters.find(iter->second)->second);
-                    }
+                    minPendingLayer = std::min(minPendingLayer, iPseudoLayer);
+                    maxPendingLayer = iPseudoLayer;
                 }
-                else
+            }
+
+            // short circuit this loop with a single kd-tree search, spanning all pending pseudo layers, beforehand
+            if (minPendingLayer <= maxPendingLayer)
+            {
+                KDTreeTesseract searchRegionHits = build_4d_kd_search_region(trackPosition, m_parallelDistanceCut, m_parallelDistanceCut, m_parallelDistanceCut, minPendingLayer);
+                searchRegionHits.dimmax[3] = static_cast<float>(maxPendingLayer) + 0.5f;
+                hits_kdtree.search(searchRegionHits, found_hits);
+
+                for (const auto &hit : found_hits)
                 {
-                    // do search and cache result
-                    KDTreeTesseract searchRegionHits = build_4d_kd_search_region(trackPosition, m_parallelDistanceCut, m_parallelDistanceCut, m_parallelDistanceCut, iPseudoLayer);
-                    hits_kdtree.search(searchRegionHits, found_hits);
+                    const unsigned int hitPseudoLayer(static_cast<unsigned int>(hit.dims[3]));
+
+                    if ((hitPseudoLayer > m_maxSearchLayer) || !is_layer_search_pending[hitPseudoLayer])
+                        continue;
 
-                    for (const auto &hit : found_hits)
+                    auto assc_cluster = hits_to_clusters.find(hit.data);
+                    if (assc_cluster != hits_to_clusters.end())
                     {
-                        auto assc_cluster = hits_to_clusters.find(hit.data);
-                        if (assc_cluster != hits_to_clusters.end())
-                        {
-                            // cache all hits that are nearby the track
-                            tracks_to_hits.emplace(hash_key,hit.data);
-                            // add to the list of nearby clusters
-                            nearby_clusters.insert(assc_cluster->second);
-                        }
+                        // cache the clusters nearby the track in each layer
+                        layer_clusters[hitPseudoLayer].push_back(assc_cluster->second);
                     }
-                    found_hits.clear();
                 }
+                found_hits.clear();
             }
 
+            // build a list of nearby clusters
+            for (const ClusterVector &clusterVector : layer_clusters)
+                nearby_clusters.insert(clusterVector.begin(), clusterVector.end());
+
             ClusterList nearbyClusterList(nearby_clusters.begin(), nearby_clusters.end());
             nearbyClusterList.sort(SortingHelper::SortClustersByNHits);
             nearby_clusters.clear();
 
-            // Identify the closest cluster and also the closest cluster below a specified hadronic energy threshold
+            // copy the inner hit positions of each nearby cluster once, for all the track states for which it is to be scored
+            trackStateCandidatesVector.push_back(TrackStateCandidates(&trackState, UIntVector()));
+            UIntVector &clusterIndices(trackStateCandidatesVector.back().second);
+
             for (const Cluster *const pCluster : nearbyClusterList)
             {
-                if (0 == pCluster->GetNCaloHits())
-                    continue;
+                const auto insertResult(clusterToIndexMap.emplace(pCluster, clusterHitPositionsVector.size()));
 
-                float trackClusterDistance(std::numeric_limits<float>::max());
-                if (STATUS_CODE_SUCCESS != lc_content::ClusterHelper::GetTrackClusterDistance(&trackState, pCluster, m_maxSearchLayer, m_parallelDistanceCut,
-                    m_minTrackClusterCosAngle, trackClusterDistance))
-                {
-                    continue;
-                }
+                if (insertResult.second)
+                    clusterHitPositionsVector.push_back(ClusterHitPositions(pCluster, m_maxSearchLayer));
 
-                const float energyDifference(std::fabs(pCluster->GetHadronicEnergy() - pTrack->GetEnergyAtDca()));
-
-                if (pCluster->GetHadronicEnergy() > m_lowEnergyCut)
-                {
-                    if ((trackClusterDistance < minDistance) || ((trackClusterDistance == minDistance) && (energyDifference < minEnergyDifference)))
-                    {
-                        minDistance = trackClusterDistance;
-                        pBestCluster = pCluster;
-                        minEnergyDifference = energyDifference;
-                    }
-                }
-                else
-                {
-                    if ((trackClusterDistance < minLowEnergyDistance) || ((trackClusterDistance == minLowEnergyDistance) && (energyDifference < minLowEnergyDifference)))
-                    {
-                        minLowEnergyDistance = trackClusterDistance;
-                        pBestLowEnergyCluster = pCluster;
-                        minLowEnergyDifference = energyDifference;
-                    }
-                }
-            } // for all clusters
+                clusterIndices.push_back(insertResult.first->second);
+            }
         } //for all trackStates
+    } //for all tracks
 
-        // Apply a final track-cluster association distance cut
-        const Cluster *pMatchedCluster = nullptr;
+    // Score the candidates, each track independently of all others
+    ClusterVector matchedClusters;
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetMatchedClusters(clusterHitPositionsVector, trackCandidatesVector, matchedClusters));
 
-        if (nullptr != pBestCluster)
-        {
-            pMatchedCluster = pBestCluster;
-        }
-        else if (nullptr != pBestLowEnergyCluster)
+    // Now make the associations, serially and in track order
+    for (unsigned int iTrack = 0, nTracks = trackCandidatesVector.size(); iTrack < nTracks; ++iTrack)
+    {
+        const Cluster *const pMatchedCluster(matchedClusters.at(iTrack));
+
+        if (nullptr != pMatchedCluster)
         {
-            pMatchedCluster = pBestLowEnergyCluster;
+            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::AddTrackClusterAssociation(*this, trackCandidatesVector.at(iTrack).m_pTrack, pMatchedCluster));
         }
+    }
 
-        // Now make the association
-        if (nullptr != pMatchedCluster)
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode TrackClusterAssociationAlgorithm::Reset()
+{
+    m_spHitsSpatialIndex.reset();
+    m_spTrackProjectionIndex.reset();
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode TrackClusterAssociationAlgorithm::GetMatchedClusters(const ClusterHitPositionsVector &clusterHitPositionsVector,
+    const TrackCandidatesVector &trackCandidatesVector, ClusterVector &matchedClusters) const
+{
+    const unsigned int nTracks(trackCandidatesVector.size());
+    const unsigned int nThreads(ParallelFor::GetNThreads(nTracks, m_nThreads, m_minTracksPerThread));
+
+    if (nThreads > 1)
+    {
+        // ATTN The track-cluster distance cuts on the angle to the cluster initial direction, fitted on first access, so fit it here, serially.
+        // The hit positions are copies, so no other cluster property is read
+        for (const ClusterHitPositions &clusterHitPositions : clusterHitPositionsVector)
         {
-            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::AddTrackClusterAssociation(*this, pTrack, pMatchedCluster));
+            if (clusterHitPositions.GetCluster()->GetNCaloHits() > 0)
+                (void) clusterHitPositions.GetCluster()->GetInitialDirection();
         }
-    } //for all tracks
+    }
+
+    // Each track is scored only against its own candidates, so contiguous ranges of tracks can be shared between threads
+    matchedClusters.assign(nTracks, nullptr);
+    m_pParallelFor->Run(nTracks, nThreads, std::bind(&TrackClusterAssociationAlgorithm::CalculateMatchedClusters, this,
+        std::cref(clusterHitPositionsVector), std::cref(trackCandidatesVector), std::placeholders::_1, std::placeholders::_2,
+        std::ref(matchedClusters)));
+
     return STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+void TrackClusterAssociationAlgorithm::CalculateMatchedClusters(const ClusterHitPositionsVector &clusterHitPositionsVector,
+    const TrackCandidatesVector &trackCandidatesVector, const unsigned int firstTrackIndex, const unsigned int endTrackIndex,
+    ClusterVector &matchedClusters) const
+{
+    for (unsigned int iTrack = firstTrackIndex; iTrack < endTrackIndex; ++iTrack)
+        matchedClusters.at(iTrack) = this->GetMatchedCluster(clusterHitPositionsVector, trackCandidatesVector.at(iTrack));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const Cluster *TrackClusterAssociationAlgorithm::GetMatchedCluster(const ClusterHitPositionsVector &clusterHitPositionsVector,
+    const TrackCandidates &trackCandidates) const
+{
+    const Track *const pTrack(trackCandidates.m_pTrack);
+
+    const Cluster *pBestCluster = nullptr;
+    const Cluster *pBestLowEnergyCluster = nullptr;
+
+    float minDistance(m_maxTrackClusterDistance);
+    float minLowEnergyDistance(m_maxTrackClusterDistance);
+
+    float minEnergyDifference(std::numeric_limits<float>::max());
+    float minLowEnergyDifference(std::numeric_limits<float>::max());
+
+    for (const TrackStateCandidates &trackStateCandidates : trackCandidates.m_trackStateCandidates)
+    {
+        // Identify the closest cluster and also the closest cluster below a specified hadronic energy threshold
+        for (const unsigned int clusterIndex : trackStateCandidates.second)
+        {
+            const ClusterHitPositions &clusterHitPositions(clusterHitPositionsVector.at(clusterIndex));
+            const Cluster *const pCluster(clusterHitPositions.GetCluster());
+
+            if (0 == pCluster->GetNCaloHits())
+                continue;
+
+            float trackClusterDistance(std::numeric_limits<float>::max());
+            if (STATUS_CODE_SUCCESS != lc_content::ClusterHelper::GetTrackClusterDistance(trackStateCandidates.first, clusterHitPositions, m_maxSearchLayer,
+                m_parallelDistanceCut, m_minTrackClusterCosAngle, trackClusterDistance))
+            {
+                continue;
+            }
+
+            const float energyDifference(std::fabs(pCluster->GetHadronicEnergy() - pTrack->GetEnergyAtDca()));
+
+            if (pCluster->GetHadronicEnergy() > m_lowEnergyCut)
+            {
+                if ((trackClusterDistance < minDistance) || ((trackClusterDistance == minDistance) && (energyDifference < minEnergyDifference)))
+                {
+                    minDistance = trackClusterDistance;
+                    pBestCluster = pCluster;
+                    minEnergyDifference = energyDifference;
+                }
+            }
+            else
+            {
+                if ((trackClusterDistance < minLowEnergyDistance) || ((trackClusterDistance == minLowEnergyDistance) && (energyDifference < minLowEnergyDifference)))
+                {
+                    minLowEnergyDistance = trackClusterDistance;
+                    pBestLowEnergyCluster = pCluster;
+                    minLowEnergyDifference = energyDifference;
+                }
+            }
+        } // for all clusters
+    } //for all trackStates
+
+    // Apply a final track-cluster association distance cut
+    if (nullptr != pBestCluster)
+        return pBestCluster;
+
+    return pBestLowEnergyCluster;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+TrackClusterAssociationAlgorithm::TrackCandidates::TrackCandidates(const Track *const pTrack) :
+    m_pTrack(pTrack)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode TrackClusterAssociationAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
 {
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
@@ -247,6 +352,18 @@ StatusCode TrackClusterAssociationAlgorithm::ReadSettings(const TiXmlHandle xmlH
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
         "MinTrackClusterCosAngle", m_minTrackClusterCosAngle));
 
+    // Multi-threading parameters
+    PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
+        "NThreads", m_nThreads));
+
+    if (0 == m_nThreads)
+        return STATUS_CODE_INVALID_PARAMETER;
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle,
+        "MinTracksPerThread", m_minTracksPerThread));
+
+    m_pParallelFor = new ParallelFor(m_nThreads);
+
     return STATUS_CODE_SUCCESS;
 }
 
@@ -9,7 +9,7 @@
 #include "Pandora/AlgorithmHeaders.h"
 
 #include "LCUtility/CaloHitPreparationAlgorithm.h"
-#include "LCUtility/KDTreeLinkerAlgoT.h"
+#include "LCUtility/CaloHitSpatialIndex.h"
 
 using namespace pandora;
 
@@ -26,22 +26,12 @@ CaloHitPreparationAlgorithm::CaloHitPreparationAlgorithm() :
     m_isolationMaxNearbyHits(2),
     m_mipLikeMipCut(5.f),
     m_mipNCellsForNearbyHit(2),
-    m_mipMaxNearbyHits(1),
-    m_hitNodes4D(new std::vector<HitKDNode4D>),
-    m_hitsKdTree4D(new HitKDTree4D)
+    m_mipMaxNearbyHits(1)
 {
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-CaloHitPreparationAlgorithm::~CaloHitPreparationAlgorithm()
-{
-    delete m_hitNodes4D;
-    delete m_hitsKdTree4D;
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-
 StatusCode CaloHitPreparationAlgorithm::Run()
 {
     try
@@ -49,7 +39,7 @@ StatusCode CaloHitPreparationAlgorithm::Run()
         const CaloHitList *pCaloHitList(NULL);
         PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetCurrentList(*this, pCaloHitList));
 
-        this->InitializeKDTree(pCaloHitList);
+        m_spSpatialIndex = CaloHitSpatialIndex::GetSharedIndex(*this, *pCaloHitList);
 
         OrderedCaloHitList orderedCaloHitList;
         PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, orderedCaloHitList.Add(*pCaloHitList));
@@ -64,6 +54,7 @@ StatusCode CaloHitPreparationAlgorithm::Run()
     }
     catch (StatusCodeException &statusCodeException)
     {
+        m_spSpatialIndex.reset();
         std::cout << "CaloHitPreparationAlgorithm: Failed to calculate calo hit properties, " << statusCodeException.ToString() << std::endl;
         return statusCodeException.GetStatusCode();
     }
@@ -73,13 +64,11 @@ StatusCode CaloHitPreparationAlgorithm::Run()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void CaloHitPreparationAlgorithm::InitializeKDTree(const CaloHitList *const pCaloHitList) 
+StatusCode CaloHitPreparationAlgorithm::Reset()
 {
-    m_hitsKdTree4D->clear();
-    m_hitNodes4D->clear();
-    KDTreeTesseract hitsBoundingRegion4D = fill_and_bound_4d_kd_tree(this, *pCaloHitList, *m_hitNodes4D, true);
-    m_hitsKdTree4D->build(*m_hitNodes4D, hitsBoundingRegion4D);
-    m_hitNodes4D->clear();
+    // Hold the shared spatial index until the end of the event, for use by later algorithms, but never beyond the hits it indexes
+    m_spSpatialIndex.reset();
+    return STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -165,7 +154,7 @@ unsigned int CaloHitPreparationAlgorithm::IsolationCountNearbyHits(unsigned int
     KDTreeTesseract searchRegionHits = build_4d_kd_search_region(pCaloHit, searchDistance, searchDistance, searchDistance, searchLayer);
 
     std::vector<HitKDNode4D> found;
-    m_hitsKdTree4D->search(searchRegionHits, found);
+    m_spSpatialIndex->GetKDTree4D().search(searchRegionHits, found);
 
     for (const auto &hit : found)
     {
@@ -206,7 +195,7 @@ unsigned int CaloHitPreparationAlgorithm::MipCountNearbyHits(unsigned int search
     KDTreeTesseract searchRegionHits = build_4d_kd_search_region(pCaloHit, searchDistance, searchDistance, searchDistance, searchLayer);
 
     std::vector<HitKDNode4D> found;
-    m_hitsKdTree4D->search(searchRegionHits, found);
+    m_spSpatialIndex->GetKDTree4D().search(searchRegionHits, found);
 
     for (const auto &hit : found)
     {
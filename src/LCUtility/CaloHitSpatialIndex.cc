@@ -0,0 +1,63 @@
+/**
+ *  @file   LCContent/src/LCUtility/CaloHitSpatialIndex.cc
+ * 
+ *  @brief  Implementation of the calo hit spatial index class.
+ * 
+ *  $Log: $
+ */
+
+#include "Pandora/AlgorithmHeaders.h"
+
+#include "LCUtility/CaloHitSpatialIndex.h"
+#include "LCUtility/SharedIndexRegistry.h"
+
+using namespace pandora;
+
+namespace lc_content
+{
+
+std::shared_ptr<const CaloHitSpatialIndex> CaloHitSpatialIndex::GetSharedIndex(const Algorithm &algorithm, const CaloHitList &caloHitList)
+{
+    return SharedIndexRegistry<CaloHitSpatialIndex, CaloHitList>::GetIndex(algorithm.GetPandora(), caloHitList);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CaloHitSpatialIndex::CaloHitSpatialIndex(const CaloHitList &caloHitList) :
+    m_pCaloHitList(&caloHitList),
+    m_pFirstCaloHit(caloHitList.empty() ? nullptr : caloHitList.front()),
+    m_pLastCaloHit(caloHitList.empty() ? nullptr : caloHitList.back())
+{
+    m_listNodes.reserve(caloHitList.size());
+
+    for (const CaloHit *const pCaloHit : caloHitList)
+    {
+        const CartesianVector &position(pCaloHit->GetPositionVector());
+        m_listNodes.emplace_back(pCaloHit, position.GetX(), position.GetY(), position.GetZ(), static_cast<float>(pCaloHit->GetPseudoLayer()));
+    }
+
+    m_caloHitSet.insert(caloHitList.begin(), caloHitList.end());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CaloHitSpatialIndex::BuildKDTree3D() const
+{
+    std::vector<HitKDNode3D> hitNodes3D;
+    hitNodes3D.reserve(m_listNodes.size());
+
+    for (const HitKDNode4D &hitNode : m_listNodes)
+        hitNodes3D.emplace_back(hitNode.data, hitNode.dims[0], hitNode.dims[1], hitNode.dims[2]);
+
+    m_kdTree3D.build(hitNodes3D, bound_kd_tree_nodes(hitNodes3D));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CaloHitSpatialIndex::BuildKDTree4D() const
+{
+    std::vector<HitKDNode4D> hitNodes4D(m_listNodes);
+    m_kdTree4D.build(hitNodes4D, bound_kd_tree_nodes(hitNodes4D));
+}
+
+} // namespace lc_content
@@ -0,0 +1,87 @@
+/**
+ *  @file   LCContent/src/LCUtility/ClusterHitPositions.cc
+ * 
+ *  @brief  Implementation of the cluster hit positions class.
+ * 
+ *  $Log: $
+ */
+
+#include "Pandora/AlgorithmHeaders.h"
+
+#include "LCUtility/ClusterHitPositions.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace pandora;
+
+namespace lc_content
+{
+
+ClusterHitPositions::ClusterHitPositions(const Cluster *const pCluster, const unsigned int maxPseudoLayer) :
+    m_pCluster(pCluster),
+    m_maxPseudoLayer(maxPseudoLayer)
+{
+    const OrderedCaloHitList &orderedCaloHitList(pCluster->GetOrderedCaloHitList());
+
+    for (OrderedCaloHitList::const_iterator iter = orderedCaloHitList.begin(), iterEnd = orderedCaloHitList.end(); iter != iterEnd; ++iter)
+    {
+        if (iter->first > maxPseudoLayer)
+            break;
+
+        for (CaloHitList::const_iterator hitIter = iter->second->begin(), hitIterEnd = iter->second->end(); hitIter != hitIterEnd; ++hitIter)
+        {
+            const CartesianVector &positionVector((*hitIter)->GetPositionVector());
+            m_x.push_back(positionVector.GetX());
+            m_y.push_back(positionVector.GetY());
+            m_z.push_back(positionVector.GetZ());
+        }
+
+        m_pseudoLayers.push_back(iter->first);
+        m_layerEndIndices.push_back(m_x.size());
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool ClusterHitPositions::GetMinPerpendicularDistanceSquared(const CartesianVector &trackPosition, const CartesianVector &trackDirection,
+    const unsigned int maxSearchLayer, const float parallelDistanceCut, float &minDistanceSquared) const
+{
+    if (maxSearchLayer > m_maxPseudoLayer)
+        throw StatusCodeException(STATUS_CODE_INVALID_PARAMETER);
+
+    // Stop after the last occupied pseudo layer within the search range
+    const UIntVector::const_iterator layerIter(std::upper_bound(m_pseudoLayers.begin(), m_pseudoLayers.end(), maxSearchLayer));
+    const unsigned int nHits((m_pseudoLayers.begin() == layerIter) ? 0 : m_layerEndIndices[(layerIter - m_pseudoLayers.begin()) - 1]);
+
+    const float trackX(trackPosition.GetX()), trackY(trackPosition.GetY()), trackZ(trackPosition.GetZ());
+    const float dirX(trackDirection.GetX()), dirY(trackDirection.GetY()), dirZ(trackDirection.GetZ());
+    const float *const pX(m_x.data());
+    const float *const pY(m_y.data());
+    const float *const pZ(m_z.data());
+
+    // ATTN Branch-free, with each expression matching the corresponding CartesianVector operation, so that the result is identical to that
+    // of a hit-by-hit evaluation; a hit failing the parallel distance cut, or with an undefined distance, can never lower the minimum
+    float minValue(std::numeric_limits<float>::max());
+
+    for (unsigned int iHit = 0; iHit < nHits; ++iHit)
+    {
+        const float dx(pX[iHit] - trackX), dy(pY[iHit] - trackY), dz(pZ[iHit] - trackZ);
+        const float parallelDistance((dirX * dx) + (dirY * dy) + (dirZ * dz));
+
+        const float crossX((dirY * dz) - (dirZ * dy)), crossY((dirZ * dx) - (dirX * dz)), crossZ((dirX * dy) - (dirY * dx));
+        const float perpendicularDistanceSquared((crossX * crossX) + (crossY * crossY) + (crossZ * crossZ));
+
+        const float candidate((std::fabs(parallelDistance) > parallelDistanceCut) ? std::numeric_limits<float>::max() : perpendicularDistanceSquared);
+        minValue = (candidate < minValue) ? candidate : minValue;
+    }
+
+    if (!(minValue < std::numeric_limits<float>::max()))
+        return false;
+
+    minDistanceSquared = minValue;
+    return true;
+}
+
+} // namespace lc_content
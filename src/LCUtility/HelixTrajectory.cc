@@ -0,0 +1,103 @@
+/**
+ *  @file   LCContent/src/LCUtility/HelixTrajectory.cc
+ * 
+ *  @brief  Implementation of the helix trajectory class.
+ * 
+ *  $Log: $
+ */
+
+#include "Pandora/AlgorithmHeaders.h"
+
+#include "LCHelpers/FragmentRemovalHelper.h"
+
+#include "LCUtility/HelixTrajectory.h"
+
+#include <cmath>
+
+using namespace pandora;
+
+namespace lc_content
+{
+
+HelixTrajectory::HelixTrajectory(const Pandora &pandora, const Helix &helix) :
+    m_pandora(pandora),
+    m_helix(helix)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+unsigned int HelixTrajectory::GetNLayersCrossed(const float zStart, const float zEnd) const
+{
+    // ATTN Undefined coordinates cannot be ordered, so cannot be memoized
+    if (std::isnan(zStart) || std::isnan(zEnd))
+        return FragmentRemovalHelper::GetNLayersCrossed(m_pandora, m_helix, zStart, zEnd);
+
+    const LayersCrossedMap::key_type zRange(zStart, zEnd);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        LayersCrossedMap::const_iterator iter(m_layersCrossedMap.find(zRange));
+
+        if (m_layersCrossedMap.end() != iter)
+            return iter->second;
+    }
+
+    // Sample the helix without holding the lock; a concurrent evaluation of the same range yields the same result
+    const unsigned int nLayersCrossed(FragmentRemovalHelper::GetNLayersCrossed(m_pandora, m_helix, zStart, zEnd));
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_layersCrossedMap.insert(LayersCrossedMap::value_type(zRange, nLayersCrossed));
+
+    return nLayersCrossed;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode HelixTrajectory::GetDistancesToHits(const CaloHitList &caloHitList, FloatVector &distances) const
+{
+    distances.clear();
+    CaloHitVector missingCaloHits;
+    UIntVector missingHitIndices;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (const CaloHit *const pCaloHit : caloHitList)
+        {
+            HitToDistanceMap::const_iterator iter(m_hitToDistanceMap.find(pCaloHit));
+
+            if (m_hitToDistanceMap.end() == iter)
+            {
+                missingHitIndices.push_back(distances.size());
+                missingCaloHits.push_back(pCaloHit);
+                distances.push_back(std::numeric_limits<float>::max());
+            }
+            else
+            {
+                distances.push_back(iter->second);
+            }
+        }
+    }
+
+    if (missingCaloHits.empty())
+        return STATUS_CODE_SUCCESS;
+
+    // Evaluate the missing distances without holding the lock, stopping at the first failure as for an uncached evaluation
+    for (unsigned int iHit = 0, nHits = missingCaloHits.size(); iHit < nHits; ++iHit)
+    {
+        CartesianVector distanceVector(0.f, 0.f, 0.f);
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, m_helix.GetDistanceToPoint(missingCaloHits[iHit]->GetPositionVector(), distanceVector));
+
+        distances[missingHitIndices[iHit]] = distanceVector.GetZ();
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    for (unsigned int iHit = 0, nHits = missingCaloHits.size(); iHit < nHits; ++iHit)
+        m_hitToDistanceMap.insert(HitToDistanceMap::value_type(missingCaloHits[iHit], distances[missingHitIndices[iHit]]));
+
+    return STATUS_CODE_SUCCESS;
+}
+
+} // namespace lc_content
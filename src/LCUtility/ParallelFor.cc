@@ -0,0 +1,152 @@
+/**
+ *  @file   LCContent/src/LCUtility/ParallelFor.cc
+ * 
+ *  @brief  Implementation of the parallel for class.
+ * 
+ *  $Log: $
+ */
+
+#include "LCUtility/ParallelFor.h"
+
+#include <algorithm>
+
+namespace lc_content
+{
+
+ParallelFor::ParallelFor(const unsigned int nThreads) :
+    m_pRangeFunction(NULL),
+    m_nIndices(0),
+    m_nRanges(0),
+    m_nPendingRanges(0),
+    m_callIndex(0),
+    m_isStopping(false)
+{
+    try
+    {
+        for (unsigned int rangeIndex = 1; rangeIndex < nThreads; ++rangeIndex)
+            m_workers.push_back(std::thread(&ParallelFor::RunWorker, this, rangeIndex));
+    }
+    catch (...)
+    {
+        // ATTN A worker that cannot be started must not leave those already running unjoined
+        this->StopWorkers();
+        throw;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+ParallelFor::~ParallelFor()
+{
+    this->StopWorkers();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+unsigned int ParallelFor::GetNThreads(const unsigned int nIndices, const unsigned int maxThreads, const unsigned int minIndicesPerThread)
+{
+    const unsigned int nThreads((minIndicesPerThread > 0) ? std::min(maxThreads, nIndices / minIndicesPerThread) : maxThreads);
+
+    return std::max(1U, nThreads);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ParallelFor::RunRanges(const RangeFunction &rangeFunction, const unsigned int nIndices, const unsigned int nRanges)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pRangeFunction = &rangeFunction;
+        m_nIndices = nIndices;
+        m_nRanges = nRanges;
+        m_nPendingRanges = nRanges - 1;
+        m_exceptionPtrs.assign(nRanges, std::exception_ptr());
+        ++m_callIndex;
+    }
+
+    m_startCondition.notify_all();
+    ParallelFor::RunRange(rangeFunction, nIndices, nRanges, 0, m_exceptionPtrs.front());
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        while (m_nPendingRanges > 0)
+            m_endCondition.wait(lock);
+
+        m_pRangeFunction = NULL;
+    }
+
+    for (const std::exception_ptr &exceptionPtr : m_exceptionPtrs)
+    {
+        if (exceptionPtr)
+            std::rethrow_exception(exceptionPtr);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ParallelFor::RunWorker(const unsigned int rangeIndex)
+{
+    unsigned long lastCallIndex(0);
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        while (!m_isStopping && (lastCallIndex == m_callIndex))
+            m_startCondition.wait(lock);
+
+        if (m_isStopping)
+            return;
+
+        // ATTN A worker cannot miss a call needing its range, as each call waits for all of its ranges before returning
+        lastCallIndex = m_callIndex;
+
+        if (rangeIndex >= m_nRanges)
+            continue;
+
+        const RangeFunction &rangeFunction(*m_pRangeFunction);
+        const unsigned int nIndices(m_nIndices), nRanges(m_nRanges);
+        std::exception_ptr &exceptionPtr(m_exceptionPtrs.at(rangeIndex));
+
+        lock.unlock();
+        ParallelFor::RunRange(rangeFunction, nIndices, nRanges, rangeIndex, exceptionPtr);
+        lock.lock();
+
+        if (0 == --m_nPendingRanges)
+            m_endCondition.notify_one();
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ParallelFor::StopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+
+    m_startCondition.notify_all();
+
+    for (std::thread &worker : m_workers)
+        worker.join();
+
+    m_workers.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ParallelFor::RunRange(const RangeFunction &rangeFunction, const unsigned int nIndices, const unsigned int nRanges,
+    const unsigned int rangeIndex, std::exception_ptr &exceptionPtr)
+{
+    try
+    {
+        rangeFunction((rangeIndex * nIndices) / nRanges, ((rangeIndex + 1) * nIndices) / nRanges, rangeIndex);
+    }
+    catch (...)
+    {
+        exceptionPtr = std::current_exception();
+    }
+}
+
+} // namespace lc_content
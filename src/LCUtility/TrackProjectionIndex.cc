@@ -0,0 +1,88 @@
+/**
+ *  @file   LCContent/src/LCUtility/TrackProjectionIndex.cc
+ * 
+ *  @brief  Implementation of the track projection index class.
+ * 
+ *  $Log: $
+ */
+
+#include "Pandora/AlgorithmHeaders.h"
+
+#include "LCUtility/SharedIndexRegistry.h"
+#include "LCUtility/TrackProjectionIndex.h"
+
+using namespace pandora;
+
+namespace lc_content
+{
+
+std::shared_ptr<const TrackProjectionIndex> TrackProjectionIndex::GetSharedIndex(const Algorithm &algorithm, const TrackList &trackList)
+{
+    return SharedIndexRegistry<TrackProjectionIndex, TrackList>::GetIndex(algorithm.GetPandora(), trackList);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+TrackProjectionIndex::TrackProjectionIndex(const TrackList &trackList)
+{
+    m_tracks.reserve(trackList.size());
+    m_calorimeterPositions.reserve(trackList.size());
+    m_firstTrackStateIndices.reserve(trackList.size() + 1);
+
+    for (const Track *const pTrack : trackList)
+    {
+        const TrackState &trackStateAtCalorimeter(pTrack->GetTrackStateAtCalorimeter());
+        const LCTrack *const pLCTrack(dynamic_cast<const LCTrack*>(pTrack));
+
+        m_trackToIndexMap.emplace(pTrack, m_tracks.size());
+        m_tracks.push_back(pTrack);
+        m_calorimeterPositions.push_back(trackStateAtCalorimeter.GetPosition());
+        m_firstTrackStateIndices.push_back(m_trackStates.size());
+
+        if (pLCTrack)
+        {
+            m_trackStates.insert(m_trackStates.end(), pLCTrack->GetTrackStates().begin(), pLCTrack->GetTrackStates().end());
+        }
+        else
+        {
+            m_trackStates.push_back(trackStateAtCalorimeter);
+        }
+    }
+
+    m_firstTrackStateIndices.push_back(m_trackStates.size());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void TrackProjectionIndex::GetTrackStates(const Track *const pTrack, LCTrackStates::const_iterator &beginIter, LCTrackStates::const_iterator &endIter) const
+{
+    TrackToIndexMap::const_iterator iter(m_trackToIndexMap.find(pTrack));
+
+    if (m_trackToIndexMap.end() == iter)
+        throw StatusCodeException(STATUS_CODE_NOT_FOUND);
+
+    beginIter = m_trackStates.begin() + m_firstTrackStateIndices[iter->second];
+    endIter = m_trackStates.begin() + m_firstTrackStateIndices[iter->second + 1];
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool TrackProjectionIndex::IsIndexOf(const TrackList &trackList) const
+{
+    if (trackList.size() != m_tracks.size())
+        return false;
+
+    unsigned int trackIndex(0);
+
+    for (const Track *const pTrack : trackList)
+    {
+        if ((m_tracks[trackIndex] != pTrack) || !(m_calorimeterPositions[trackIndex] == pTrack->GetTrackStateAtCalorimeter().GetPosition()))
+            return false;
+
+        ++trackIndex;
+    }
+
+    return true;
+}
+
+} // namespace lc_content